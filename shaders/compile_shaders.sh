@@ -4,3 +4,27 @@ glslangValidator -V normalize.comp -o normalize.spv
 glslangValidator -V bialteral.comp -o bialteral.spv
 glslangValidator -V bialteral_linear.comp -o bialteral_linear.spv
 glslangValidator -V bialteral_layers.comp -o bialteral_layers.spv
+glslangValidator -V classify.comp -o classify.spv
+glslangValidator -V -DLINEAR classify.comp -o classify_linear.spv
+glslangValidator -V -DWEIGHTS classify.comp -o classify_weights.spv
+glslangValidator -V -DSPARSE nonlocal.comp -o nonlocal_sparse.spv
+glslangValidator -V -DSPARSE bialteral.comp -o bialteral_sparse.spv
+glslangValidator -V -DSPARSE bialteral_linear.comp -o bialteral_linear_sparse.spv
+glslangValidator -V -DSPARSE bialteral_layers.comp -o bialteral_layers_sparse.spv
+glslangValidator -V pyramid.comp -o pyramid.spv
+glslangValidator -V -DNLM pyramid.comp -o pyramid_nlm.spv
+glslangValidator -V temporal.comp -o temporal.spv
+glslangValidator -V -DSPATIAL temporal.comp -o temporal_spatial.spv
+glslangValidator -V atrous.comp -o atrous.spv
+glslangValidator -V guided.comp -o guided.spv
+glslangValidator -V firefly.comp -o firefly.spv
+glslangValidator -V -DLDR firefly.comp -o firefly_ldr.spv
+glslangValidator -V bialteral_ycbcr.comp -o bialteral_ycbcr.spv
+glslangValidator -V -DHALF bialteral.comp -o bialteral_half.spv
+glslangValidator -V -DHALF -DHALF_NATIVE bialteral.comp -o bialteral_half_native.spv
+glslangValidator -V -DHALF nonlocal.comp -o nonlocal_half.spv
+glslangValidator -V -DHALF -DHALF_NATIVE nonlocal.comp -o nonlocal_half_native.spv
+glslangValidator -V -DHALF normalize.comp -o normalize_half.spv
+glslangValidator -V -DHALF -DHALF_NATIVE normalize.comp -o normalize_half_native.spv
+glslangValidator -V metrics.comp -o metrics.spv
+glslangValidator -V --target-env vulkan1.1 -DSUBGROUP metrics.comp -o metrics_subgroup.spv
@@ -0,0 +1,255 @@
+#include "autotune.hpp"
+#include "synthetic.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <filesystem>
+
+static VkPhysicalDeviceProperties QueryDeviceProperties(int a_deviceId)
+{
+    std::vector<const char *> enabledLayers{};
+    VkInstance instance{ vk_utils::CreateInstance(false, enabledLayers) };
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(vk_utils::FindPhysicalDevice(instance, false, a_deviceId), &props);
+
+    vkDestroyInstance(instance, NULL);
+    return props;
+}
+
+AutoTuner::AutoTuner(const std::string a_cachePath)
+    : m_cachePath(a_cachePath)
+{
+    Load();
+}
+
+std::string AutoTuner::DefaultCachePath()
+{
+    namespace fs = std::filesystem;
+
+    if (const char* xdgCache = std::getenv("XDG_CACHE_HOME"))
+    {
+        return (fs::path(xdgCache) / "vulkan_denoice" / "autotune.txt").string();
+    }
+
+    if (const char* home = std::getenv("HOME"))
+    {
+        return (fs::path(home) / ".cache" / "vulkan_denoice" / "autotune.txt").string();
+    }
+
+    return "autotune.txt";
+}
+
+// vendor:device:driver:pipelineCacheUUID - a driver update invalidates the tuned values
+std::string AutoTuner::DeviceKey(int a_deviceId)
+{
+    return DeviceKey(QueryDeviceProperties(a_deviceId));
+}
+
+std::string AutoTuner::DeviceKey(const VkPhysicalDeviceProperties& a_props)
+{
+    std::stringstream key{};
+    key << std::hex << std::setfill('0')
+        << std::setw(4) << a_props.vendorID << ":"
+        << std::setw(4) << a_props.deviceID << ":"
+        << std::setw(8) << a_props.driverVersion << ":";
+
+    for (int i{}; i < VK_UUID_SIZE; ++i)
+    {
+        key << std::setw(2) << uint32_t(a_props.pipelineCacheUUID[i]);
+    }
+
+    return key.str();
+}
+
+std::string AutoTuner::FilterName(const Kernel& a_kernel)
+{
+    std::string name{ (a_kernel.nlmFilter) ? "nlm" : (a_kernel.atrousIterations > 0) ? "atrous" : (a_kernel.guidedRadius > 0) ? "guided"
+        : (a_kernel.useLayers) ? "bialteral_layers" : "bialteral" };
+
+    if (a_kernel.ycbcr)             name += "_ycbcr";
+    if (a_kernel.pyramidLevels > 1) name += "_pyramid";
+    if (a_kernel.sparse)            name += "_sparse";
+    if (a_kernel.half)              name += "_fp16";
+
+    return name;
+}
+
+// the modes of a_kernel on a_app, everything else off
+static void SetKernel(ComputeApplication& a_app, const AutoTuner::Kernel& a_kernel)
+{
+    a_app.SetSparseDispatch(a_kernel.sparse);
+    a_app.SetPyramidLevels(a_kernel.pyramidLevels);
+    a_app.SetAtrousIterations(a_kernel.atrousIterations);
+    a_app.SetGuidedFilter(a_kernel.guidedRadius);
+    a_app.SetYCbCr(a_kernel.ycbcr);
+    a_app.SetHalfPrecision(a_kernel.half);
+}
+
+bool AutoTuner::Lookup(const std::string& a_deviceKey, const std::string& a_filter, Entry& a_entry) const
+{
+    for (const Entry& entry : m_entries)
+    {
+        if (entry.deviceKey == a_deviceKey && entry.filter == a_filter)
+        {
+            a_entry = entry;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AutoTuner::Tune(int a_deviceId, int a_w, int a_h, int a_reps, const std::vector<Kernel>& a_kernels)
+{
+    const VkPhysicalDeviceProperties props{ QueryDeviceProperties(a_deviceId) };
+    const std::string deviceKey{ DeviceKey(props) };
+
+    const ComputeApplication::WorkgroupSize candidates[] =
+    {
+        {8, 8}, {16, 8}, {8, 16}, {16, 16}, {32, 4}, {32, 8}, {8, 32}, {64, 4}, {32, 16}, {32, 32}
+    };
+
+    struct TuneCase { Kernel kernel; bool linear; };
+    std::vector<TuneCase> cases =
+    {
+        { Kernel{},                false },
+        { Kernel{},                true  }, // only plain bialteral has a texel buffer version
+        { Kernel{ false, true },   false },
+        { Kernel{ true },          false },
+    };
+
+    for (const Kernel& kernel : a_kernels)
+    {
+        const bool known{ std::any_of(cases.begin(), cases.end(),
+                [&kernel](const TuneCase& c) { return FilterName(c.kernel) == FilterName(kernel); }) };
+
+        if (!known)
+        {
+            cases.push_back({ kernel, false });
+        }
+    }
+
+    ComputeApplication app{""};
+    app.SetSaveOutput(false);
+    app.SetVerbose(false);
+    app.SetDeviceId(a_deviceId);
+    app.SetSourceFrames(synthetic::MakeSourceFrames(a_w, a_h, 1, 0.05f, 1, false));
+
+    std::cout << "auto-tuning " << props.deviceName << " (" << deviceKey << ") on " << a_w << "x" << a_h << " image\n";
+
+    std::vector<Entry> winners{};
+
+    for (const TuneCase& tuneCase : cases)
+    {
+        Entry best{};
+        best.deviceKey = deviceKey;
+        best.filter    = FilterName(tuneCase.kernel);
+        best.timeMs    = -1.0;
+
+        for (const Entry& winner : winners)
+        {
+            if (winner.filter == best.filter) best = winner;
+        }
+
+        SetKernel(app, tuneCase.kernel);
+
+        for (const ComputeApplication::WorkgroupSize& size : candidates)
+        {
+            if (size.x > props.limits.maxComputeWorkGroupSize[0]
+                    || size.y > props.limits.maxComputeWorkGroupSize[1]
+                    || size.x * size.y > props.limits.maxComputeWorkGroupInvocations)
+            {
+                continue;
+            }
+
+            app.SetWorkgroupSize(size);
+
+            // one warm-up run, then the fastest of a_reps runs
+            double timeMs{-1.0};
+            for (int run{}; run <= a_reps; ++run)
+            {
+                app.RunOnGPU(tuneCase.kernel.nlmFilter, !tuneCase.linear, false, false, tuneCase.kernel.useLayers);
+
+                const double runMs{ double(app.GetExecTimeElapsed()) * 1e-6 };
+                if (run > 0 && (timeMs < 0.0 || runMs < timeMs)) timeMs = runMs;
+            }
+
+            std::cout << "\t" << std::setw(24) << std::left << best.filter
+                << std::setw(14) << ((tuneCase.linear) ? "texel_buffer" : "texture")
+                << size.x << "x" << size.y << "\t" << timeMs << " ms\n";
+
+            if (best.timeMs < 0.0 || timeMs < best.timeMs)
+            {
+                best.linear        = tuneCase.linear;
+                best.workgroupSize = size;
+                best.timeMs        = timeMs;
+            }
+        }
+
+        winners.erase(std::remove_if(winners.begin(), winners.end(),
+                    [&best](const Entry& e) { return e.filter == best.filter; }), winners.end());
+        winners.push_back(best);
+    }
+
+    for (const Entry& winner : winners)
+    {
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                    [&winner](const Entry& e) { return e.deviceKey == winner.deviceKey && e.filter == winner.filter; }), m_entries.end());
+        m_entries.push_back(winner);
+
+        std::cout << "\tbest " << winner.filter << ": " << ((winner.linear) ? "texel_buffer " : "texture ")
+            << winner.workgroupSize.x << "x" << winner.workgroupSize.y << "\n";
+    }
+
+    Save();
+}
+
+void AutoTuner::Load()
+{
+    m_entries.clear();
+
+    std::ifstream in{m_cachePath};
+    std::string line{};
+
+    while (std::getline(in, line))
+    {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::stringstream ss{line};
+        Entry entry{};
+        std::string dataPath{};
+
+        if (ss >> entry.deviceKey >> entry.filter >> dataPath >> entry.workgroupSize.x >> entry.workgroupSize.y >> entry.timeMs)
+        {
+            entry.linear = dataPath == "texel_buffer";
+            m_entries.push_back(entry);
+        }
+    }
+}
+
+void AutoTuner::Save() const
+{
+    namespace fs = std::filesystem;
+
+    const fs::path cachePath{m_cachePath};
+    if (cachePath.has_parent_path())
+    {
+        fs::create_directories(cachePath.parent_path());
+    }
+
+    std::ofstream out{m_cachePath};
+    if (!out) RUN_TIME_ERROR(("AutoTuner::Save, can't open " + m_cachePath).c_str());
+
+    out << "# vulkan_denoice auto-tuning cache: device_key filter data_path workgroup_x workgroup_y time_ms\n";
+
+    for (const Entry& entry : m_entries)
+    {
+        out << entry.deviceKey << " " << entry.filter << " " << ((entry.linear) ? "texel_buffer" : "texture") << " "
+            << entry.workgroupSize.x << " " << entry.workgroupSize.y << " " << entry.timeMs << "\n";
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef AUTOTUNE_HPP
+#define AUTOTUNE_HPP
+
+#include <string>
+#include <vector>
+
+#include "compute_application.hpp"
+
+// Microbenchmarks workgroup shapes and data paths of every GPU filter on a device.
+// Winners are cached per device and driver, so only the first run on new hardware pays for tuning.
+// Modes that run other shaders (a-trous, guided, YCbCr, pyramid, sparse, FP16) are tuned and looked up on their own,
+// their kernels differ in registers and shared memory from the plain filters.
+class AutoTuner
+{
+    public:
+
+        // filter and modes of a run, as far as they change the kernels (see FilterName)
+        struct Kernel {
+            bool nlmFilter{}, useLayers{}, sparse{}, ycbcr{}, half{};
+            int  pyramidLevels{}, atrousIterations{}, guidedRadius{};
+        };
+
+        struct Entry {
+            std::string deviceKey{};
+            std::string filter{};    // see FilterName
+            bool        linear{};    // texel buffer instead of texture
+            ComputeApplication::WorkgroupSize workgroupSize{};
+            double      timeMs{};
+        };
+
+    private:
+
+        std::string        m_cachePath{};
+        std::vector<Entry> m_entries{};
+
+    public:
+
+        AutoTuner(const std::string a_cachePath = DefaultCachePath());
+
+        static std::string DefaultCachePath();
+        static std::string DeviceKey(int a_deviceId);
+        static std::string DeviceKey(const VkPhysicalDeviceProperties& a_props);
+        // "bialteral", "bialteral_layers", "nlm", "atrous", "guided" with "_ycbcr", "_pyramid", "_sparse", "_fp16" suffixes
+        static std::string FilterName(const Kernel& a_kernel);
+
+        bool Lookup(const std::string& a_deviceKey, const std::string& a_filter, Entry& a_entry) const;
+        // tunes the plain filters and every kernel of a_kernels that is not one of them
+        void Tune(int a_deviceId, int a_w, int a_h, int a_reps, const std::vector<Kernel>& a_kernels = {});
+
+        void Load();
+        void Save() const;
+};
+
+#endif // AUTOTUNE_HPP
@@ -0,0 +1,432 @@
+#include <string>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+
+#include "compute_application.hpp"
+#include "timer.hpp"
+#include "synthetic.hpp"
+#include "quality_metrics.hpp"
+#include "json_string.hpp"
+
+// Every filter/data path combination that the engine supports. New paths go here.
+struct BenchCase
+{
+    const char* filter;
+    const char* dataPath;
+    bool        gpu;
+    bool        nlmFilter;
+    bool        nonlinear;
+    bool        multiframe;
+    bool        overlap;
+    bool        layers;
+    bool        sparse;
+    bool        pyramid;
+};
+
+static const BenchCase BENCH_CASES[] =
+{
+    // filter                    data path       gpu    nlm    nonlin multi  overlap layers sparse pyramid
+    { "bialteral",              "texture",      true,  false, true,  false, false, false, false, false },
+    { "bialteral",              "texel_buffer", true,  false, false, false, false, false, false, false },
+    { "bialteral_layers",       "texture",      true,  false, true,  false, false, true,  false, false },
+    { "nlm",                    "texture",      true,  true,  true,  false, false, false, false, false },
+    { "nlm_multiframe",         "texture",      true,  true,  true,  true,  false, false, false, false },
+    { "nlm_multiframe_overlap", "texture",      true,  true,  true,  true,  true,  false, false, false },
+    { "bialteral_sparse",       "texture",      true,  false, true,  false, false, false, true,  false },
+    { "nlm_sparse",             "texture",      true,  true,  true,  false, false, false, true,  false },
+    { "bialteral_pyramid",      "texture",      true,  false, true,  false, false, false, false, true  },
+    { "nlm_pyramid",            "texture",      true,  true,  true,  false, false, false, false, true  },
+    // RunOnCPU: BialteralFilterCPU with the TEXEL_WINDOW of bialteral.comp, so its MPix/s compares with the GPU rows
+    { "bialteral_cpu",          "host",         false, false, false, false, false, false, false, false },
+};
+
+struct BenchOptions
+{
+    std::vector<std::pair<int, int>>                  sizes{ {512, 512} };
+    std::vector<ComputeApplication::FilterParams>     params{ ComputeApplication::FilterParams{} };
+    std::vector<std::string>                          filters{};
+    std::vector<int>                                  cpuThreads{ 1, 8 };
+    int                                               frames{4};
+    int                                               warmup{1};
+    int                                               reps{5};
+    float                                             noise{0.05f};
+    float                                             converged{0.0f};
+    float                                             sparseThreshold{0.01f};
+    int                                               pyramidLevels{5};
+    int                                               tileSize{};
+    bool                                              zeroCopy{true};
+    unsigned                                          seed{1};
+    bool                                              ldr{};
+    std::string                                       csvPath{};
+    std::string                                       jsonPath{};
+};
+
+struct BenchResult
+{
+    std::string filter, dataPath;
+    int         w{}, h{}, threads{};
+    ComputeApplication::FilterParams params{};
+    double      meanMs{}, stddevMs{}, minMs{}, transferMs{};
+    double      mpixMean{}, mpixStddev{};
+    double      activeTiles{1.0}; // fraction of tiles filtered by sparse cases
+    QualityMetrics::Report quality{}; // last run against the clean synthetic image
+};
+
+static std::vector<std::string> SplitString(const std::string& a_str, char a_delimiter)
+{
+    std::vector<std::string> tokens{};
+    std::stringstream ss{a_str};
+    std::string token{};
+
+    while (std::getline(ss, token, a_delimiter))
+    {
+        if (!token.empty()) tokens.push_back(token);
+    }
+
+    return tokens;
+}
+
+static void PrintUsage(const char* a_exeName)
+{
+    std::cout << "usage: " << a_exeName << " [options]\n"
+        << "\t--size WxH[,WxH...]        synthetic image resolutions (default 512x512)\n"
+        << "\t--params s:c:h[,s:c:h...]  spatialSigma:colorSigma:filteringParameter sets\n"
+        << "\t--filters name[,name...]   subset of filters to run (default all)\n"
+        << "\t--cpu-threads n[,n...]     thread counts of the CPU filter (default 1,8)\n"
+        << "\t--frames N                 frames for multiframe filters (default 4)\n"
+        << "\t--warmup N                 untimed runs per case (default 1)\n"
+        << "\t--reps N                   timed runs per case (default 5)\n"
+        << "\t--noise sigma              gaussian noise of synthetic images (default 0.05)\n"
+        << "\t--converged F              noise-free fraction of synthetic images (default 0)\n"
+        << "\t--sparse-threshold T       noise level below which sparse cases skip a tile (default 0.01)\n"
+        << "\t--pyramid-levels N         levels of pyramid cases (default 5)\n"
+        << "\t--tile N                   run gpu cases out-of-core in NxN tiles (default 0 - whole image)\n"
+        << "\t--no-zero-copy             keep staging copies on unified memory devices\n"
+        << "\t--seed N                   noise seed (default 1)\n"
+        << "\t--ldr                      use RGBA8 instead of RGBA32F frames\n"
+        << "\t--csv path                 append results to a csv file\n"
+        << "\t--json path                write results to a json file\n";
+}
+
+static bool ParseOptions(int argc, char** argv, BenchOptions& a_opts)
+{
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string arg{argv[i]};
+        const bool hasValue{ i + 1 < argc };
+
+        if (arg == "--size" && hasValue)
+        {
+            a_opts.sizes.clear();
+            for (const std::string& size : SplitString(argv[++i], ','))
+            {
+                int w{}, h{};
+                if (sscanf(size.c_str(), "%dx%d", &w, &h) != 2 || w <= 0 || h <= 0) return false;
+                a_opts.sizes.push_back({w, h});
+            }
+        }
+        else if (arg == "--params" && hasValue)
+        {
+            a_opts.params.clear();
+            for (const std::string& set : SplitString(argv[++i], ','))
+            {
+                ComputeApplication::FilterParams params{};
+                if (sscanf(set.c_str(), "%f:%f:%f", &params.spatialSigma, &params.colorSigma, &params.filteringParameter) != 3) return false;
+                a_opts.params.push_back(params);
+            }
+        }
+        else if (arg == "--filters" && hasValue)     a_opts.filters = SplitString(argv[++i], ',');
+        else if (arg == "--cpu-threads" && hasValue)
+        {
+            a_opts.cpuThreads.clear();
+            for (const std::string& n : SplitString(argv[++i], ',')) a_opts.cpuThreads.push_back(atoi(n.c_str()));
+        }
+        else if (arg == "--frames" && hasValue)      a_opts.frames   = std::max(1, atoi(argv[++i]));
+        else if (arg == "--warmup" && hasValue)      a_opts.warmup   = std::max(0, atoi(argv[++i]));
+        else if (arg == "--reps" && hasValue)        a_opts.reps     = std::max(1, atoi(argv[++i]));
+        else if (arg == "--noise" && hasValue)       a_opts.noise    = float(atof(argv[++i]));
+        else if (arg == "--converged" && hasValue)   a_opts.converged = std::clamp(float(atof(argv[++i])), 0.0f, 1.0f);
+        else if (arg == "--sparse-threshold" && hasValue) a_opts.sparseThreshold = float(atof(argv[++i]));
+        else if (arg == "--pyramid-levels" && hasValue) a_opts.pyramidLevels = std::max(2, atoi(argv[++i]));
+        else if (arg == "--tile" && hasValue)        a_opts.tileSize = std::max(0, atoi(argv[++i]));
+        else if (arg == "--no-zero-copy")            a_opts.zeroCopy = false;
+        else if (arg == "--seed" && hasValue)        a_opts.seed     = unsigned(atoi(argv[++i]));
+        else if (arg == "--ldr")                     a_opts.ldr      = true;
+        else if (arg == "--csv" && hasValue)         a_opts.csvPath  = argv[++i];
+        else if (arg == "--json" && hasValue)        a_opts.jsonPath = argv[++i];
+        else return false;
+    }
+
+    return true;
+}
+
+static void ComputeStats(const std::vector<double>& a_timesMs, int a_w, int a_h, BenchResult& a_result)
+{
+    const double n{ double(a_timesMs.size()) };
+    double sum{}, sumMpix{};
+    a_result.minMs = a_timesMs[0];
+
+    std::vector<double> mpix(a_timesMs.size());
+    for (size_t i{}; i < a_timesMs.size(); ++i)
+    {
+        mpix[i] = double(a_w) * double(a_h) / (a_timesMs[i] * 1e3);
+        sum     += a_timesMs[i];
+        sumMpix += mpix[i];
+        a_result.minMs = std::min(a_result.minMs, a_timesMs[i]);
+    }
+
+    a_result.meanMs   = sum / n;
+    a_result.mpixMean = sumMpix / n;
+
+    double var{}, varMpix{};
+    for (size_t i{}; i < a_timesMs.size(); ++i)
+    {
+        var     += (a_timesMs[i] - a_result.meanMs) * (a_timesMs[i] - a_result.meanMs);
+        varMpix += (mpix[i] - a_result.mpixMean) * (mpix[i] - a_result.mpixMean);
+    }
+
+    a_result.stddevMs   = (n > 1) ? std::sqrt(var / (n - 1)) : 0.0;
+    a_result.mpixStddev = (n > 1) ? std::sqrt(varMpix / (n - 1)) : 0.0;
+}
+
+// a_metrics measures gpu cases (made on the first one), cpu cases are measured on the host with their threads
+static BenchResult RunCase(ComputeApplication& a_app, const BenchCase& a_case, int a_threads, const BenchOptions& a_opts,
+        int a_w, int a_h, const ComputeApplication::FilterParams& a_params, std::unique_ptr<QualityMetrics>& a_metrics)
+{
+    a_app.SetFilterParams(a_params);
+    a_app.SetSparseDispatch(a_case.sparse, a_opts.sparseThreshold);
+    a_app.SetPyramidLevels((a_case.pyramid) ? a_opts.pyramidLevels : 0);
+    a_app.SetTileSize(a_opts.tileSize);
+    a_app.SetZeroCopy(a_opts.zeroCopy);
+
+    std::vector<double> timesMs{};
+    double transferMs{};
+    std::vector<ComputeApplication::Pixel> output(size_t(a_w) * a_h);
+
+    for (int run{}; run < a_opts.warmup + a_opts.reps; ++run)
+    {
+        double timeMs{};
+
+        // only the last run copies its result out
+        a_app.SetResultOutput((run + 1 == a_opts.warmup + a_opts.reps) ? output.data() : nullptr);
+
+        if (a_case.gpu)
+        {
+            a_app.RunOnGPU(a_case.nlmFilter, a_case.nonlinear, a_case.multiframe, a_case.overlap, a_case.layers);
+            timeMs      = double(a_app.GetExecTimeElapsed()) * 1e-6;
+            transferMs += (run >= a_opts.warmup) ? double(a_app.GetTranferTimeElapsed()) * 1e-6 : 0.0;
+        }
+        else
+        {
+            Timer timer{};
+            a_app.RunOnCPU("", a_threads);
+            timeMs = timer.elapsed() * 1e3;
+        }
+
+        if (run >= a_opts.warmup) timesMs.push_back(timeMs);
+    }
+
+    BenchResult result{};
+    result.filter     = a_case.filter;
+    result.dataPath   = a_case.dataPath;
+    result.w          = a_w;
+    result.h          = a_h;
+    result.threads    = a_threads;
+    result.params     = a_params;
+    result.transferMs = transferMs / a_opts.reps;
+    if (a_case.sparse) result.activeTiles = double(a_app.GetActiveTiles()) / double(std::max(1u, a_app.GetTotalTiles()));
+    ComputeStats(timesMs, a_w, a_h, result);
+
+    a_app.SetResultOutput(nullptr);
+
+    const std::vector<ComputeApplication::Pixel> clean{ synthetic::MakeCleanImage(a_w, a_h) };
+    if (a_case.gpu)
+    {
+        if (!a_metrics) a_metrics = std::make_unique<QualityMetrics>();
+        result.quality = a_metrics->Compute(output.data(), clean.data(), a_w, a_h, !a_opts.ldr);
+    }
+    else
+    {
+        result.quality = QualityMetrics::ComputeCPU(output.data(), clean.data(), a_w, a_h, !a_opts.ldr, a_threads);
+    }
+
+    return result;
+}
+
+static std::string TimeStampUTC()
+{
+    char buf[32]{};
+    const std::time_t now{ std::time(nullptr) };
+    std::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return buf;
+}
+
+// Quoted CSV field, inner quotes doubled (RFC 4180), so commas and quotes of vendor strings stay in one column
+static std::string CsvField(const std::string& a_value)
+{
+    std::string field{"\""};
+    for (const char c : a_value)
+    {
+        field += (c == '"') ? "\"\"" : std::string(1, c);
+    }
+    return field + "\"";
+}
+
+static void WriteCSV(const std::string& a_path, const std::string& a_timeStamp, const std::string& a_device,
+        const BenchOptions& a_opts, const std::vector<BenchResult>& a_results)
+{
+    const bool newFile{ !std::filesystem::exists(a_path) };
+    std::ofstream out{a_path, std::ios::app};
+    if (!out) throw std::runtime_error("can't open " + a_path);
+
+    if (newFile)
+    {
+        out << "timestamp,device,filter,data_path,width,height,threads,spatial_sigma,color_sigma,filtering_parameter,"
+            << "format,frames,warmup,reps,mean_ms,stddev_ms,min_ms,transfer_ms,mpix_s,mpix_s_stddev,active_tiles,psnr_db,ssim,noise\n";
+    }
+
+    for (const BenchResult& r : a_results)
+    {
+        out << a_timeStamp << "," << CsvField(a_device) << "," << r.filter << "," << r.dataPath << ","
+            << r.w << "," << r.h << "," << r.threads << ","
+            << r.params.spatialSigma << "," << r.params.colorSigma << "," << r.params.filteringParameter << ","
+            << ((a_opts.ldr) ? "rgba8" : "rgba32f") << "," << a_opts.frames << "," << a_opts.warmup << "," << a_opts.reps << ","
+            << r.meanMs << "," << r.stddevMs << "," << r.minMs << "," << r.transferMs << ","
+            << r.mpixMean << "," << r.mpixStddev << "," << r.activeTiles << ","
+            << r.quality.psnr << "," << r.quality.ssim << "," << r.quality.noise << "\n";
+    }
+}
+
+static void WriteJSON(const std::string& a_path, const std::string& a_timeStamp, const std::string& a_device,
+        const BenchOptions& a_opts, const std::vector<BenchResult>& a_results)
+{
+    std::ofstream out{a_path};
+    if (!out) throw std::runtime_error("can't open " + a_path);
+
+    out << "{\n"
+        << "  \"timestamp\": \"" << a_timeStamp << "\",\n"
+        << "  \"device\": " << JsonString(a_device) << ",\n"
+        << "  \"format\": \"" << ((a_opts.ldr) ? "rgba8" : "rgba32f") << "\",\n"
+        << "  \"frames\": " << a_opts.frames << ",\n"
+        << "  \"warmup\": " << a_opts.warmup << ",\n"
+        << "  \"reps\": " << a_opts.reps << ",\n"
+        << "  \"results\": [\n";
+
+    for (size_t i{}; i < a_results.size(); ++i)
+    {
+        const BenchResult& r{ a_results[i] };
+        out << "    { \"filter\": \"" << r.filter << "\", \"data_path\": \"" << r.dataPath << "\", "
+            << "\"width\": " << r.w << ", \"height\": " << r.h << ", \"threads\": " << r.threads << ", "
+            << "\"spatial_sigma\": " << r.params.spatialSigma << ", \"color_sigma\": " << r.params.colorSigma << ", "
+            << "\"filtering_parameter\": " << r.params.filteringParameter << ", "
+            << "\"mean_ms\": " << r.meanMs << ", \"stddev_ms\": " << r.stddevMs << ", \"min_ms\": " << r.minMs << ", "
+            << "\"transfer_ms\": " << r.transferMs << ", "
+            << "\"mpix_s\": " << r.mpixMean << ", \"mpix_s_stddev\": " << r.mpixStddev << ", "
+            << "\"active_tiles\": " << r.activeTiles << ", "
+            << "\"psnr_db\": " << r.quality.psnr << ", \"ssim\": " << r.quality.ssim << ", \"noise\": " << r.quality.noise << " }"
+            << ((i + 1 < a_results.size()) ? ",\n" : "\n");
+    }
+
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions opts{};
+
+    if (!ParseOptions(argc, argv, opts))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        // the engine logs every step, keep only the results table
+        ComputeApplication app{""};
+        app.SetSaveOutput(false);
+        app.SetVerbose(false);
+
+        std::unique_ptr<QualityMetrics> metrics{};
+
+        std::vector<BenchResult> results{};
+        std::string device{"cpu"};
+
+        std::cout << std::left
+            << std::setw(24) << "filter" << std::setw(14) << "data path" << std::setw(12) << "size"
+            << std::setw(8) << "threads" << std::setw(18) << "params"
+            << std::setw(22) << "time ms (stddev)" << std::setw(22) << "MPix/s (stddev)" << std::setw(10) << "PSNR dB"
+            << std::setw(8) << "SSIM" << "noise\n";
+
+        for (const std::pair<int, int>& size : opts.sizes)
+        {
+            app.SetSourceFrames(synthetic::MakeSourceFrames(size.first, size.second, opts.frames, opts.noise, opts.seed, opts.ldr,
+                        opts.converged));
+
+            for (const BenchCase& benchCase : BENCH_CASES)
+            {
+                if (!opts.filters.empty()
+                        && std::find(opts.filters.begin(), opts.filters.end(), benchCase.filter) == opts.filters.end())
+                {
+                    continue;
+                }
+
+                const std::vector<int> threads{ (benchCase.gpu) ? std::vector<int>{0} : opts.cpuThreads };
+
+                for (int numThreads : threads)
+                {
+                    for (const ComputeApplication::FilterParams& params : opts.params)
+                    {
+                        const BenchResult result{ RunCase(app, benchCase, numThreads, opts, size.first, size.second, params, metrics) };
+
+                        if (benchCase.gpu) device = app.GetDeviceName();
+
+                        std::stringstream sizeStr{}, paramsStr{}, timeStr{}, mpixStr{}, psnrStr{}, ssimStr{}, noiseStr{};
+                        sizeStr   << result.w << "x" << result.h;
+                        paramsStr << params.spatialSigma << ":" << params.colorSigma << ":" << params.filteringParameter;
+                        timeStr   << std::fixed << std::setprecision(3) << result.meanMs << " (" << result.stddevMs << ")";
+                        mpixStr   << std::fixed << std::setprecision(3) << result.mpixMean << " (" << result.mpixStddev << ")";
+                        psnrStr   << std::fixed << std::setprecision(2) << result.quality.psnr;
+                        ssimStr   << std::fixed << std::setprecision(4) << result.quality.ssim;
+                        noiseStr  << std::fixed << std::setprecision(4) << result.quality.noise;
+
+                        std::cout << std::setw(24) << result.filter << std::setw(14) << result.dataPath
+                            << std::setw(12) << sizeStr.str() << std::setw(8) << result.threads
+                            << std::setw(18) << paramsStr.str() << std::setw(22) << timeStr.str() << std::setw(22) << mpixStr.str()
+                            << std::setw(10) << psnrStr.str() << std::setw(8) << ssimStr.str() << noiseStr.str();
+
+                        if (benchCase.sparse)
+                        {
+                            std::cout << "  " << std::fixed << std::setprecision(1) << result.activeTiles * 100.0 << "% tiles" << std::defaultfloat;
+                        }
+                        std::cout << "\n";
+
+                        results.push_back(result);
+                    }
+                }
+            }
+        }
+
+        std::cout << "device: " << device << "\n";
+
+        const std::string timeStamp{ TimeStampUTC() };
+        if (!opts.csvPath.empty())  WriteCSV(opts.csvPath, timeStamp, device, opts, results);
+        if (!opts.jsonPath.empty()) WriteJSON(opts.jsonPath, timeStamp, device, opts, results);
+    }
+    catch (const std::runtime_error& e)
+    {
+        printf("%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,4507 @@
+#include "compute_application.hpp"
+
+#include <cstring>
+#include <cctype>
+#include <cassert>
+#include <stdexcept>
+#include <cmath>
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+
+#include "tinyexr/tinyexr.h"
+#include "lodepng/lodepng.h"
+#include "pixel_format.hpp"
+#include "timer.hpp"
+#include "telemetry.hpp"
+
+ComputeApplication::SharedDevice::~SharedDevice()
+{
+    if (enableValidationLayers && instance != VK_NULL_HANDLE)
+    {
+        auto func = (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(instance, "vkDestroyDebugReportCallbackEXT");
+        if (func != nullptr)
+        {
+            func(instance, debugReportCallback, NULL);
+        }
+    }
+
+    if (device != VK_NULL_HANDLE)
+    {
+        vkDestroyDevice(device, NULL);
+    }
+
+    if (instance != VK_NULL_HANDLE)
+    {
+        vkDestroyInstance(instance, NULL);
+    }
+}
+
+void ComputeApplication::SetSharedDevice(std::shared_ptr<SharedDevice> a_device)
+{
+    if (m_device != VK_NULL_HANDLE)
+    {
+        Cleanup();
+    }
+
+    m_externalDevice = a_device != nullptr;
+    m_sharedDevice   = std::move(a_device);
+
+    if (m_sharedDevice)
+    {
+        m_deviceId = m_sharedDevice->deviceId;
+    }
+}
+
+ComputeApplication::~ComputeApplication()
+{
+    if (m_device != VK_NULL_HANDLE)
+    {
+        Cleanup();
+    }
+}
+
+void ComputeApplication::GetImageFromGPU(VkDevice a_device, VkDeviceMemory a_stagingMem, int a_w, int a_h, unsigned char *a_imageData)
+{
+    void *mappedMemory = nullptr;
+    vkMapMemory(a_device, a_stagingMem, 0, a_w * a_h * sizeof(float) * 4, 0, &mappedMemory);
+    pixel_format::Rgba32FToRgba8((const float*)mappedMemory, a_imageData, size_t(a_w) * a_h);
+    vkUnmapMemory(a_device, a_stagingMem);
+}
+
+void ComputeApplication::GetImageFromGPU(VkDevice a_device, VkDeviceMemory a_stagingMem, int a_w, int a_h, Pixel *a_imageData, bool a_half)
+{
+    void *mappedMemory = nullptr;
+
+    vkMapMemory(a_device, a_stagingMem, 0, a_w * a_h * ((a_half) ? HALF_PIXEL_SIZE : sizeof(Pixel)), 0, &mappedMemory);
+
+    if (a_half)
+    {
+        pixel_format::Rgba16FToRgba32F((const uint16_t*)mappedMemory, (float*)a_imageData, size_t(a_w) * a_h);
+    }
+    else
+    {
+        pixel_format::Copy(mappedMemory, a_imageData, sizeof(Pixel) * a_w * a_h);
+    }
+
+    vkUnmapMemory(a_device, a_stagingMem);
+}
+
+void ComputeApplication::PutImageToGPU(VkDevice a_device, VkDeviceMemory a_dynamicMem, int a_w, int a_h, const uint32_t *a_imageData)
+{
+    void *mappedMemory = nullptr;
+    vkMapMemory(a_device, a_dynamicMem, 0, a_w * a_h * sizeof(float) * 4, 0, &mappedMemory);
+    pixel_format::Rgba8ToRgba32F((const uint8_t*)a_imageData, (float*)mappedMemory, size_t(a_w) * a_h);
+    vkUnmapMemory(a_device, a_dynamicMem);
+}
+
+void ComputeApplication::LoadImages(int& a_w, int& a_h, const std::vector<std::string> a_fileNames, std::vector<std::vector<unsigned int>>& a_imageData,
+        std::vector<std::vector<Pixel>>& a_imageDataHDR, const bool a_isHDR)
+{
+    for (std::string fileName : a_fileNames)
+    {
+        if (a_isHDR)
+        {
+            float* rgba{nullptr};
+            const char* err = nullptr;
+
+            int ret = LoadEXR(&rgba, &a_w, &a_h, fileName.c_str(), &err);
+
+            if (ret != TINYEXR_SUCCESS)
+            {
+                if (err)
+                {
+                    fprintf(stderr, "ERR : %s\n", err);
+                    FreeEXRErrorMessage(err); // release memory of error message.
+                }
+            }
+            else
+            {
+                std::vector<Pixel> image(a_w * a_h);
+                pixel_format::Copy(rgba, image.data(), sizeof(Pixel) * a_w * a_h);
+
+                a_imageDataHDR.push_back(std::move(image));
+
+                free(rgba);
+            }
+        }
+        else
+        {
+            std::vector<unsigned char> rgba(0);
+            const char* err = nullptr;
+
+            unsigned w, h;
+            unsigned ret = lodepng::decode(rgba, w, h, fileName.c_str());
+            a_w = (int)w;
+            a_h = (int)h;
+
+            if (ret)
+            {
+                throw(std::runtime_error(lodepng_error_text(ret)));
+            }
+            else
+            {
+                // packed pixels are the RGBA8 bytes as they are (pixel_format.hpp)
+                std::vector<unsigned int> image(w * h);
+                pixel_format::Copy(rgba.data(), image.data(), sizeof(unsigned int) * w * h);
+
+                a_imageData.push_back(std::move(image));
+            }
+        }
+    }
+}
+
+VKAPI_ATTR VkBool32 VKAPI_CALL ComputeApplication::debugReportCallbackFn(
+        VkDebugReportFlagsEXT                       flags,
+        VkDebugReportObjectTypeEXT                  objectType,
+        uint64_t                                    object,
+        size_t                                      location,
+        int32_t                                     messageCode,
+        const char*                                 pLayerPrefix,
+        const char*                                 pMessage,
+        void*                                       pUserData)
+{
+    printf("Debug Report: %s: %s\n", pLayerPrefix, pMessage);
+    return VK_FALSE;
+}
+
+void ComputeApplication::CreateStagingBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
+        VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory)
+{
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size        = a_bufferSize;
+
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, a_pBuffer));
+
+    //----
+
+    VkMemoryRequirements memoryRequirements{};
+    vkGetBufferMemoryRequirements(a_device, (*a_pBuffer), &memoryRequirements);
+
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = memoryRequirements.size;
+    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(
+            memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            a_physDevice);
+
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, a_pBufferMemory));
+
+    VK_CHECK_RESULT(vkBindBufferMemory(a_device, (*a_pBuffer), (*a_pBufferMemory), 0));
+}
+
+void ComputeApplication::CreateDynamicBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
+        VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory)
+{
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size        = a_bufferSize;
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, a_pBuffer));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(a_device, (*a_pBuffer), &memoryRequirements);
+
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = memoryRequirements.size;
+    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(
+            memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+            a_physDevice);
+
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, a_pBufferMemory));
+
+    VK_CHECK_RESULT(vkBindBufferMemory(a_device, (*a_pBuffer), (*a_pBufferMemory), 0));
+}
+
+void ComputeApplication::CreateTexelBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
+        VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory, bool a_deviceLocal)
+{
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size        = a_bufferSize;
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, a_pBuffer));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(a_device, (*a_pBuffer), &memoryRequirements);
+
+    // This texel buffer is coherent and mappable (and device local on unified memory)
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = memoryRequirements.size;
+    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(
+            memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+            | ((a_deviceLocal) ? VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) : 0),
+            a_physDevice);
+
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, a_pBufferMemory));
+
+    VK_CHECK_RESULT(vkBindBufferMemory(a_device, (*a_pBuffer), (*a_pBufferMemory), 0));
+}
+
+void ComputeApplication::CreateTexelBufferView(VkDevice a_device, const size_t a_bufferSize, VkBuffer a_buffer,
+        VkBufferView *a_pBufferView, bool a_isHDR)
+{
+    VkBufferViewCreateInfo bufferViewCreateInfo{};
+    bufferViewCreateInfo.sType   = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
+    bufferViewCreateInfo.pNext   = nullptr;
+    bufferViewCreateInfo.flags   = 0;
+    bufferViewCreateInfo.buffer  = a_buffer;
+    bufferViewCreateInfo.format  = (a_isHDR) ? VK_FORMAT_R32G32B32A32_SFLOAT : VK_FORMAT_R8G8B8A8_UNORM;
+    bufferViewCreateInfo.offset  = 0;
+    bufferViewCreateInfo.range   = a_bufferSize;
+
+    VK_CHECK_RESULT(vkCreateBufferView(a_device, &bufferViewCreateInfo, NULL, a_pBufferView));
+}
+
+void ComputeApplication::CreateWriteOnlyBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
+        VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory, bool a_hostVisible)
+{
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size        = a_bufferSize;
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, a_pBuffer));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(a_device, (*a_pBuffer), &memoryRequirements);
+
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = memoryRequirements.size;
+    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(
+            memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            | ((a_hostVisible) ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : 0),
+            a_physDevice);
+
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, a_pBufferMemory));
+
+    VK_CHECK_RESULT(vkBindBufferMemory(a_device, (*a_pBuffer), (*a_pBufferMemory), 0));
+}
+
+bool ComputeApplication::HasUnifiedMemory(VkDevice a_device, VkPhysicalDevice a_physDevice)
+{
+    VkPhysicalDeviceProperties deviceProps{};
+    vkGetPhysicalDeviceProperties(a_physDevice, &deviceProps);
+
+    if (deviceProps.deviceType != VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU && deviceProps.deviceType != VK_PHYSICAL_DEVICE_TYPE_CPU)
+    {
+        return false;
+    }
+
+    const VkMemoryPropertyFlags unified{ VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+        | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+
+    // memory types depend only on the usage, so small probes of the texel, output and guide buffers tell what the real
+    // ones can be allocated from
+    const VkBufferUsageFlags usages[] =
+    {
+        VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+    };
+
+    for (const VkBufferUsageFlags usage : usages)
+    {
+        VkBufferCreateInfo bufferCreateInfo{};
+        bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCreateInfo.size        = 256;
+        bufferCreateInfo.usage       = usage;
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        VkBuffer probe{};
+        VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, &probe));
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetBufferMemoryRequirements(a_device, probe, &memoryRequirements);
+        vkDestroyBuffer(a_device, probe, NULL);
+
+        if (vk_utils::FindMemoryType(memoryRequirements.memoryTypeBits, unified, a_physDevice) == uint32_t(-1))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ComputeApplication::HasHalfTextures(VkPhysicalDevice a_physDevice)
+{
+    VkFormatProperties formatProps{};
+    vkGetPhysicalDeviceFormatProperties(a_physDevice, VK_FORMAT_R16G16B16A16_SFLOAT, &formatProps);
+
+    const VkFormatFeatureFlags needed{ VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT };
+    return (formatProps.optimalTilingFeatures & needed) == needed;
+}
+
+VkDeviceSize ComputeApplication::HostPointerAlignment(VkPhysicalDevice a_physDevice)
+{
+    VkPhysicalDeviceExternalMemoryHostPropertiesEXT hostProps{};
+    hostProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTERNAL_MEMORY_HOST_PROPERTIES_EXT;
+
+    VkPhysicalDeviceProperties2 deviceProps{};
+    deviceProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    deviceProps.pNext = &hostProps;
+
+    vkGetPhysicalDeviceProperties2(a_physDevice, &deviceProps);
+
+    return hostProps.minImportedHostPointerAlignment;
+}
+
+bool ComputeApplication::CreateImportedHostBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, void* a_hostPtr, size_t a_size, size_t a_capacity,
+        VkDeviceSize a_alignment, VkBufferUsageFlags a_usage, VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory)
+{
+    if (a_alignment == 0 || a_hostPtr == nullptr || size_t(a_hostPtr) % a_alignment != 0)
+    {
+        return false;
+    }
+
+    const VkDeviceSize importSize{ (a_size + a_alignment - 1) / a_alignment * a_alignment };
+    if (importSize > a_capacity)
+    {
+        return false;
+    }
+
+    auto getHostPointerProperties = (PFN_vkGetMemoryHostPointerPropertiesEXT)vkGetDeviceProcAddr(a_device, "vkGetMemoryHostPointerPropertiesEXT");
+
+    VkMemoryHostPointerPropertiesEXT hostPointerProps{};
+    hostPointerProps.sType = VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT;
+
+    if (getHostPointerProperties == nullptr || getHostPointerProperties(a_device,
+                VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT, a_hostPtr, &hostPointerProps) != VK_SUCCESS)
+    {
+        return false;
+    }
+
+    VkExternalMemoryBufferCreateInfo externalCreateInfo{};
+    externalCreateInfo.sType       = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO;
+    externalCreateInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.pNext       = &externalCreateInfo;
+    bufferCreateInfo.size        = importSize;
+    bufferCreateInfo.usage       = a_usage;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, a_pBuffer));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(a_device, (*a_pBuffer), &memoryRequirements);
+
+    // the other side reads the memory without vkInvalidateMappedMemoryRanges
+    const uint32_t memoryTypeIndex{ vk_utils::FindMemoryType(
+            memoryRequirements.memoryTypeBits & hostPointerProps.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            a_physDevice) };
+
+    if (memoryTypeIndex == uint32_t(-1) || memoryRequirements.size > importSize)
+    {
+        vkDestroyBuffer(a_device, (*a_pBuffer), NULL);
+        (*a_pBuffer) = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkImportMemoryHostPointerInfoEXT importInfo{};
+    importInfo.sType        = VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT;
+    importInfo.handleType   = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    importInfo.pHostPointer = a_hostPtr;
+
+    VkMemoryAllocateInfo allocateInfo{};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext           = &importInfo;
+    allocateInfo.allocationSize  = importSize;
+    allocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, a_pBufferMemory));
+
+    VK_CHECK_RESULT(vkBindBufferMemory(a_device, (*a_pBuffer), (*a_pBufferMemory), 0));
+
+    return true;
+}
+
+void ComputeApplication::RecordTransferToHost(VkCommandBuffer a_cmdBuff, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, size_t a_bufferSize,
+        VkDeviceSize a_stagingOffset)
+{
+    const bool zeroCopy{ a_bufferStaging == VK_NULL_HANDLE };
+
+    VkBufferMemoryBarrier bufBarr{};
+    bufBarr.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufBarr.pNext = nullptr;
+    bufBarr.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufBarr.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufBarr.size                = VK_WHOLE_SIZE;
+    bufBarr.offset              = 0;
+    bufBarr.buffer              = a_bufferGPU;
+    bufBarr.srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+    bufBarr.dstAccessMask       = (zeroCopy) ? VK_ACCESS_HOST_READ_BIT : VK_ACCESS_TRANSFER_READ_BIT;
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            (zeroCopy) ? VK_PIPELINE_STAGE_HOST_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            1, &bufBarr,
+            0, nullptr);
+
+    if (zeroCopy)
+    {
+        return;
+    }
+
+    VkBufferCopy copyInfo{};
+    copyInfo.dstOffset = a_stagingOffset;
+    copyInfo.srcOffset = 0;
+    copyInfo.size      = a_bufferSize;
+
+    vkCmdCopyBuffer(a_cmdBuff, a_bufferGPU, a_bufferStaging, 1, &copyInfo);
+}
+
+void ComputeApplication::CreateWeightBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, size_t a_bufferSize,
+        VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory)
+{
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size        = a_bufferSize;
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT; // sweep mode clears it on the GPU
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, a_pBuffer));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(a_device, (*a_pBuffer), &memoryRequirements);
+
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = memoryRequirements.size;
+    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(
+            memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            a_physDevice);
+
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, a_pBufferMemory));
+
+    VK_CHECK_RESULT(vkBindBufferMemory(a_device, (*a_pBuffer), (*a_pBufferMemory), 0));
+}
+
+void ComputeApplication::CreateTileBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, size_t a_bufferSize,
+        VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory)
+{
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size        = a_bufferSize;
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+        | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, a_pBuffer));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(a_device, (*a_pBuffer), &memoryRequirements);
+
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = memoryRequirements.size;
+    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(
+            memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+            | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            a_physDevice);
+
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, a_pBufferMemory));
+
+    VK_CHECK_RESULT(vkBindBufferMemory(a_device, (*a_pBuffer), (*a_pBufferMemory), 0));
+}
+
+void ComputeApplication::CreateGuideBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, size_t a_bufferSize,
+        VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory, bool a_hostVisible)
+{
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size        = a_bufferSize;
+    bufferCreateInfo.usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VK_CHECK_RESULT(vkCreateBuffer(a_device, &bufferCreateInfo, NULL, a_pBuffer));
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(a_device, (*a_pBuffer), &memoryRequirements);
+
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.allocationSize  = memoryRequirements.size;
+    allocateInfo.memoryTypeIndex = vk_utils::FindMemoryType(
+            memoryRequirements.memoryTypeBits,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+            | ((a_hostVisible) ? VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT : 0),
+            a_physDevice);
+
+    VK_CHECK_RESULT(vkAllocateMemory(a_device, &allocateInfo, NULL, a_pBufferMemory));
+
+    VK_CHECK_RESULT(vkBindBufferMemory(a_device, (*a_pBuffer), (*a_pBufferMemory), 0));
+}
+
+std::vector<ComputeApplication::PyramidLevel> ComputeApplication::PyramidLevels(int a_w, int a_h, int a_levels)
+{
+    std::vector<PyramidLevel> levels{};
+    int offset{};
+
+    for (int k{}; k < a_levels && (k == 0 || a_w > 1 || a_h > 1); ++k)
+    {
+        levels.push_back(PyramidLevel{a_w, a_h, offset});
+        offset += a_w * a_h;
+        a_w = std::max(1, (a_w + 1) / 2);
+        a_h = std::max(1, (a_h + 1) / 2);
+    }
+
+    return levels;
+}
+
+int ComputeApplication::TileApron(bool a_nlmFilter, int a_pyramidLevels, int a_atrousIterations, int a_guidedRadius, bool a_ycbcr)
+{
+    if (a_ycbcr)
+    {
+        // CHROMA_WINDOW of bialteral_ycbcr.comp in half resolution texels, the 2x2 box before and the upsample after
+        return 2 * 10 + 2 + 2;
+    }
+
+    if (a_guidedRadius > 0)
+    {
+        // box of the coefficients over boxes of the statistics
+        return 2 * a_guidedRadius;
+    }
+
+    if (a_atrousIterations > 0)
+    {
+        // 2 taps of atrous.comp with the step 1, 2, 4, ...
+        return 2 * ((1 << a_atrousIterations) - 1);
+    }
+
+    if (a_pyramidLevels > 1)
+    {
+        // kernel of pyramid.comp (RADIUS or WINDOW + PATCH_WINDOW) + downsample + upsample on every level
+        return ((a_nlmFilter) ? 3 + 1 + 2 : 2 + 2) << (a_pyramidLevels - 1);
+    }
+
+    return (a_nlmFilter) ? 7 + 3 : 20; // nonlocal.comp WINDOW + PATCH_WINDOW, bialteral TEXEL_WINDOW
+}
+
+size_t ComputeApplication::GuideBufferSize(int a_w, int a_h, int a_layers)
+{
+    return (1 + MAX_GUIDE_LAYERS) * sizeof(uint32_t) + size_t(a_layers) * a_w * a_h * sizeof(uint32_t);
+}
+
+size_t ComputeApplication::YCbCrScratchSize(int a_w, int a_h)
+{
+    const size_t halfTexels{ size_t((a_w + 1) / 2) * ((a_h + 1) / 2) };
+    return sizeof(float) * (2 * size_t(a_w) * a_h + 6 * halfTexels);
+}
+
+size_t ComputeApplication::EstimateDeviceMemory(int a_w, int a_h, bool a_isHDR, bool a_nlmFilter, int a_guideLayers, bool a_overlap,
+        int a_pyramidLevels, int a_tileSize, int a_atrousIterations, int a_guidedRadius)
+{
+    const bool pyramid{ a_pyramidLevels > 1 };
+    const bool tiled{ a_tileSize > 0 && (a_tileSize < a_w || a_tileSize < a_h) };
+    const int  tileAlign{ (pyramid) ? (1 << (a_pyramidLevels - 1)) : 1 };
+    const int  tileSize{ (a_tileSize + tileAlign - 1) / tileAlign * tileAlign };
+    const int  apron{ (tiled) ? TileApron(a_nlmFilter, (pyramid) ? a_pyramidLevels : 0, a_atrousIterations, a_guidedRadius) : 0 };
+    const int  gw{ ((tiled) ? std::min(tileSize, a_w) : a_w) + 2 * apron }, gh{ ((tiled) ? std::min(tileSize, a_h) : a_h) + 2 * apron };
+
+    const size_t texels{ size_t(gw) * gh };
+    const size_t texelSize{ (a_isHDR) ? sizeof(Pixel) : sizeof(uint32_t) };
+
+    size_t bytes{ 2 * texels * texelSize };        // target image (or texel buffer) and its upload buffer
+    bytes += 2 * texels * sizeof(Pixel);          // output and staging buffers
+
+    if (a_nlmFilter && !pyramid)
+    {
+        bytes += ((a_overlap) ? 2 : 1) * texels * texelSize;   // neighbour images
+        bytes += texels * (sizeof(Pixel) + 4 * sizeof(float)); // weights
+    }
+
+    if (a_guideLayers > 0 && !pyramid)
+    {
+        bytes += 2 * GuideBufferSize(gw, gh, a_guideLayers);  // guide buffer and its upload buffer
+    }
+
+    if (pyramid)
+    {
+        bytes += 2 * texels * sizeof(Pixel) * 4 / 3;  // G and F chains
+    }
+
+    if (a_atrousIterations > 0)
+    {
+        bytes += 2 * texels * sizeof(Pixel);          // ping-pong buffer
+    }
+
+    if (a_guidedRadius > 0)
+    {
+        bytes += 4 * texels * sizeof(Pixel);          // row and column prefix sums, 8 channels
+    }
+
+    return bytes;
+}
+
+ComputeApplication::SourceFrames ComputeApplication::CropFrames(const SourceFrames& a_frames, int a_x, int a_y, int a_w, int a_h)
+{
+    SourceFrames tile{};
+    tile.w     = a_w;
+    tile.h     = a_h;
+    tile.isHDR = a_frames.isHDR;
+
+    auto crop = [&](const auto& a_image)
+    {
+        typename std::decay_t<decltype(a_image)> result(a_w * a_h);
+
+        for (int y{}; y < a_h; ++y)
+        {
+            const int srcY{ std::clamp(a_y + y, 0, a_frames.h - 1) };
+
+            for (int x{}; x < a_w; ++x)
+            {
+                result[y * a_w + x] = a_image[srcY * a_frames.w + std::clamp(a_x + x, 0, a_frames.w - 1)];
+            }
+        }
+
+        return result;
+    };
+
+    for (const auto& frame : a_frames.imageData)    tile.imageData.push_back(crop(frame));
+    for (const auto& frame : a_frames.imageDataHDR) tile.imageDataHDR.push_back(crop(frame));
+    for (const auto& layer : a_frames.layerData)    tile.layerData.push_back(crop(layer));
+    tile.layerNames = a_frames.layerNames;
+
+    return tile;
+}
+
+void ComputeApplication::BialteralFilterCPU(const SourceFrames& a_frames, const FilterParams& a_params, int a_y0, int a_y1, int a_numThreads,
+        Pixel* a_result, bool a_progress)
+{
+    const int window{20}; // TEXEL_WINDOW
+    const int w{ a_frames.w }, h{ a_frames.h };
+    const int pw{ w + 2 * window }, ph{ a_y1 - a_y0 + 2 * window };
+
+    // padded float copy of the rows the window reaches, UNORM texels are read as the sampler does
+    std::vector<Pixel> padded(size_t(pw) * ph);
+    for (int y{}; y < ph; ++y)
+    {
+        const int srcY{ std::clamp(a_y0 - window + y, 0, h - 1) };
+        Pixel*    row{ &padded[size_t(y) * pw] };
+
+        if (a_frames.isHDR)
+        {
+            memcpy(row + window, &a_frames.imageDataHDR[0][size_t(srcY) * w], sizeof(Pixel) * w);
+        }
+        else
+        {
+            pixel_format::Rgba8ToRgba32F((const uint8_t*)&a_frames.imageData[0][size_t(srcY) * w], (float*)(row + window), w);
+        }
+
+        std::fill(row, row + window, row[window]);
+        std::fill(row + window + w, row + pw, row[window + w - 1]);
+    }
+
+    std::vector<float> spatialWeights((2 * window + 1) * (2 * window + 1));
+    for (int i{ -window }; i <= window; ++i)
+    {
+        for (int j{ -window }; j <= window; ++j)
+        {
+            const float spatialDistance{ sqrtf(float(i * i + j * j)) };
+            spatialWeights[(i + window) * (2 * window + 1) + j + window] = expf(-0.5f * powf(spatialDistance / a_params.spatialSigma, 2.0f));
+        }
+    }
+
+    telemetry::Progress progress{ "bialteral", size_t(a_y1 - a_y0), "rows", a_progress };
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(a_numThreads)
+    for (int y = a_y0; y < a_y1; ++y)
+    {
+        for (int x{}; x < w; ++x)
+        {
+            const Pixel* center{ &padded[(y - a_y0 + window) * pw + x + window] };
+            const Pixel  texColor{ *center };
+
+            float normWeight{};
+            Pixel weightColor{};
+
+            for (int i{ -window }; i <= window; ++i)
+            {
+                for (int j{ -window }; j <= window; ++j)
+                {
+                    // i runs along x, j along y as in the shader
+                    const Pixel curColor{ center[j * pw + i] };
+                    const float dr{ texColor.r - curColor.r }, dg{ texColor.g - curColor.g }, db{ texColor.b - curColor.b };
+                    const float colorDistance{ sqrtf(dr * dr + dg * dg + db * db) };
+                    const float colorWeight{ expf(-0.5f * powf(colorDistance / a_params.colorSigma, 2.0f)) };
+                    const float resultWeight{ spatialWeights[(i + window) * (2 * window + 1) + j + window] * colorWeight };
+
+                    weightColor.r += curColor.r * resultWeight;
+                    weightColor.g += curColor.g * resultWeight;
+                    weightColor.b += curColor.b * resultWeight;
+                    weightColor.a += curColor.a * resultWeight;
+                    normWeight    += resultWeight;
+                }
+            }
+
+            a_result[size_t(y - a_y0) * w + x] = Pixel{ weightColor.r / normWeight, weightColor.g / normWeight,
+                weightColor.b / normWeight, weightColor.a / normWeight };
+        }
+
+        progress.Advance();
+    }
+}
+
+void ComputeApplication::FireflyFilterCPU(std::vector<Pixel>& a_image, int a_w, int a_h, float a_threshold, bool a_median, int a_numThreads)
+{
+    constexpr int   bins{256};
+    constexpr int   radius{ FIREFLY_RADIUS };
+    constexpr int   window{ (2 * radius + 1) * (2 * radius + 1) };
+    constexpr float knee{0.25f};
+    constexpr float minSigma{0.02f}; // MIN_SIGMA of firefly.comp
+
+    const size_t pixels{ size_t(a_w) * a_h };
+    std::vector<float>   luminance(pixels);
+    std::vector<uint8_t> bin(pixels);
+
+    for (size_t i{}; i < pixels; ++i)
+    {
+        const float l{ std::max(0.2126f * a_image[i].r + 0.7152f * a_image[i].g + 0.0722f * a_image[i].b, 0.0f) };
+        luminance[i] = l;
+        bin[i]       = uint8_t(std::min(int(float(bins) * l / (l + knee)), bins - 1));
+    }
+
+    // edge pixels repeat, as in firefly.comp
+    auto clampX = [&](int a_x) { return std::clamp(a_x, 0, a_w - 1); };
+    auto clampY = [&](int a_y) { return std::clamp(a_y, 0, a_h - 1); };
+
+#pragma omp parallel num_threads(a_numThreads)
+    {
+        std::vector<uint16_t> columnHist(size_t(a_w) * bins);
+        std::vector<double>   columnSum(a_w), columnSumSq(a_w);
+        std::vector<uint16_t> hist(bins);
+
+        // adds (a_sign = 1) or removes (-1) pixel row a_y to the column states
+        auto addRow = [&](int a_y, int a_sign)
+        {
+            for (int x{}; x < a_w; ++x)
+            {
+                const size_t i{ size_t(a_y) * a_w + x };
+                columnHist[size_t(x) * bins + bin[i]] += uint16_t(a_sign);
+                columnSum[x]   += a_sign * double(luminance[i]);
+                columnSumSq[x] += a_sign * double(luminance[i]) * luminance[i];
+            }
+        };
+
+        auto addColumn = [&](int a_x, int a_sign)
+        {
+            const uint16_t* column{ &columnHist[size_t(a_x) * bins] };
+            for (int b{}; b < bins; ++b)
+            {
+                hist[b] += uint16_t(a_sign * column[b]);
+            }
+        };
+
+#pragma omp for schedule(static)
+        for (int band = 0; band < a_numThreads; ++band)
+        {
+            const int y0{ int(int64_t(a_h) * band / a_numThreads) };
+            const int y1{ int(int64_t(a_h) * (band + 1) / a_numThreads) };
+
+            if (y0 >= y1)
+            {
+                continue;
+            }
+
+            std::fill(columnHist.begin(), columnHist.end(), 0);
+            std::fill(columnSum.begin(), columnSum.end(), 0.0);
+            std::fill(columnSumSq.begin(), columnSumSq.end(), 0.0);
+
+            for (int j{ -radius }; j <= radius; ++j)
+            {
+                addRow(clampY(y0 + j), 1);
+            }
+
+            for (int y{ y0 }; y < y1; ++y)
+            {
+                if (y > y0)
+                {
+                    addRow(clampY(y - radius - 1), -1);
+                    addRow(clampY(y + radius), 1);
+                }
+
+                std::fill(hist.begin(), hist.end(), 0);
+                double sum{}, sumSq{};
+
+                for (int i{ -radius }; i <= radius; ++i)
+                {
+                    addColumn(clampX(i), 1);
+                    sum   += columnSum[clampX(i)];
+                    sumSq += columnSumSq[clampX(i)];
+                }
+
+                for (int x{}; x < a_w; ++x)
+                {
+                    if (x > 0)
+                    {
+                        addColumn(clampX(x - radius - 1), -1);
+                        addColumn(clampX(x + radius), 1);
+                        sum   += columnSum[clampX(x + radius)]   - columnSum[clampX(x - radius - 1)];
+                        sumSq += columnSumSq[clampX(x + radius)] - columnSumSq[clampX(x - radius - 1)];
+                    }
+
+                    // statistics of the neighbours only, the outlier itself would inflate them
+                    const size_t i{ size_t(y) * a_w + x };
+                    const double center{ luminance[i] };
+                    const double mean{ (sum - center) / double(window - 1) };
+                    const double sigma{ sqrt(std::max((sumSq - center * center) / double(window - 1) - mean * mean, 0.0)) };
+                    const double limit{ mean + a_threshold * std::max(sigma, double(minSigma)) };
+
+                    if (center <= limit)
+                    {
+                        continue;
+                    }
+
+                    double target{ limit };
+
+                    if (a_median)
+                    {
+                        int b{}, count{ hist[0] };
+                        while (count <= window / 2)
+                        {
+                            count += hist[++b];
+                        }
+
+                        // center of the bin back to luminance
+                        const double t{ (b + 0.5) / bins };
+                        target = std::min(knee * t / (1.0 - t), center);
+                    }
+
+                    const float scale{ float(target / center) };
+                    a_image[i].r *= scale;
+                    a_image[i].g *= scale;
+                    a_image[i].b *= scale;
+                }
+            }
+        }
+    }
+}
+
+void ComputeApplication::GuidedFilterCPU(const std::vector<Pixel>& a_input, const std::vector<float>& a_guide, int a_w, int a_h,
+        int a_radius, float a_epsilon, int a_numThreads, Pixel* a_result)
+{
+    const size_t pixels{ size_t(a_w) * a_h };
+    const int    columnChunk{64};
+    std::vector<float> rowSums(pixels);
+
+    // box mean of a plane in place, windows are clamped to the image and the mean uses the real count
+    auto boxMean = [&](std::vector<float>& a_plane)
+    {
+#pragma omp parallel for num_threads(a_numThreads)
+        for (int y = 0; y < a_h; ++y)
+        {
+            const float* src{ &a_plane[size_t(y) * a_w] };
+            float*       dst{ &rowSums[size_t(y) * a_w] };
+            double       sum{};
+
+            for (int x{}; x < std::min(a_radius, a_w); ++x) sum += src[x];
+
+            for (int x{}; x < a_w; ++x)
+            {
+                if (x + a_radius < a_w)      sum += src[x + a_radius];
+                if (x - a_radius - 1 >= 0)   sum -= src[x - a_radius - 1];
+                dst[x] = float(sum);
+            }
+        }
+
+        // columns in chunks, a row of running sums per chunk keeps the reads contiguous
+#pragma omp parallel for num_threads(a_numThreads)
+        for (int x0 = 0; x0 < a_w; x0 += columnChunk)
+        {
+            const int x1{ std::min(x0 + columnChunk, a_w) };
+            std::vector<double> sum(x1 - x0);
+
+            for (int y{}; y < std::min(a_radius, a_h); ++y)
+            {
+                for (int x{ x0 }; x < x1; ++x) sum[x - x0] += rowSums[size_t(y) * a_w + x];
+            }
+
+            for (int y{}; y < a_h; ++y)
+            {
+                const int countY{ std::min(y + a_radius, a_h - 1) - std::max(y - a_radius, 0) + 1 };
+
+                for (int x{ x0 }; x < x1; ++x)
+                {
+                    if (y + a_radius < a_h)    sum[x - x0] += rowSums[size_t(y + a_radius) * a_w + x];
+                    if (y - a_radius - 1 >= 0) sum[x - x0] -= rowSums[size_t(y - a_radius - 1) * a_w + x];
+
+                    const int countX{ std::min(x + a_radius, a_w - 1) - std::max(x - a_radius, 0) + 1 };
+                    a_plane[size_t(y) * a_w + x] = float(sum[x - x0] / double(countX * countY));
+                }
+            }
+        }
+    };
+
+    // I, I^2, p and I * p per channel
+    std::vector<float> meanI(a_guide), meanII(pixels);
+    std::vector<float> meanP[3], meanIP[3];
+    for (int c{}; c < 3; ++c)
+    {
+        meanP[c].resize(pixels);
+        meanIP[c].resize(pixels);
+    }
+
+    for (size_t i{}; i < pixels; ++i)
+    {
+        const float I{ a_guide[i] };
+        const float p[3]{ a_input[i].r, a_input[i].g, a_input[i].b };
+
+        meanII[i] = I * I;
+        for (int c{}; c < 3; ++c)
+        {
+            meanP[c][i]  = p[c];
+            meanIP[c][i] = I * p[c];
+        }
+    }
+
+    boxMean(meanI);
+    boxMean(meanII);
+    for (int c{}; c < 3; ++c)
+    {
+        boxMean(meanP[c]);
+        boxMean(meanIP[c]);
+    }
+
+    // a replaces the mean of I * p, b the mean of p
+    for (size_t i{}; i < pixels; ++i)
+    {
+        const float varI{ std::max(meanII[i] - meanI[i] * meanI[i], 0.0f) };
+
+        for (int c{}; c < 3; ++c)
+        {
+            const float a{ (meanIP[c][i] - meanI[i] * meanP[c][i]) / (varI + a_epsilon) };
+            meanIP[c][i] = a;
+            meanP[c][i] -= a * meanI[i];
+        }
+    }
+
+    for (int c{}; c < 3; ++c)
+    {
+        boxMean(meanIP[c]);
+        boxMean(meanP[c]);
+    }
+
+    for (size_t i{}; i < pixels; ++i)
+    {
+        const float I{ a_guide[i] };
+        a_result[i] = Pixel{ meanIP[0][i] * I + meanP[0][i], meanIP[1][i] * I + meanP[1][i], meanIP[2][i] * I + meanP[2][i],
+            a_input[i].a };
+    }
+}
+
+void ComputeApplication::DomainTransformCPU(const std::vector<Pixel>& a_input, int a_w, int a_h, float a_spatialSigma, float a_rangeSigma,
+        int a_iterations, int a_numThreads, Pixel* a_result)
+{
+    const size_t pixels{ size_t(a_w) * a_h };
+    const int    band{64};
+
+    // a_dst (a_h x a_w) = a_src (a_w x a_h) transposed, in cache sized blocks
+    auto transpose = [&](const std::vector<float>& a_src, std::vector<float>& a_dst, int a_srcW, int a_srcH)
+    {
+        const int block{32};
+#pragma omp parallel for num_threads(a_numThreads)
+        for (int y0 = 0; y0 < a_srcH; y0 += block)
+        {
+            for (int x0{}; x0 < a_srcW; x0 += block)
+            {
+                for (int y{ y0 }; y < std::min(y0 + block, a_srcH); ++y)
+                {
+                    for (int x{ x0 }; x < std::min(x0 + block, a_srcW); ++x)
+                    {
+                        a_dst[size_t(x) * a_srcH + y] = a_src[size_t(y) * a_srcW + x];
+                    }
+                }
+            }
+        }
+    };
+
+    // derivative of the domain transform between row y - 1 and row y: 1 + sigma_s / sigma_r * L1 color distance
+    auto derivative = [&](const std::vector<float>* a_planes, std::vector<float>& a_dt, int a_rowW, int a_rows)
+    {
+        const float ratio{ a_spatialSigma / a_rangeSigma };
+#pragma omp parallel for num_threads(a_numThreads)
+        for (int y = 1; y < a_rows; ++y)
+        {
+            const size_t row{ size_t(y) * a_rowW }, prev{ size_t(y - 1) * a_rowW };
+#pragma omp simd
+            for (int x = 0; x < a_rowW; ++x)
+            {
+                a_dt[row + x] = 1.0f + ratio * (fabsf(a_planes[0][row + x] - a_planes[0][prev + x])
+                        + fabsf(a_planes[1][row + x] - a_planes[1][prev + x]) + fabsf(a_planes[2][row + x] - a_planes[2][prev + x]));
+            }
+        }
+    };
+
+    // causal then anti-causal recursion down the columns: J[y] += a^dt[y] * (J[y - 1] - J[y])
+    auto recursivePass = [&](std::vector<float>* a_planes, const std::vector<float>& a_dt, int a_rowW, int a_rows, float a_feedback)
+    {
+        const float logFeedback{ logf(a_feedback) };
+#pragma omp parallel for num_threads(a_numThreads)
+        for (int x0 = 0; x0 < a_rowW; x0 += band)
+        {
+            const int x1{ std::min(x0 + band, a_rowW) };
+
+            for (int y{1}; y < a_rows; ++y)
+            {
+                const size_t row{ size_t(y) * a_rowW }, prev{ size_t(y - 1) * a_rowW };
+                for (int c{}; c < 3; ++c)
+                {
+                    float* J{ a_planes[c].data() };
+#pragma omp simd
+                    for (int x = x0; x < x1; ++x)
+                    {
+                        J[row + x] += expf(logFeedback * a_dt[row + x]) * (J[prev + x] - J[row + x]);
+                    }
+                }
+            }
+
+            for (int y{ a_rows - 2 }; y >= 0; --y)
+            {
+                const size_t row{ size_t(y) * a_rowW }, next{ size_t(y + 1) * a_rowW };
+                for (int c{}; c < 3; ++c)
+                {
+                    float* J{ a_planes[c].data() };
+#pragma omp simd
+                    for (int x = x0; x < x1; ++x)
+                    {
+                        J[row + x] += expf(logFeedback * a_dt[next + x]) * (J[next + x] - J[row + x]);
+                    }
+                }
+            }
+        }
+    };
+
+    std::vector<float> planes[3], transposed[3];
+    for (int c{}; c < 3; ++c)
+    {
+        planes[c].resize(pixels);
+        transposed[c].resize(pixels);
+    }
+
+    pixel_format::Rgba32FToPlanes((const float*)a_input.data(), planes[0].data(), planes[1].data(), planes[2].data(), nullptr, pixels);
+
+    // derivatives come from the input and stay fixed over the iterations
+    std::vector<float> dtVertical(pixels), dtHorizontal(pixels);
+    derivative(planes, dtVertical, a_w, a_h);
+    for (int c{}; c < 3; ++c) transpose(planes[c], transposed[c], a_w, a_h);
+    derivative(transposed, dtHorizontal, a_h, a_w);
+
+    for (int i{}; i < a_iterations; ++i)
+    {
+        // sigma of iteration i, the sum of the iterations has variance sigma_s^2
+        const float sigma{ a_spatialSigma * sqrtf(3.0f) * float(1 << (a_iterations - i - 1))
+            / sqrtf(float(std::pow(4.0, a_iterations) - 1.0)) };
+        const float feedback{ expf(-sqrtf(2.0f) / sigma) };
+
+        recursivePass(transposed, dtHorizontal, a_h, a_w, feedback);
+        for (int c{}; c < 3; ++c) transpose(transposed[c], planes[c], a_h, a_w);
+
+        recursivePass(planes, dtVertical, a_w, a_h, feedback);
+        if (i + 1 < a_iterations)
+        {
+            for (int c{}; c < 3; ++c) transpose(planes[c], transposed[c], a_w, a_h);
+        }
+    }
+
+    // alpha of the input goes through unfiltered (the transposed planes are free by now)
+    std::vector<float> alpha(pixels);
+    pixel_format::Rgba32FToPlanes((const float*)a_input.data(), transposed[0].data(), transposed[1].data(), transposed[2].data(),
+            alpha.data(), pixels);
+    pixel_format::PlanesToRgba32F(planes[0].data(), planes[1].data(), planes[2].data(), alpha.data(), (float*)a_result, pixels);
+}
+
+void ComputeApplication::CopyHostFrame(const HostFrame& a_frame, SourceFrames& a_frames)
+{
+    if (a_frame.isHDR)
+    {
+        const Pixel* pixels{ (const Pixel*)a_frame.input };
+        a_frames.imageDataHDR.push_back(std::vector<Pixel>(pixels, pixels + a_frame.w * a_frame.h));
+    }
+    else
+    {
+        const unsigned int* pixels{ (const unsigned int*)a_frame.input };
+        a_frames.imageData.push_back(std::vector<unsigned int>(pixels, pixels + a_frame.w * a_frame.h));
+    }
+}
+
+void ComputeApplication::CreateDescriptorSetLayoutPyramid(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout)
+{
+    VkDescriptorSetLayoutBinding descriptorSetLayoutBinding[3];
+
+    // Pyramid levels storage
+    descriptorSetLayoutBinding[0].binding            = 0;
+    descriptorSetLayoutBinding[0].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorSetLayoutBinding[0].descriptorCount    = 1;
+    descriptorSetLayoutBinding[0].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[0].pImmutableSamplers = nullptr;
+
+    // Compute shader output image storage
+    descriptorSetLayoutBinding[1].binding            = 1;
+    descriptorSetLayoutBinding[1].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorSetLayoutBinding[1].descriptorCount    = 1;
+    descriptorSetLayoutBinding[1].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[1].pImmutableSamplers = nullptr;
+
+    // Compute shader input image
+    descriptorSetLayoutBinding[2].binding            = 2;
+    descriptorSetLayoutBinding[2].descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorSetLayoutBinding[2].descriptorCount    = 1;
+    descriptorSetLayoutBinding[2].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[2].pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+    descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.bindingCount = 3;
+    descriptorSetLayoutCreateInfo.pBindings    = descriptorSetLayoutBinding;
+
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, NULL, a_pDSLayout));
+}
+
+void ComputeApplication::CreateDescriptorSetPyramid(VkDevice a_device, VkBuffer a_bufferPyramid, size_t a_bufferPyramidSize, VkBuffer a_bufferGPU,
+        size_t a_bufferSize, CustomVulkanTexture a_image, const VkDescriptorSetLayout *a_pDSLayout,
+        VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS)
+{
+    // 0: pyramid levels (W/R)
+    // 1: GPU buffer (W)
+    // 2: Texture (R)
+
+    VkDescriptorPoolSize descriptorPoolSize[2];
+    descriptorPoolSize[0].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize[0].descriptorCount = 2;
+    descriptorPoolSize[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorPoolSize[1].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets       = 1;
+    descriptorPoolCreateInfo.poolSizeCount = 2;
+    descriptorPoolCreateInfo.pPoolSizes    = descriptorPoolSize;
+
+    VK_CHECK_RESULT(vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, NULL, a_pDSPool));
+
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+    descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.descriptorPool     = (*a_pDSPool);
+    descriptorSetAllocateInfo.descriptorSetCount = 1;
+    descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, a_pDS));
+
+    VkDescriptorBufferInfo descriptorBufferInfo[2]{};
+    descriptorBufferInfo[0].buffer = a_bufferPyramid;
+    descriptorBufferInfo[0].offset = 0;
+    descriptorBufferInfo[0].range  = a_bufferPyramidSize;
+    descriptorBufferInfo[1].buffer = a_bufferGPU;
+    descriptorBufferInfo[1].offset = 0;
+    descriptorBufferInfo[1].range  = a_bufferSize;
+
+    VkDescriptorImageInfo descriptorImageInfo{};
+    descriptorImageInfo.sampler     = a_image.getSampler();
+    descriptorImageInfo.imageView   = a_image.getImageView();
+    descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkWriteDescriptorSet writeDescriptorSet[3]{};
+    for (uint32_t i{}; i < 3; ++i)
+    {
+        writeDescriptorSet[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDescriptorSet[i].dstSet          = *a_pDS;
+        writeDescriptorSet[i].dstBinding      = i;
+        writeDescriptorSet[i].descriptorCount = 1;
+    }
+
+    writeDescriptorSet[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet[0].pBufferInfo    = &descriptorBufferInfo[0];
+    writeDescriptorSet[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet[1].pBufferInfo    = &descriptorBufferInfo[1];
+    writeDescriptorSet[2].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writeDescriptorSet[2].pImageInfo     = &descriptorImageInfo;
+
+    vkUpdateDescriptorSets(a_device, 3, writeDescriptorSet, 0, NULL);
+}
+
+void ComputeApplication::CreateDescriptorSetLayoutBialteral(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout, bool a_linear)
+{
+    VkDescriptorSetLayoutBinding descriptorSetLayoutBinding[2];
+
+    // Compute shader output image storage
+    descriptorSetLayoutBinding[0].binding            = 0;
+    descriptorSetLayoutBinding[0].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorSetLayoutBinding[0].descriptorCount    = 1;
+    descriptorSetLayoutBinding[0].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[0].pImmutableSamplers = nullptr;
+
+    // Compute shader input image storage
+    descriptorSetLayoutBinding[1].binding            = 1;
+    descriptorSetLayoutBinding[1].descriptorType     = (a_linear) ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+        : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorSetLayoutBinding[1].descriptorCount    = 1;
+    descriptorSetLayoutBinding[1].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[1].pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+    descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.bindingCount = 2;
+    descriptorSetLayoutCreateInfo.pBindings    = descriptorSetLayoutBinding;
+
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, NULL, a_pDSLayout));
+}
+
+void ComputeApplication::CreateDescriptorSetLayoutNLM(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout, bool a_linear, bool a_buildImage)
+{
+    VkDescriptorSetLayoutBinding descriptorSetLayoutBinding[(a_buildImage)? 2 : 3];
+
+    // (O) Compute shader output image storage (or NLM weights buffer)
+    descriptorSetLayoutBinding[0].binding            = 0;
+    descriptorSetLayoutBinding[0].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorSetLayoutBinding[0].descriptorCount    = 1;
+    descriptorSetLayoutBinding[0].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[0].pImmutableSamplers = nullptr;
+
+    if (!a_buildImage)
+    {
+        // (I) Compute shader input target image storage
+        descriptorSetLayoutBinding[1].binding            = 1;
+        descriptorSetLayoutBinding[1].descriptorType     = (a_linear) ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+            : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorSetLayoutBinding[1].descriptorCount    = 1;
+        descriptorSetLayoutBinding[1].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+        descriptorSetLayoutBinding[1].pImmutableSamplers = nullptr;
+
+        // (I) Compute shader input neihbour image storage
+        descriptorSetLayoutBinding[2].binding            = 2;
+        descriptorSetLayoutBinding[2].descriptorType     = (a_linear) ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+            : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorSetLayoutBinding[2].descriptorCount    = 1;
+        descriptorSetLayoutBinding[2].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+        descriptorSetLayoutBinding[2].pImmutableSamplers = nullptr;
+    }
+    else
+    {
+        // (I) Compute shader NLM weights buffer
+        descriptorSetLayoutBinding[1].binding            = 1;
+        descriptorSetLayoutBinding[1].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorSetLayoutBinding[1].descriptorCount    = 1;
+        descriptorSetLayoutBinding[1].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+        descriptorSetLayoutBinding[1].pImmutableSamplers = nullptr;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+    descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.bindingCount = (a_buildImage) ? 2 : 3;
+    descriptorSetLayoutCreateInfo.pBindings    = descriptorSetLayoutBinding;
+
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, NULL, a_pDSLayout));
+}
+
+void ComputeApplication::CreateDescriptorSetNLM(VkDevice a_device, VkBuffer a_bufferNLM, size_t a_bufferSize, const VkDescriptorSetLayout *a_pDSLayout,
+        CustomVulkanTexture a_targetImage, CustomVulkanTexture a_neighbourImage,
+        VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS)
+{
+    // 0: NLM buffer (W/R)
+    // 1: Texture/texbuffer #1 (R)
+    // 2: Texture/texbuffer #2 (R)
+
+    VkDescriptorPoolSize descriptorPoolSize[3];
+    descriptorPoolSize[0].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize[0].descriptorCount = 1;
+    descriptorPoolSize[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorPoolSize[1].descriptorCount = 1;
+    descriptorPoolSize[2].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorPoolSize[2].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets       = 1;
+    descriptorPoolCreateInfo.poolSizeCount = 3;
+    descriptorPoolCreateInfo.pPoolSizes    = descriptorPoolSize;
+
+    VK_CHECK_RESULT(vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, NULL, a_pDSPool));
+
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+    descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.descriptorPool     = (*a_pDSPool);
+    descriptorSetAllocateInfo.descriptorSetCount = 1;
+    descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, a_pDS));
+
+    // OUTPUT NLM BUFFER
+    VkDescriptorBufferInfo descriptorBufferInfo{};
+    descriptorBufferInfo.buffer = a_bufferNLM;
+    descriptorBufferInfo.offset = 0;
+    descriptorBufferInfo.range  = a_bufferSize;
+    VkWriteDescriptorSet writeDescriptorSet{};
+    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet          = *a_pDS;
+    writeDescriptorSet.dstBinding      = 0;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo     = &descriptorBufferInfo;
+
+    vkUpdateDescriptorSets(a_device, 1, &writeDescriptorSet, 0, NULL);
+
+    // INPUT (two 2d tiled optimal images)
+
+    VkDescriptorImageInfo descriptorTargetImageInfo{};
+    descriptorTargetImageInfo.sampler     = a_targetImage.getSampler();
+    descriptorTargetImageInfo.imageView   = a_targetImage.getImageView();
+    descriptorTargetImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkWriteDescriptorSet writeDescriptorSet2{};
+    writeDescriptorSet2.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet2.dstSet          = *a_pDS;
+    writeDescriptorSet2.dstBinding      = 1;
+    writeDescriptorSet2.descriptorCount = 1;
+    writeDescriptorSet2.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writeDescriptorSet2.pImageInfo      = &descriptorTargetImageInfo;
+
+    VkDescriptorImageInfo descriptorNeighbourImageInfo{};
+    descriptorNeighbourImageInfo.sampler     = a_neighbourImage.getSampler();
+    descriptorNeighbourImageInfo.imageView   = a_neighbourImage.getImageView();
+    descriptorNeighbourImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkWriteDescriptorSet writeDescriptorSet3{};
+    writeDescriptorSet3.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet3.dstSet          = *a_pDS;
+    writeDescriptorSet3.dstBinding      = 2;
+    writeDescriptorSet3.descriptorCount = 1;
+    writeDescriptorSet3.descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writeDescriptorSet3.pImageInfo      = &descriptorNeighbourImageInfo;
+
+    vkUpdateDescriptorSets(a_device, 1, &writeDescriptorSet2, 0, NULL);
+    vkUpdateDescriptorSets(a_device, 1, &writeDescriptorSet3, 0, NULL);
+}
+
+void ComputeApplication::CreateDescriptorSetNLM2(VkDevice a_device, VkBuffer a_bufferGPU, size_t a_bufferSize, const VkDescriptorSetLayout *a_pDSLayout,
+        VkBuffer a_bufferNLM, size_t a_bufferNLMSize, VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS)
+{
+    // 0: GPU buffer (W)
+    // 1: NLM weights (R)
+
+    VkDescriptorPoolSize descriptorPoolSize[2];
+    descriptorPoolSize[0].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize[0].descriptorCount = 1;
+    descriptorPoolSize[1].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize[1].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets       = 1;
+    descriptorPoolCreateInfo.poolSizeCount = 2;
+    descriptorPoolCreateInfo.pPoolSizes    = descriptorPoolSize;
+
+    VK_CHECK_RESULT(vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, NULL, a_pDSPool));
+
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+    descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.descriptorPool     = (*a_pDSPool);
+    descriptorSetAllocateInfo.descriptorSetCount = 1;
+    descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, a_pDS));
+
+    // OUTPUT BUFFER [for resut image]
+    VkDescriptorBufferInfo descriptorBufferInfo{};
+    descriptorBufferInfo.buffer = a_bufferGPU;
+    descriptorBufferInfo.offset = 0;
+    descriptorBufferInfo.range  = a_bufferSize;
+
+    VkWriteDescriptorSet writeDescriptorSet{};
+    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet          = *a_pDS;
+    writeDescriptorSet.dstBinding      = 0;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo     = &descriptorBufferInfo;
+
+    vkUpdateDescriptorSets(a_device, 1, &writeDescriptorSet, 0, NULL);
+
+    // INPUT BUFFER [for NLM weights]
+    VkDescriptorBufferInfo descriptorBufferNLMInfo{};
+    descriptorBufferNLMInfo.buffer = a_bufferNLM;
+    descriptorBufferNLMInfo.offset = 0;
+    descriptorBufferNLMInfo.range  = a_bufferNLMSize;
+
+    VkWriteDescriptorSet writeDescriptorSet2{};
+    writeDescriptorSet2.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet2.dstSet          = *a_pDS;
+    writeDescriptorSet2.dstBinding      = 1;
+    writeDescriptorSet2.descriptorCount = 1;
+    writeDescriptorSet2.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet2.pBufferInfo     = &descriptorBufferNLMInfo;
+
+    vkUpdateDescriptorSets(a_device, 1, &writeDescriptorSet2, 0, NULL);
+}
+
+void ComputeApplication::CreateDescriptorSetBialteral(VkDevice a_device, VkBuffer a_buffer, size_t a_bufferSize, const VkDescriptorSetLayout *a_pDSLayout, CustomVulkanTexture a_image,
+        VkBuffer a_texelBuffer, VkBufferView *a_texelBufferView, VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS, bool a_linear)
+{
+    VkDescriptorPoolSize descriptorPoolSize[2];
+    descriptorPoolSize[0].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize[0].descriptorCount = 1;
+    descriptorPoolSize[1].type            = (a_linear) ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+        : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorPoolSize[1].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets       = 1;
+    descriptorPoolCreateInfo.poolSizeCount = 2;
+    descriptorPoolCreateInfo.pPoolSizes    = descriptorPoolSize;
+
+    VK_CHECK_RESULT(vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, NULL, a_pDSPool));
+
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+    descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.descriptorPool     = (*a_pDSPool);
+    descriptorSetAllocateInfo.descriptorSetCount = 1;
+    descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, a_pDS));
+
+    // OUTPUT
+    VkDescriptorBufferInfo descriptorBufferInfo{};
+    descriptorBufferInfo.buffer = a_buffer;
+    descriptorBufferInfo.offset = 0;
+    descriptorBufferInfo.range  = a_bufferSize;
+
+    VkWriteDescriptorSet writeDescriptorSet{};
+    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet          = *(a_pDS+0);
+    writeDescriptorSet.dstBinding      = 0;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo     = &descriptorBufferInfo;
+
+    vkUpdateDescriptorSets(a_device, 1, &writeDescriptorSet, 0, NULL);
+
+    // INPUT (depends on a_linear: image or linear buffer)
+    VkDescriptorImageInfo descriptorImageInfo{};
+    VkDescriptorBufferInfo descriptorTexelBufferInfo{};
+
+    descriptorImageInfo.sampler     = a_image.getSampler();
+    descriptorImageInfo.imageView   = a_image.getImageView();
+    descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    descriptorTexelBufferInfo.buffer = a_texelBuffer;
+    descriptorTexelBufferInfo.offset = 0;
+    descriptorTexelBufferInfo.range  = a_bufferSize;
+
+    VkWriteDescriptorSet writeDescriptorSet2{};
+    writeDescriptorSet2.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet2.dstSet          = *(a_pDS+0);
+    writeDescriptorSet2.dstBinding      = 1;
+    writeDescriptorSet2.descriptorCount = 1;
+    writeDescriptorSet2.descriptorType  = (a_linear) ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER
+        : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
+    if (a_linear)
+    {
+        writeDescriptorSet2.pBufferInfo = &descriptorTexelBufferInfo;
+        writeDescriptorSet2.pTexelBufferView = a_texelBufferView;
+    }
+    else
+    {
+        writeDescriptorSet2.pImageInfo = &descriptorImageInfo;
+    }
+
+    vkUpdateDescriptorSets(a_device, 1, &writeDescriptorSet2, 0, NULL);
+}
+
+void ComputeApplication::CreateDescriptorSetLayoutGuides(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout, bool a_pingPong)
+{
+    VkDescriptorSetLayoutBinding descriptorSetLayoutBinding[4];
+
+    // Compute shader output image storage
+    descriptorSetLayoutBinding[0].binding            = 0;
+    descriptorSetLayoutBinding[0].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorSetLayoutBinding[0].descriptorCount    = 1;
+    descriptorSetLayoutBinding[0].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[0].pImmutableSamplers = nullptr;
+
+    // Compute shader input image
+    descriptorSetLayoutBinding[1].binding            = 1;
+    descriptorSetLayoutBinding[1].descriptorType     = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorSetLayoutBinding[1].descriptorCount    = 1;
+    descriptorSetLayoutBinding[1].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[1].pImmutableSamplers = nullptr;
+
+    // All guide layers
+    descriptorSetLayoutBinding[2].binding            = 2;
+    descriptorSetLayoutBinding[2].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorSetLayoutBinding[2].descriptorCount    = 1;
+    descriptorSetLayoutBinding[2].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[2].pImmutableSamplers = nullptr;
+
+    // Results of the previous iterations
+    descriptorSetLayoutBinding[3].binding            = 3;
+    descriptorSetLayoutBinding[3].descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorSetLayoutBinding[3].descriptorCount    = 1;
+    descriptorSetLayoutBinding[3].stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding[3].pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+    descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.bindingCount = (a_pingPong) ? 4 : 3;
+    descriptorSetLayoutCreateInfo.pBindings    = descriptorSetLayoutBinding;
+
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, NULL, a_pDSLayout));
+}
+
+void ComputeApplication::CreateDescriptorSetGuides(VkDevice a_device, VkBuffer a_buffer, size_t a_bufferSize, const VkDescriptorSetLayout *a_pDSLayout,
+        CustomVulkanTexture a_image, VkBuffer a_bufferGuides, size_t a_bufferGuidesSize, VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS,
+        VkBuffer a_bufferPingPong, size_t a_bufferPingPongSize)
+{
+    // 0: GPU buffer (W)
+    // 1: Texture (R)
+    // 2: Guides (R)
+    // 3: Ping-pong buffer (W/R), a-trous only
+
+    const uint32_t bindings{ (a_bufferPingPong != VK_NULL_HANDLE) ? 4u : 3u };
+
+    VkDescriptorPoolSize descriptorPoolSize[2];
+    descriptorPoolSize[0].type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize[0].descriptorCount = bindings - 1;
+    descriptorPoolSize[1].type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorPoolSize[1].descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets       = 1;
+    descriptorPoolCreateInfo.poolSizeCount = 2;
+    descriptorPoolCreateInfo.pPoolSizes    = descriptorPoolSize;
+
+    VK_CHECK_RESULT(vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, NULL, a_pDSPool));
+
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+    descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.descriptorPool     = (*a_pDSPool);
+    descriptorSetAllocateInfo.descriptorSetCount = 1;
+    descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, a_pDS));
+
+    VkDescriptorBufferInfo descriptorBufferInfo{};
+    descriptorBufferInfo.buffer = a_buffer;
+    descriptorBufferInfo.offset = 0;
+    descriptorBufferInfo.range  = a_bufferSize;
+
+    VkDescriptorImageInfo descriptorImageInfo{};
+    descriptorImageInfo.sampler     = a_image.getSampler();
+    descriptorImageInfo.imageView   = a_image.getImageView();
+    descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    VkDescriptorBufferInfo descriptorGuidesInfo{};
+    descriptorGuidesInfo.buffer = a_bufferGuides;
+    descriptorGuidesInfo.offset = 0;
+    descriptorGuidesInfo.range  = a_bufferGuidesSize;
+
+    VkDescriptorBufferInfo descriptorPingPongInfo{};
+    descriptorPingPongInfo.buffer = a_bufferPingPong;
+    descriptorPingPongInfo.offset = 0;
+    descriptorPingPongInfo.range  = a_bufferPingPongSize;
+
+    VkWriteDescriptorSet writeDescriptorSets[4]{};
+    for (uint32_t i{}; i < bindings; ++i)
+    {
+        writeDescriptorSets[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDescriptorSets[i].dstSet          = *a_pDS;
+        writeDescriptorSets[i].dstBinding      = i;
+        writeDescriptorSets[i].descriptorCount = 1;
+    }
+
+    writeDescriptorSets[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSets[0].pBufferInfo    = &descriptorBufferInfo;
+    writeDescriptorSets[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writeDescriptorSets[1].pImageInfo     = &descriptorImageInfo;
+    writeDescriptorSets[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSets[2].pBufferInfo    = &descriptorGuidesInfo;
+    writeDescriptorSets[3].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSets[3].pBufferInfo    = &descriptorPingPongInfo;
+
+    vkUpdateDescriptorSets(a_device, bindings, writeDescriptorSets, 0, NULL);
+}
+
+void ComputeApplication::CreateDescriptorSetTiles(VkDevice a_device, VkBuffer a_bufferTiles, size_t a_bufferSize,
+        VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS)
+{
+    VkDescriptorSetLayoutBinding descriptorSetLayoutBinding{};
+    descriptorSetLayoutBinding.binding            = 0;
+    descriptorSetLayoutBinding.descriptorType     = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorSetLayoutBinding.descriptorCount    = 1;
+    descriptorSetLayoutBinding.stageFlags         = VK_SHADER_STAGE_COMPUTE_BIT;
+    descriptorSetLayoutBinding.pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+    descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.bindingCount = 1;
+    descriptorSetLayoutCreateInfo.pBindings    = &descriptorSetLayoutBinding;
+
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(a_device, &descriptorSetLayoutCreateInfo, NULL, a_pDSLayout));
+
+    VkDescriptorPoolSize descriptorPoolSize{};
+    descriptorPoolSize.type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize.descriptorCount = 1;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets       = 1;
+    descriptorPoolCreateInfo.poolSizeCount = 1;
+    descriptorPoolCreateInfo.pPoolSizes    = &descriptorPoolSize;
+
+    VK_CHECK_RESULT(vkCreateDescriptorPool(a_device, &descriptorPoolCreateInfo, NULL, a_pDSPool));
+
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+    descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.descriptorPool     = (*a_pDSPool);
+    descriptorSetAllocateInfo.descriptorSetCount = 1;
+    descriptorSetAllocateInfo.pSetLayouts        = a_pDSLayout;
+
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(a_device, &descriptorSetAllocateInfo, a_pDS));
+
+    VkDescriptorBufferInfo descriptorBufferInfo{};
+    descriptorBufferInfo.buffer = a_bufferTiles;
+    descriptorBufferInfo.offset = 0;
+    descriptorBufferInfo.range  = a_bufferSize;
+
+    VkWriteDescriptorSet writeDescriptorSet{};
+    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet          = *a_pDS;
+    writeDescriptorSet.dstBinding      = 0;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    writeDescriptorSet.pBufferInfo     = &descriptorBufferInfo;
+
+    vkUpdateDescriptorSets(a_device, 1, &writeDescriptorSet, 0, NULL);
+}
+
+void ComputeApplication::CreateComputePipelines(VkDevice a_device, const VkDescriptorSetLayout &a_dsLayout,
+        VkShaderModule *a_pShaderModule, VkPipeline *a_pPipeline, VkPipelineLayout *a_pPipelineLayout,
+        const char *a_shaderFileName, const size_t pcSize, const WorkgroupSize& a_workgroupSize,
+        VkDescriptorSetLayout a_tilesDSLayout)
+{
+    std::vector<uint32_t> code = vk_utils::ReadFile(a_shaderFileName);
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.pCode    = code.data();
+    createInfo.codeSize = code.size()*sizeof(uint32_t);
+
+    VK_CHECK_RESULT(vkCreateShaderModule(a_device, &createInfo, NULL, a_pShaderModule));
+
+    VkPipelineShaderStageCreateInfo shaderStageCreateInfo = {};
+    shaderStageCreateInfo.sType  = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStageCreateInfo.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+    shaderStageCreateInfo.module = (*a_pShaderModule);
+    shaderStageCreateInfo.pName  = "main";
+
+    VkSpecializationMapEntry specEntries[2]{};
+    specEntries[0].constantID = 0;
+    specEntries[0].offset     = offsetof(WorkgroupSize, x);
+    specEntries[0].size       = sizeof(uint32_t);
+    specEntries[1].constantID = 1;
+    specEntries[1].offset     = offsetof(WorkgroupSize, y);
+    specEntries[1].size       = sizeof(uint32_t);
+
+    VkSpecializationInfo specInfo{};
+    specInfo.mapEntryCount = 2;
+    specInfo.pMapEntries   = specEntries;
+    specInfo.dataSize      = sizeof(WorkgroupSize);
+    specInfo.pData         = &a_workgroupSize;
+    shaderStageCreateInfo.pSpecializationInfo = &specInfo;
+
+    VkPushConstantRange pcRange{};
+    pcRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pcRange.offset     = 0;
+    pcRange.size       = pcSize;
+
+    // sparse shaders read the tile list from set = 1
+    const VkDescriptorSetLayout setLayouts[2]{ a_dsLayout, a_tilesDSLayout };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+    pipelineLayoutCreateInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutCreateInfo.setLayoutCount         = (a_tilesDSLayout != VK_NULL_HANDLE) ? 2 : 1;
+    pipelineLayoutCreateInfo.pSetLayouts            = setLayouts;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges    = &pcRange;
+    VK_CHECK_RESULT(vkCreatePipelineLayout(a_device, &pipelineLayoutCreateInfo, NULL, a_pPipelineLayout));
+
+    VkComputePipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.stage  = shaderStageCreateInfo;
+    pipelineCreateInfo.layout = (*a_pPipelineLayout);
+
+    VK_CHECK_RESULT(vkCreateComputePipelines(a_device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, NULL, a_pPipeline));
+}
+
+void ComputeApplication::CreateCommandBuffer(VkDevice a_device, uint32_t a_queueFamilyIndex, VkPipeline a_pipeline, VkPipelineLayout a_layout,
+        VkCommandPool *a_pool, VkCommandBuffer *a_pCmdBuff)
+{
+    VkCommandPoolCreateInfo commandPoolCreateInfo{};
+    commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+    commandPoolCreateInfo.queueFamilyIndex = a_queueFamilyIndex;
+    VK_CHECK_RESULT(vkCreateCommandPool(a_device, &commandPoolCreateInfo, NULL, a_pool));
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo{};
+    commandBufferAllocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocateInfo.commandPool        = (*a_pool);
+    commandBufferAllocateInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.commandBufferCount = 1;
+    VK_CHECK_RESULT(vkAllocateCommandBuffers(a_device, &commandBufferAllocateInfo, a_pCmdBuff));
+}
+
+void ComputeApplication::CreateQueryPool(VkDevice a_device, VkQueryPool *a_pQueryPool)
+{
+    VkQueryPoolCreateInfo queryPoolCreateInfo{};
+    queryPoolCreateInfo.sType     = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCreateInfo.queryCount = 4;
+
+    VK_CHECK_RESULT(vkCreateQueryPool(a_device, &queryPoolCreateInfo, NULL, a_pQueryPool));
+}
+
+VkImageMemoryBarrier ComputeApplication::imBarTransfer(VkImage a_image, const VkImageSubresourceRange& a_range, VkImageLayout before, VkImageLayout after)
+{
+    VkImageMemoryBarrier moveToGeneralBar{};
+    moveToGeneralBar.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    moveToGeneralBar.pNext               = nullptr;
+    moveToGeneralBar.srcAccessMask       = 0;
+    moveToGeneralBar.dstAccessMask       = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    moveToGeneralBar.oldLayout           = before;
+    moveToGeneralBar.newLayout           = after;
+    moveToGeneralBar.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    moveToGeneralBar.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    moveToGeneralBar.image               = a_image;
+    moveToGeneralBar.subresourceRange    = a_range;
+    return moveToGeneralBar;
+}
+
+VkImageSubresourceRange ComputeApplication::WholeImageRange()
+{
+    VkImageSubresourceRange rangeWholeImage{};
+    rangeWholeImage.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    rangeWholeImage.baseMipLevel   = 0;
+    rangeWholeImage.levelCount     = 1;
+    rangeWholeImage.baseArrayLayer = 0;
+    rangeWholeImage.layerCount     = 1;
+    return rangeWholeImage;
+}
+
+void ComputeApplication::RecordDispatch(VkCommandBuffer a_cmdBuff, VkPipelineLayout a_layout, int a_w, int a_h, const WorkgroupSize& a_wg,
+        VkBuffer a_bufferTiles, VkDescriptorSet a_dsTiles)
+{
+    if (a_bufferTiles == VK_NULL_HANDLE)
+    {
+        vkCmdDispatch(a_cmdBuff, (uint32_t)ceil(a_w / float(a_wg.x)), (uint32_t)ceil(a_h / float(a_wg.y)), 1);
+        return;
+    }
+
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 1, 1, &a_dsTiles, 0, NULL);
+    vkCmdDispatchIndirect(a_cmdBuff, a_bufferTiles, 0);
+}
+
+void ComputeApplication::RecordCommandsOfClassifyTiles(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout,
+        const VkDescriptorSet &a_ds, const VkDescriptorSet &a_dsTiles, VkBuffer a_bufferTiles, int a_w, int a_h,
+        float a_threshold, VkQueryPool a_queryPool, const WorkgroupSize& a_wg)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    // VkDispatchIndirectCommand{0, 1, 1}: the classify pass appends noisy tiles to x
+    const uint32_t dispatchArgs[4]{ 0, 1, 1, 0 };
+    vkCmdUpdateBuffer(a_cmdBuff, a_bufferTiles, 0, sizeof(dispatchArgs), dispatchArgs);
+
+    VkMemoryBarrier memBarr{};
+    memBarr.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarr.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &memBarr,
+            0, nullptr,
+            0, nullptr);
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 1, 1, &a_dsTiles, 0, NULL);
+
+    int wh[2]{ a_w, a_h };
+    vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int) * 2, wh);
+    vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(int), sizeof(float), &a_threshold);
+
+    vkCmdDispatch(a_cmdBuff, (uint32_t)ceil(a_w / float(a_wg.x)), (uint32_t)ceil(a_h / float(a_wg.y)), 1);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+#endif
+
+    // tile list and pass-through pixels must be visible to the indirect dispatch of the filter
+    memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            1, &memBarr,
+            0, nullptr,
+            0, nullptr);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfFirefly(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout,
+        const VkDescriptorSet &a_ds, int a_w, int a_h, float a_threshold, bool a_median, VkQueryPool a_queryPool)
+{
+    // must match params_t and MODE_* of firefly.comp
+    struct FireflyPC {
+        int   width, height;
+        int   mode;
+        float threshold;
+    };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+
+    const FireflyPC pc{ a_w, a_h, (a_median) ? 1 : 0, a_threshold };
+    vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(FireflyPC), &pc);
+
+    vkCmdDispatch(a_cmdBuff, (uint32_t)ceil(a_w / float(FIREFLY_TILE)), (uint32_t)ceil(a_h / float(FIREFLY_TILE)), 1);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+#endif
+
+    // the copy back to the texture reads the cleaned pixels
+    VkMemoryBarrier memBarr{};
+    memBarr.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            1, &memBarr,
+            0, nullptr,
+            0, nullptr);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfPyramid(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+        size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, const std::vector<PyramidLevel>& a_levels,
+        VkQueryPool a_queryPool, const FilterParams& a_params, const WorkgroupSize& a_wg)
+{
+    // must match params_t and PASS_* of pyramid.comp
+    struct PyramidPC {
+        int   width, height;
+        int   pass;
+        int   offset;
+        int   srcWidth, srcHeight;
+        int   srcOffset;
+        int   pyramidTexels;
+        float spatialSigma, colorSigma, filteringParameter;
+    };
+    enum { PASS_LOAD, PASS_DOWN, PASS_FILTER, PASS_UP };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+
+    const PyramidLevel& last{ a_levels.back() };
+
+    PyramidPC pc{};
+    pc.pyramidTexels      = last.offset + last.w * last.h;
+    pc.spatialSigma       = a_params.spatialSigma;
+    pc.colorSigma         = a_params.colorSigma;
+    pc.filteringParameter = a_params.filteringParameter;
+
+    VkMemoryBarrier memBarr{};
+    memBarr.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    auto dispatchPass = [&](int a_pass, const PyramidLevel& a_dst, const PyramidLevel& a_src)
+    {
+        pc.pass      = a_pass;
+        pc.width     = a_dst.w;
+        pc.height    = a_dst.h;
+        pc.offset    = a_dst.offset;
+        pc.srcWidth  = a_src.w;
+        pc.srcHeight = a_src.h;
+        pc.srcOffset = a_src.offset;
+        vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PyramidPC), &pc);
+
+        vkCmdDispatch(a_cmdBuff, (uint32_t)ceil(a_dst.w / float(a_wg.x)), (uint32_t)ceil(a_dst.h / float(a_wg.y)), 1);
+
+        vkCmdPipelineBarrier(a_cmdBuff,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                1, &memBarr,
+                0, nullptr,
+                0, nullptr);
+    };
+
+    // mip chain of the input
+    dispatchPass(PASS_LOAD, a_levels[0], a_levels[0]);
+    for (size_t k{1}; k < a_levels.size(); ++k)
+    {
+        dispatchPass(PASS_DOWN, a_levels[k], a_levels[k - 1]);
+    }
+
+    // small kernel on every level (levels are independent, so no barriers in between would be needed)
+    for (size_t k{}; k < a_levels.size(); ++k)
+    {
+        dispatchPass(PASS_FILTER, a_levels[k], a_levels[k]);
+    }
+
+    // coarse to fine recombination, level 0 is written to the output buffer
+    for (size_t k{a_levels.size() - 1}; k > 0; --k)
+    {
+        dispatchPass(PASS_UP, a_levels[k - 1], a_levels[k]);
+    }
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+#endif
+
+    RecordTransferToHost(a_cmdBuff, a_bufferGPU, a_bufferStaging, a_bufferSize);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+ComputeApplication::AtrousGuides ComputeApplication::FindAtrousGuides(const SourceFrames& a_frames)
+{
+    AtrousGuides guides{};
+
+    for (int i{}; i < int(a_frames.layerNames.size()); ++i)
+    {
+        const std::string& name{ a_frames.layerNames[i] };
+
+        if (name.find("normal") != std::string::npos)
+        {
+            guides.normal = i;
+        }
+        else if (name.find("depth") != std::string::npos)
+        {
+            guides.depth = i;
+        }
+        else if (name.find("albedo") != std::string::npos || name.find("diffusefilter") != std::string::npos
+                || name.find("diffcol") != std::string::npos)
+        {
+            guides.albedo = i;
+        }
+    }
+
+    return guides;
+}
+
+void ComputeApplication::RecordCommandsOfAtrous(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+        size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, int a_w, int a_h, int a_iterations,
+        const AtrousGuides& a_guides, VkQueryPool a_queryPool, const FilterParams& a_params, const WorkgroupSize& a_wg)
+{
+    // must match params_t, SOURCE_TEXTURE and TARGET_OUTPUT of atrous.comp
+    struct AtrousPC {
+        int   width, height;
+        int   step;
+        int   src, dst;
+        int   normalLayer, depthLayer, albedoLayer;
+        float colorSigma;
+    };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+
+    AtrousPC pc{};
+    pc.width       = a_w;
+    pc.height      = a_h;
+    pc.normalLayer = a_guides.normal;
+    pc.depthLayer  = a_guides.depth;
+    pc.albedoLayer = a_guides.albedo;
+
+    VkMemoryBarrier memBarr{};
+    memBarr.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    for (int i{}; i < a_iterations; ++i)
+    {
+        // the texture feeds the first iteration, the last one writes the output buffer, the rest ping-pong
+        pc.step       = 1 << i;
+        pc.src        = (i == 0) ? -1 : (i - 1) % 2;
+        pc.dst        = (i == a_iterations - 1) ? -1 : i % 2;
+        pc.colorSigma = a_params.colorSigma / float(1 << i); // finer color differences as the taps spread out
+        vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(AtrousPC), &pc);
+
+        vkCmdDispatch(a_cmdBuff, (uint32_t)ceil(a_w / float(a_wg.x)), (uint32_t)ceil(a_h / float(a_wg.y)), 1);
+
+        if (i + 1 < a_iterations)
+        {
+            vkCmdPipelineBarrier(a_cmdBuff,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    1, &memBarr,
+                    0, nullptr,
+                    0, nullptr);
+        }
+    }
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+#endif
+
+    RecordTransferToHost(a_cmdBuff, a_bufferGPU, a_bufferStaging, a_bufferSize);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+int ComputeApplication::FindLayer(const SourceFrames& a_frames, const std::string& a_name)
+{
+    for (int i{}; i < int(a_frames.layerNames.size()); ++i)
+    {
+        if (a_frames.layerNames[i].find(a_name) != std::string::npos)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void ComputeApplication::RecordCommandsOfGuided(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+        size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, int a_w, int a_h, int a_radius, float a_epsilon,
+        int a_guideLayer, VkQueryPool a_queryPool, const WorkgroupSize& a_wg)
+{
+    // must match params_t and PASS_* of guided.comp
+    struct GuidedPC {
+        int   width, height;
+        int   pass;
+        int   round;
+        int   radius;
+        int   guideLayer;
+        float epsilon;
+    };
+    enum { PASS_ROWS, PASS_COLS, PASS_OUTPUT };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+
+    GuidedPC pc{};
+    pc.width      = a_w;
+    pc.height     = a_h;
+    pc.radius     = a_radius;
+    pc.guideLayer = a_guideLayer;
+    pc.epsilon    = a_epsilon;
+
+    VkMemoryBarrier memBarr{};
+    memBarr.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    auto dispatchPass = [&](int a_pass, int a_round)
+    {
+        pc.pass  = a_pass;
+        pc.round = a_round;
+        vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(GuidedPC), &pc);
+
+        // scans take one workgroup per row or column
+        if      (a_pass == PASS_ROWS) vkCmdDispatch(a_cmdBuff, uint32_t(a_h), 1, 1);
+        else if (a_pass == PASS_COLS) vkCmdDispatch(a_cmdBuff, uint32_t(a_w), 1, 1);
+        else    vkCmdDispatch(a_cmdBuff, (uint32_t)ceil(a_w / float(a_wg.x)), (uint32_t)ceil(a_h / float(a_wg.y)), 1);
+
+        if (a_pass != PASS_OUTPUT)
+        {
+            vkCmdPipelineBarrier(a_cmdBuff,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    1, &memBarr,
+                    0, nullptr,
+                    0, nullptr);
+        }
+    };
+
+    // statistics of the guide and the input, then the linear coefficients, then the output
+    for (int round{}; round < 2; ++round)
+    {
+        dispatchPass(PASS_ROWS, round);
+        dispatchPass(PASS_COLS, round);
+    }
+    dispatchPass(PASS_OUTPUT, 0);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+#endif
+
+    RecordTransferToHost(a_cmdBuff, a_bufferGPU, a_bufferStaging, a_bufferSize);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfYCbCr(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+        size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, int a_w, int a_h, VkQueryPool a_queryPool,
+        const FilterParams& a_params, const WorkgroupSize& a_wg)
+{
+    // must match params_t and PASS_* of bialteral_ycbcr.comp
+    struct YCbCrPC {
+        int   width, height;
+        int   pass;
+        float spatialSigma;
+        float colorSigma;
+    };
+    enum { PASS_CONVERT, PASS_LUMA, PASS_CHROMA, PASS_OUTPUT };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+
+    YCbCrPC pc{};
+    pc.width        = a_w;
+    pc.height       = a_h;
+    pc.spatialSigma = a_params.spatialSigma;
+    pc.colorSigma   = a_params.colorSigma;
+
+    VkMemoryBarrier memBarr{};
+    memBarr.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    // luma and chroma only read the converted planes, so they need no barrier between each other
+    for (int pass{ PASS_CONVERT }; pass <= PASS_OUTPUT; ++pass)
+    {
+        pc.pass = pass;
+        vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(YCbCrPC), &pc);
+
+        const int w{ (pass == PASS_CHROMA) ? (a_w + 1) / 2 : a_w };
+        const int h{ (pass == PASS_CHROMA) ? (a_h + 1) / 2 : a_h };
+        vkCmdDispatch(a_cmdBuff, (uint32_t)ceil(w / float(a_wg.x)), (uint32_t)ceil(h / float(a_wg.y)), 1);
+
+        if (pass == PASS_CONVERT || pass == PASS_CHROMA)
+        {
+            vkCmdPipelineBarrier(a_cmdBuff,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    1, &memBarr,
+                    0, nullptr,
+                    0, nullptr);
+        }
+    }
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+#endif
+
+    RecordTransferToHost(a_cmdBuff, a_bufferGPU, a_bufferStaging, a_bufferSize);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfExecuteAndTransfer(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline,VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+        size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, int a_w, int a_h, VkQueryPool a_queryPool, bool normKernel,
+        const FilterParams& a_params, const WorkgroupSize& a_wg, VkBuffer a_bufferTiles, VkDescriptorSet a_dsTiles)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+
+    int wh[2]{ a_w, a_h };
+    vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int) * 2, wh);
+
+    if (!normKernel) // plain bialteral denoicing example
+    {
+        float filteringParam[2]{ a_params.spatialSigma, a_params.colorSigma };
+        vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(int), 2 * sizeof(float), filteringParam);
+    }
+
+    RecordDispatch(a_cmdBuff, a_layout, a_w, a_h, a_wg, a_bufferTiles, a_dsTiles);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+#endif
+
+    RecordTransferToHost(a_cmdBuff, a_bufferGPU, a_bufferStaging, a_bufferSize);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfExecuteNLM(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline,VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+        int a_w, int a_h, VkQueryPool a_queryPool, bool nlm, const FilterParams& a_params,
+        const WorkgroupSize& a_wg, VkBuffer a_bufferTiles, VkDescriptorSet a_dsTiles)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+
+    int wh[2]{ a_w, a_h };
+    vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int) * 2, wh);
+
+    if (nlm)
+    {
+        float filteringParam{ a_params.filteringParameter };
+        vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(int), sizeof(float), &filteringParam);
+    }
+    else // we also use this nlm command buffer for layers usage with bialteral
+    {
+        float filteringParam[2]{ a_params.spatialSigma, a_params.colorSigma };
+        vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(int), 2 * sizeof(float), filteringParam);
+    }
+
+    RecordDispatch(a_cmdBuff, a_layout, a_w, a_h, a_wg, a_bufferTiles, a_dsTiles);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfSweep(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+        VkPipeline a_pipelineNorm, VkPipelineLayout a_layoutNorm, const VkDescriptorSet &a_dsNorm, VkBuffer a_bufferWeights,
+        size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferSweep, int a_w, int a_h, VkQueryPool a_queryPool,
+        const FilterParams* a_params, size_t a_count, const WorkgroupSize& a_wg)
+{
+    const bool nlm{ a_bufferWeights != VK_NULL_HANDLE };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    int wh[2]{ a_w, a_h };
+
+    VkMemoryBarrier memBarr{};
+    memBarr.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+
+    for (size_t i{}; i < a_count; ++i)
+    {
+        if (i > 0)
+        {
+            // the copy of the previous result (and its normalization) reads what the next set overwrites
+            memBarr.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+            memBarr.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+            vkCmdPipelineBarrier(a_cmdBuff,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    1, &memBarr,
+                    0, nullptr,
+                    0, nullptr);
+        }
+
+        vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+        vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+        vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int) * 2, wh);
+
+        if (nlm)
+        {
+            vkCmdFillBuffer(a_cmdBuff, a_bufferWeights, 0, VK_WHOLE_SIZE, 0);
+
+            memBarr.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memBarr.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+            vkCmdPipelineBarrier(a_cmdBuff,
+                    VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    1, &memBarr,
+                    0, nullptr,
+                    0, nullptr);
+
+            float filteringParam{ a_params[i].filteringParameter };
+            vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(int), sizeof(float), &filteringParam);
+
+            RecordDispatch(a_cmdBuff, a_layout, a_w, a_h, a_wg, VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+            // weights => normalized result
+            memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            memBarr.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(a_cmdBuff,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                    0,
+                    1, &memBarr,
+                    0, nullptr,
+                    0, nullptr);
+
+            vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipelineNorm);
+            vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layoutNorm, 0, 1, &a_dsNorm, 0, NULL);
+            vkCmdPushConstants(a_cmdBuff, a_layoutNorm, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int) * 2, wh);
+
+            RecordDispatch(a_cmdBuff, a_layoutNorm, a_w, a_h, a_wg, VK_NULL_HANDLE, VK_NULL_HANDLE);
+        }
+        else
+        {
+            float filteringParam[2]{ a_params[i].spatialSigma, a_params[i].colorSigma };
+            vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(int), 2 * sizeof(float), filteringParam);
+
+            RecordDispatch(a_cmdBuff, a_layout, a_w, a_h, a_wg, VK_NULL_HANDLE, VK_NULL_HANDLE);
+        }
+
+        RecordTransferToHost(a_cmdBuff, a_bufferGPU, a_bufferSweep, a_bufferSize, a_bufferSize * i);
+    }
+
+#ifdef QUERY_TIME
+    // copies between the sets are counted as execution, the host reads the slots in place
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 1);
+#endif
+
+    memBarr.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            1, &memBarr,
+            0, nullptr,
+            0, nullptr);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfOverlappingNLM(VkCommandBuffer a_cmdBuff, int a_w, int a_h, VkBuffer a_bufferDynamic,
+        VkImage *a_images,  const VkDescriptorSet &a_ds, VkPipeline a_pipeline, VkPipelineLayout a_layout, VkQueryPool a_queryPool,
+        const FilterParams& a_params, const WorkgroupSize& a_wg, VkBuffer a_bufferTiles, VkDescriptorSet a_dsTiles)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_pipeline);
+    vkCmdBindDescriptorSets(a_cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, a_layout, 0, 1, &a_ds, 0, NULL);
+
+    int wh[2]{ a_w, a_h };
+    vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int) * 2, wh);
+
+    float filteringParam{ a_params.filteringParameter };
+    vkCmdPushConstants(a_cmdBuff, a_layout, VK_SHADER_STAGE_COMPUTE_BIT, 2 * sizeof(int), sizeof(float), &filteringParam);
+
+    RecordDispatch(a_cmdBuff, a_layout, a_w, a_h, a_wg, a_bufferTiles, a_dsTiles);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, a_queryPool, 1);
+#endif
+
+    VkImageSubresourceRange rangeWholeImage = WholeImageRange();
+
+    VkImageSubresourceLayers shittylayers{};
+    shittylayers.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    shittylayers.mipLevel       = 0;
+    shittylayers.baseArrayLayer = 0;
+    shittylayers.layerCount     = 1;
+
+    VkBufferImageCopy wholeRegion = {};
+    wholeRegion.bufferOffset      = 0;
+    wholeRegion.bufferRowLength   = uint32_t(a_w);
+    wholeRegion.bufferImageHeight = uint32_t(a_h);
+    wholeRegion.imageExtent       = VkExtent3D{uint32_t(a_w), uint32_t(a_h), 1};
+    wholeRegion.imageOffset       = VkOffset3D{0,0,0};
+    wholeRegion.imageSubresource  = shittylayers;
+
+    VkImageMemoryBarrier moveToGeneralBar = imBarTransfer(a_images[0],
+            rangeWholeImage,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,            // general memory barriers
+            0, nullptr,            // buffer barriers
+            1, &moveToGeneralBar); // image  barriers
+
+    VkClearColorValue clearVal = {};
+    clearVal.float32[0] = 1.0f;
+    clearVal.float32[1] = 1.0f;
+    clearVal.float32[2] = 1.0f;
+    clearVal.float32[3] = 1.0f;
+
+    vkCmdClearColorImage(a_cmdBuff, a_images[0], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearVal, 1, &rangeWholeImage);
+
+    vkCmdCopyBufferToImage(a_cmdBuff, a_bufferDynamic, *a_images, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &wholeRegion);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VkImageMemoryBarrier imgBar{};
+    {
+        imgBar.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imgBar.pNext = nullptr;
+        imgBar.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imgBar.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+        imgBar.srcAccessMask       = 0;
+        imgBar.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+        imgBar.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imgBar.newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imgBar.image               = a_images[0];
+
+        imgBar.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        imgBar.subresourceRange.baseMipLevel   = 0;
+        imgBar.subresourceRange.levelCount     = 1;
+        imgBar.subresourceRange.baseArrayLayer = 0;
+        imgBar.subresourceRange.layerCount     = 1;
+    };
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &imgBar);
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfCopyImageDataToTexture(VkCommandBuffer a_cmdBuff, int a_width, int a_height, VkBuffer a_bufferDynamic,
+        VkImage *a_images, VkQueryPool a_queryPool)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 1);
+#endif
+
+    VkImageSubresourceRange rangeWholeImage = WholeImageRange();
+
+    VkImageSubresourceLayers shittylayers{};
+    shittylayers.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    shittylayers.mipLevel       = 0;
+    shittylayers.baseArrayLayer = 0;
+    shittylayers.layerCount     = 1;
+
+    VkBufferImageCopy wholeRegion = {};
+    wholeRegion.bufferOffset      = 0;
+    wholeRegion.bufferRowLength   = uint32_t(a_width);
+    wholeRegion.bufferImageHeight = uint32_t(a_height);
+    wholeRegion.imageExtent       = VkExtent3D{uint32_t(a_width), uint32_t(a_height), 1};
+    wholeRegion.imageOffset       = VkOffset3D{0,0,0};
+    wholeRegion.imageSubresource  = shittylayers;
+
+    VkImageMemoryBarrier moveToGeneralBar = imBarTransfer(a_images[0],
+            rangeWholeImage,
+            VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,            // general memory barriers
+            0, nullptr,            // buffer barriers
+            1, &moveToGeneralBar); // image  barriers
+
+    VkClearColorValue clearVal = {};
+    clearVal.float32[0] = 1.0f;
+    clearVal.float32[1] = 1.0f;
+    clearVal.float32[2] = 1.0f;
+    clearVal.float32[3] = 1.0f;
+
+    vkCmdClearColorImage(a_cmdBuff, a_images[0], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clearVal, 1, &rangeWholeImage);
+
+    vkCmdCopyBufferToImage(a_cmdBuff, a_bufferDynamic, *a_images, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &wholeRegion);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VkImageMemoryBarrier imgBar{};
+    {
+        imgBar.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imgBar.pNext = nullptr;
+        imgBar.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imgBar.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+        imgBar.srcAccessMask       = 0;
+        imgBar.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+        imgBar.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imgBar.newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imgBar.image               = a_images[0];
+
+        imgBar.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        imgBar.subresourceRange.baseMipLevel   = 0;
+        imgBar.subresourceRange.levelCount     = 1;
+        imgBar.subresourceRange.baseArrayLayer = 0;
+        imgBar.subresourceRange.layerCount     = 1;
+    };
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &imgBar);
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RecordCommandsOfCopyBuffer(VkCommandBuffer a_cmdBuff, VkBuffer a_bufferSrc, VkBuffer a_bufferDst, size_t a_bufferSize,
+        VkQueryPool a_queryPool)
+{
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(a_cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(a_cmdBuff, a_queryPool, 0, 3);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, a_queryPool, 0);
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 1);
+#endif
+
+    VkBufferCopy copyInfo{};
+    copyInfo.srcOffset = 0;
+    copyInfo.dstOffset = 0;
+    copyInfo.size      = a_bufferSize;
+
+    vkCmdCopyBuffer(a_cmdBuff, a_bufferSrc, a_bufferDst, 1, &copyInfo);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(a_cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, a_queryPool, 2);
+#endif
+
+    VkBufferMemoryBarrier bufBarr{};
+    bufBarr.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufBarr.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufBarr.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufBarr.buffer              = a_bufferDst;
+    bufBarr.offset              = 0;
+    bufBarr.size                = VK_WHOLE_SIZE;
+    bufBarr.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufBarr.dstAccessMask       = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(a_cmdBuff,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            1, &bufBarr,
+            0, nullptr);
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(a_cmdBuff));
+}
+
+void ComputeApplication::RunCommandBuffer(VkCommandBuffer a_cmdBuff, VkQueue a_queue, VkDevice a_device, VkQueryPool a_queryPool,
+        uint64_t& a_execElapsedTime, uint64_t& a_transferElapsedTime)
+{
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers    = &a_cmdBuff;
+
+    VkFence fence{};
+    VkFenceCreateInfo fenceCreateInfo{};
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.flags = 0;
+    VK_CHECK_RESULT(vkCreateFence(a_device, &fenceCreateInfo, NULL, &fence));
+    VK_CHECK_RESULT(vkQueueSubmit(a_queue, 1, &submitInfo, fence));
+    VK_CHECK_RESULT(vkWaitForFences(a_device, 1, &fence, VK_TRUE, 10000000000000));
+    vkDestroyFence(a_device, fence, NULL);
+
+#ifdef QUERY_TIME
+    uint64_t data[3]{};
+    VK_CHECK_RESULT(vkGetQueryPoolResults(a_device, a_queryPool, 0, 3, 3 * sizeof(uint64_t), &data, sizeof(uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+    a_execElapsedTime     += data[1] - data[0];
+    a_transferElapsedTime += data[2] - data[1];
+#endif
+}
+
+void ComputeApplication::LoadImageDataToBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, std::vector<unsigned int> a_imageData,
+        int a_w, int a_h, VkDeviceMemory a_bufferMemoryTexel, VkDeviceMemory a_bufferMemoryDynamic, bool a_linear)
+{
+    void *mappedMemory = nullptr;
+
+    if (a_linear)
+    {
+        vkMapMemory(a_device, a_bufferMemoryTexel, 0, a_w * a_h * sizeof(int), 0, &mappedMemory);
+        pixel_format::Copy(a_imageData.data(), mappedMemory, a_w * a_h * sizeof(int));
+        vkUnmapMemory(a_device, a_bufferMemoryTexel);
+    }
+    else
+    {
+        vkMapMemory(a_device, a_bufferMemoryDynamic, 0, a_w * a_h * sizeof(int), 0, &mappedMemory);
+        pixel_format::Copy(a_imageData.data(), mappedMemory, a_w * a_h * sizeof(int));
+        vkUnmapMemory(a_device, a_bufferMemoryDynamic);
+    }
+}
+
+void ComputeApplication::LoadImageDataToBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, std::vector<Pixel> a_imageDataHDR,
+        int a_w, int a_h, VkDeviceMemory a_bufferMemoryTexel, VkDeviceMemory a_bufferMemoryDynamic, bool a_linear, bool a_half)
+{
+    void *mappedMemory = nullptr;
+
+    if (a_half)
+    {
+        vkMapMemory(a_device, a_bufferMemoryDynamic, 0, a_w * a_h * HALF_PIXEL_SIZE, 0, &mappedMemory);
+        pixel_format::Rgba32FToRgba16F((const float*)a_imageDataHDR.data(), (uint16_t*)mappedMemory, size_t(a_w) * a_h);
+        vkUnmapMemory(a_device, a_bufferMemoryDynamic);
+    }
+    else if (a_linear)
+    {
+        vkMapMemory(a_device, a_bufferMemoryTexel, 0, a_w * a_h * sizeof(Pixel), 0, &mappedMemory);
+        pixel_format::Copy(a_imageDataHDR.data(), mappedMemory, a_w * a_h * sizeof(Pixel));
+        vkUnmapMemory(a_device, a_bufferMemoryTexel);
+    }
+    else
+    {
+        vkMapMemory(a_device, a_bufferMemoryDynamic, 0, a_w * a_h * sizeof(Pixel), 0, &mappedMemory);
+        pixel_format::Copy(a_imageDataHDR.data(), mappedMemory, a_w * a_h * sizeof(Pixel));
+        vkUnmapMemory(a_device, a_bufferMemoryDynamic);
+    }
+
+}
+
+void ComputeApplication::ReleaseTransferBuffers()
+{
+    if (m_bufferDynamic != VK_NULL_HANDLE)
+    {
+        vkFreeMemory   (m_device, m_bufferMemoryDynamic, NULL);
+        vkDestroyBuffer(m_device, m_bufferDynamic, NULL);
+        m_bufferMemoryDynamic = VK_NULL_HANDLE;
+        m_bufferDynamic = VK_NULL_HANDLE;
+    }
+
+    if (m_bufferStaging != VK_NULL_HANDLE)
+    {
+        vkFreeMemory   (m_device, m_bufferMemoryStaging, NULL);
+        vkDestroyBuffer(m_device, m_bufferStaging, NULL);
+        m_bufferStaging = VK_NULL_HANDLE;
+        m_bufferMemoryStaging = VK_NULL_HANDLE;
+    }
+
+    if (m_bufferSweep != VK_NULL_HANDLE)
+    {
+        vkFreeMemory   (m_device, m_bufferMemorySweep, NULL);
+        vkDestroyBuffer(m_device, m_bufferSweep, NULL);
+        m_bufferSweep = VK_NULL_HANDLE;
+        m_bufferMemorySweep = VK_NULL_HANDLE;
+        m_sweepBufferSize = 0;
+    }
+}
+
+void ComputeApplication::ReleaseResources()
+{
+    m_resourcesReady = false;
+
+    if (m_device == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Destroy buffers and device memory allocated for them
+    {
+        ReleaseTransferBuffers();
+
+        if (m_bufferGPU != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryGPU, NULL);
+            vkDestroyBuffer(m_device, m_bufferGPU, NULL);
+            m_bufferGPU = VK_NULL_HANDLE;
+            m_bufferMemoryGPU = VK_NULL_HANDLE;
+        }
+
+        if (m_bufferWeights != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryWeights, NULL);
+            vkDestroyBuffer(m_device, m_bufferWeights, NULL);
+            m_bufferWeights = VK_NULL_HANDLE;
+            m_bufferMemoryWeights = VK_NULL_HANDLE;
+        }
+
+        if (m_bufferTexel != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryTexel, NULL);
+            vkDestroyBuffer(m_device, m_bufferTexel, NULL);
+            vkDestroyBufferView(m_device, m_texelBufferView, NULL);
+            m_bufferMemoryTexel = VK_NULL_HANDLE;
+            m_bufferTexel = VK_NULL_HANDLE;
+            m_texelBufferView = VK_NULL_HANDLE;
+        }
+
+        if (m_bufferPyramid != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryPyramid, NULL);
+            vkDestroyBuffer(m_device, m_bufferPyramid, NULL);
+            m_bufferPyramid = VK_NULL_HANDLE;
+            m_bufferMemoryPyramid = VK_NULL_HANDLE;
+        }
+
+        if (m_bufferTiles != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryTiles, NULL);
+            vkDestroyBuffer(m_device, m_bufferTiles, NULL);
+            m_bufferTiles = VK_NULL_HANDLE;
+            m_bufferMemoryTiles = VK_NULL_HANDLE;
+        }
+
+        if (m_bufferPingPong != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryPingPong, NULL);
+            vkDestroyBuffer(m_device, m_bufferPingPong, NULL);
+            m_bufferPingPong = VK_NULL_HANDLE;
+            m_bufferMemoryPingPong = VK_NULL_HANDLE;
+        }
+
+        if (m_bufferGuides != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryGuides, NULL);
+            vkDestroyBuffer(m_device, m_bufferGuides, NULL);
+            m_bufferGuides = VK_NULL_HANDLE;
+            m_bufferMemoryGuides = VK_NULL_HANDLE;
+        }
+
+        if (m_bufferGuidesUpload != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryGuidesUpload, NULL);
+            vkDestroyBuffer(m_device, m_bufferGuidesUpload, NULL);
+            m_bufferGuidesUpload = VK_NULL_HANDLE;
+            m_bufferMemoryGuidesUpload = VK_NULL_HANDLE;
+        }
+
+        if (m_bufferFirefly != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemoryFirefly, NULL);
+            vkDestroyBuffer(m_device, m_bufferFirefly, NULL);
+            m_bufferFirefly = VK_NULL_HANDLE;
+            m_bufferMemoryFirefly = VK_NULL_HANDLE;
+        }
+
+    }
+
+    // Delete images
+    m_targetImage.release();
+    m_neighbourImage.release();
+    m_neighbourImage2.release();
+
+    // Delete shader related resourses
+    {
+        if (m_descriptorPool != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(m_device, m_descriptorPool, NULL);
+            m_descriptorPool = VK_NULL_HANDLE;
+        }
+
+        if (m_descriptorPool2 != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(m_device, m_descriptorPool2, NULL);
+            m_descriptorPool2 = VK_NULL_HANDLE;
+        }
+
+        if (m_descriptorPool3 != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(m_device, m_descriptorPool3, NULL);
+            m_descriptorPool3 = VK_NULL_HANDLE;
+        }
+
+        if (m_computeShaderModule != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(m_device, m_computeShaderModule, NULL);
+            m_computeShaderModule = VK_NULL_HANDLE;
+        }
+
+        if (m_computeShaderModule2 != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(m_device, m_computeShaderModule2, NULL);
+            m_computeShaderModule2 = VK_NULL_HANDLE;
+        }
+
+        if (m_descriptorSetLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, NULL);
+            m_descriptorSetLayout = VK_NULL_HANDLE;
+        }
+
+        if (m_descriptorSetLayout2 != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout2, NULL);
+            m_descriptorSetLayout2 = VK_NULL_HANDLE;
+        }
+
+        if (m_pipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(m_device, m_pipelineLayout, NULL);
+            m_pipelineLayout = VK_NULL_HANDLE;
+        }
+
+        if (m_pipelineLayout2 != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(m_device, m_pipelineLayout2, NULL);
+            m_pipelineLayout2 = VK_NULL_HANDLE;
+        }
+
+        if (m_pipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(m_device, m_pipeline, NULL);
+            m_pipeline = VK_NULL_HANDLE;
+        }
+
+        if (m_pipeline2 != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(m_device, m_pipeline2, NULL);
+            m_pipeline2 = VK_NULL_HANDLE;
+        }
+
+        // sparse dispatch
+        if (m_descriptorPoolTiles != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(m_device, m_descriptorPoolTiles, NULL);
+            m_descriptorPoolTiles = VK_NULL_HANDLE;
+        }
+
+        if (m_descriptorSetLayoutTiles != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutTiles, NULL);
+            m_descriptorSetLayoutTiles = VK_NULL_HANDLE;
+        }
+
+        if (m_classifyShaderModule != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(m_device, m_classifyShaderModule, NULL);
+            m_classifyShaderModule = VK_NULL_HANDLE;
+        }
+
+        if (m_classifyPipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(m_device, m_classifyPipelineLayout, NULL);
+            m_classifyPipelineLayout = VK_NULL_HANDLE;
+        }
+
+        if (m_classifyPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(m_device, m_classifyPipeline, NULL);
+            m_classifyPipeline = VK_NULL_HANDLE;
+        }
+
+        // firefly pre-pass
+        if (m_descriptorPoolFirefly != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorPool(m_device, m_descriptorPoolFirefly, NULL);
+            m_descriptorPoolFirefly = VK_NULL_HANDLE;
+        }
+
+        if (m_descriptorSetLayoutFirefly != VK_NULL_HANDLE)
+        {
+            vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayoutFirefly, NULL);
+            m_descriptorSetLayoutFirefly = VK_NULL_HANDLE;
+        }
+
+        if (m_fireflyShaderModule != VK_NULL_HANDLE)
+        {
+            vkDestroyShaderModule(m_device, m_fireflyShaderModule, NULL);
+            m_fireflyShaderModule = VK_NULL_HANDLE;
+        }
+
+        if (m_fireflyPipelineLayout != VK_NULL_HANDLE)
+        {
+            vkDestroyPipelineLayout(m_device, m_fireflyPipelineLayout, NULL);
+            m_fireflyPipelineLayout = VK_NULL_HANDLE;
+        }
+
+        if (m_fireflyPipeline != VK_NULL_HANDLE)
+        {
+            vkDestroyPipeline(m_device, m_fireflyPipeline, NULL);
+            m_fireflyPipeline = VK_NULL_HANDLE;
+        }
+    }
+
+    if (m_commandPool != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(m_device, m_commandPool, NULL);
+        m_commandPool = VK_NULL_HANDLE;
+    }
+
+    if (m_commandPool2 != VK_NULL_HANDLE)
+    {
+        vkDestroyCommandPool(m_device, m_commandPool2, NULL);
+        m_commandPool2 = VK_NULL_HANDLE;
+    }
+
+    if (m_queryPool != VK_NULL_HANDLE)
+    {
+        vkDestroyQueryPool(m_device, m_queryPool, NULL);
+        m_queryPool = VK_NULL_HANDLE;
+    }
+}
+
+void ComputeApplication::Cleanup()
+{
+    ReleaseResources();
+
+    m_device         = VK_NULL_HANDLE;
+    m_queue          = VK_NULL_HANDLE;
+    m_physicalDevice = VK_NULL_HANDLE;
+    m_instance       = VK_NULL_HANDLE;
+
+    // the device goes away with its last user
+    if (!m_externalDevice)
+    {
+        m_sharedDevice.reset();
+    }
+}
+
+std::shared_ptr<ComputeApplication::SharedDevice> ComputeApplication::CreateSharedDevice(int a_deviceId, bool a_hostImport)
+{
+    auto shared{ std::make_shared<SharedDevice>() };
+    shared->deviceId = a_deviceId;
+
+    shared->instance = vk_utils::CreateInstance(enableValidationLayers, shared->enabledLayers);
+    if (enableValidationLayers)
+    {
+        vk_utils::InitDebugReportCallback(shared->instance,
+                &debugReportCallbackFn, &shared->debugReportCallback);
+    }
+
+    shared->physicalDevice = vk_utils::FindPhysicalDevice(shared->instance, true, a_deviceId);
+
+    VkPhysicalDeviceProperties deviceProps{};
+    vkGetPhysicalDeviceProperties(shared->physicalDevice, &deviceProps);
+    shared->deviceName      = deviceProps.deviceName;
+    shared->timestampPeriod = deviceProps.limits.timestampPeriod;
+
+    std::vector<const char *> deviceExtensions{};
+
+    if (a_hostImport && deviceProps.apiVersion >= VK_API_VERSION_1_1
+            && vk_utils::IsDeviceExtensionSupported(shared->physicalDevice, VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME))
+    {
+        deviceExtensions.push_back(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+        shared->hostPointerAlignment = HostPointerAlignment(shared->physicalDevice);
+    }
+
+    // FP16 mode (SetHalfPrecision) stores halves in the buffers and computes distances in halves when the device
+    // has both; otherwise its shaders pack the halves in uints
+    VkPhysicalDevice16BitStorageFeatures storage16Features{};
+    storage16Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
+
+    VkPhysicalDeviceShaderFloat16Int8Features float16Features{};
+    float16Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES;
+    float16Features.pNext = &storage16Features;
+
+    if (deviceProps.apiVersion >= VK_API_VERSION_1_1
+            && vk_utils::IsDeviceExtensionSupported(shared->physicalDevice, VK_KHR_16BIT_STORAGE_EXTENSION_NAME)
+            && vk_utils::IsDeviceExtensionSupported(shared->physicalDevice, VK_KHR_SHADER_FLOAT16_INT8_EXTENSION_NAME))
+    {
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &float16Features;
+        vkGetPhysicalDeviceFeatures2(shared->physicalDevice, &features2);
+
+        shared->halfNative = storage16Features.storageBuffer16BitAccess == VK_TRUE && float16Features.shaderFloat16 == VK_TRUE;
+    }
+
+    const void* featuresChain{ nullptr };
+
+    if (shared->halfNative)
+    {
+        deviceExtensions.push_back(VK_KHR_16BIT_STORAGE_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_SHADER_FLOAT16_INT8_EXTENSION_NAME);
+
+        // only what the shaders use
+        storage16Features = VkPhysicalDevice16BitStorageFeatures{};
+        storage16Features.sType                    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_16BIT_STORAGE_FEATURES;
+        storage16Features.storageBuffer16BitAccess = VK_TRUE;
+
+        float16Features.shaderFloat16 = VK_TRUE;
+        float16Features.shaderInt8    = VK_FALSE;
+        featuresChain = &float16Features;
+    }
+
+    shared->queueFamilyIndex = vk_utils::GetComputeQueueFamilyIndex(shared->physicalDevice);
+    shared->device = vk_utils::CreateLogicalDevice(shared->queueFamilyIndex, shared->physicalDevice, shared->enabledLayers,
+            deviceExtensions, featuresChain);
+    vkGetDeviceQueue(shared->device, shared->queueFamilyIndex, 0, &shared->queue);
+
+    return shared;
+}
+
+void ComputeApplication::Submit(VkCommandBuffer a_cmdBuff)
+{
+    QueueScheduler::Turn turn{ m_sharedDevice->scheduler, m_priority };
+    RunCommandBuffer(a_cmdBuff, m_queue, m_device, m_queryPool, m_execTimeElapsed, m_transferTimeElapsed);
+}
+
+void ComputeApplication::LoadSourceFrames(SourceFrames& a_frames, bool a_multiframe, bool a_useLayers)
+{
+    namespace fs = std::filesystem;
+
+    fs::path targetImg{ m_imageSource };
+    fs::path parentDir{ targetImg.parent_path() };
+    std::string imageID{ m_imageSource.substr(m_imageSource.find(".") - 4, 4) };
+
+    std::vector<std::string> fileNameFrames(0);
+    std::vector<std::string> fileNameLayers(0);
+
+    for (auto& p: fs::directory_iterator(parentDir.c_str()))
+    {
+        fs::path img{p};
+
+        if (p.is_directory())
+        {
+            if (a_useLayers)
+            {
+                for (auto& pp: fs::directory_iterator(img.c_str()))
+                {
+                    fs::path layerImg{pp};
+
+                    if (std::string(layerImg.c_str()).find(imageID) != std::string::npos)
+                    {
+                        fileNameLayers.push_back(layerImg.c_str());
+                    }
+                }
+            }
+        }
+        else if (img.extension() == targetImg.extension())
+        {
+            if (a_multiframe)
+            {
+                fileNameFrames.push_back(img.c_str());
+            }
+        }
+    }
+
+    a_frames.isHDR = targetImg.extension() == ".exr";
+    std::vector<std::string> targetImageDummy(0); // to make sure our target image is first in imageData vector
+    targetImageDummy.push_back(m_imageSource);
+
+    // loading target image
+    LoadImages(a_frames.w, a_frames.h, targetImageDummy, a_frames.imageData, a_frames.imageDataHDR, a_frames.isHDR);
+
+    // loading frames
+    LoadImages(a_frames.w, a_frames.h, fileNameFrames, a_frames.imageData, a_frames.imageDataHDR, a_frames.isHDR);
+
+    // loading layers, in name order so that --guide-weights applies to the same layer every run
+    std::sort(fileNameLayers.begin(), fileNameLayers.end());
+    LoadImages(a_frames.w, a_frames.h, fileNameLayers, a_frames.layerData, a_frames.imageDataHDR, false);
+
+    for (const std::string& fileName : fileNameLayers)
+    {
+        std::string name{ fs::path(fileName).filename().string() };
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+        a_frames.layerNames.push_back(name);
+    }
+}
+
+void ComputeApplication::UploadGuides(const SourceFrames& a_frames)
+{
+    const int    layers{ int(a_frames.layerData.size()) };
+    const size_t plane{ size_t(a_frames.w) * a_frames.h };
+    const size_t bufferSize{ GuideBufferSize(a_frames.w, a_frames.h, layers) };
+
+    uint32_t *mappedMemory{};
+    vkMapMemory(m_device, (m_unifiedMemory) ? m_bufferMemoryGuides : m_bufferMemoryGuidesUpload, 0, bufferSize, 0, (void**)&mappedMemory);
+
+    mappedMemory[0] = uint32_t(layers);
+    for (int i{}; i < MAX_GUIDE_LAYERS; ++i)
+    {
+        const float weight{ (i < int(m_guideWeights.size())) ? m_guideWeights[i] : 1.0f };
+        memcpy(&mappedMemory[1 + i], &weight, sizeof(float));
+    }
+
+    for (int i{}; i < layers; ++i)
+    {
+        memcpy(&mappedMemory[1 + MAX_GUIDE_LAYERS + i * plane], a_frames.layerData[i].data(), plane * sizeof(uint32_t));
+    }
+
+    vkUnmapMemory(m_device, (m_unifiedMemory) ? m_bufferMemoryGuides : m_bufferMemoryGuidesUpload);
+
+    if (!m_unifiedMemory)
+    {
+        vkResetCommandBuffer(m_commandBuffer, 0);
+        RecordCommandsOfCopyBuffer(m_commandBuffer, m_bufferGuidesUpload, m_bufferGuides, bufferSize, m_queryPool);
+        Submit(m_commandBuffer);
+    }
+}
+
+void ComputeApplication::ExecuteFilters(const SourceFrames& a_frames, int a_framesToUse, const std::vector<PyramidLevel>& a_pyramidLevels, Pixel* a_result)
+{
+    const std::vector<std::vector<unsigned int>>& imageData{ a_frames.imageData };
+    const std::vector<std::vector<Pixel>>&        imageDataHDR{ a_frames.imageDataHDR };
+    const std::vector<PyramidLevel>&              pyramidLevels{ a_pyramidLevels };
+    const int    w{ a_frames.w }, h{ a_frames.h };
+    const int    framesToUse{ a_framesToUse };
+    const bool   pyramid{ m_pyramidLevels > 1 };
+    const bool   atrous{ m_atrousIterations > 0 };
+    const bool   guided{ m_guidedRadius > 0 };
+    const size_t bufferSize{ OutputPixelSize() * w * h };
+    const VkBuffer bufferStaging{ (m_unifiedMemory) ? VK_NULL_HANDLE : m_bufferStaging }; // no copy on unified memory
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tload image #0 data to texture\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    if (m_inputImported)
+    {
+        // the dynamic buffer is the caller memory, pixels are already there
+    }
+    else if (m_isHDR)
+    {
+        LoadImageDataToBuffer(m_device, m_physicalDevice, imageDataHDR[0], w, h, m_bufferMemoryTexel, m_bufferMemoryDynamic, m_linear, m_half);
+    }
+    else
+    {
+        LoadImageDataToBuffer(m_device, m_physicalDevice, imageData[0], w, h, m_bufferMemoryTexel, m_bufferMemoryDynamic, m_linear);
+    }
+
+    if (!m_linear)
+    {
+        // DYNAMIC BUFFER => TEXTURE (COPYING)
+        vkResetCommandBuffer(m_commandBuffer, 0);
+        RecordCommandsOfCopyImageDataToTexture(m_commandBuffer, w, h, m_bufferDynamic, m_targetImage.getpImage(), m_queryPool);
+        Log() << "\t\t feeding 1st texture our target image\n";
+        Submit(m_commandBuffer);
+    }
+
+    if (m_fireflyThreshold > 0.0f)
+    {
+        // TEXTURE => FIREFLY BUFFER (CLEANING) => TEXTURE (COPYING)
+        vkResetCommandBuffer(m_commandBuffer, 0);
+        RecordCommandsOfFirefly(m_commandBuffer, m_fireflyPipeline, m_fireflyPipelineLayout, m_descriptorSetFirefly,
+                w, h, m_fireflyThreshold, m_fireflyMedian, m_queryPool);
+        Log() << "\t\t removing fireflies\n";
+        Submit(m_commandBuffer);
+
+        vkResetCommandBuffer(m_commandBuffer, 0);
+        RecordCommandsOfCopyImageDataToTexture(m_commandBuffer, w, h, m_bufferFirefly, m_targetImage.getpImage(), m_queryPool);
+        Submit(m_commandBuffer);
+    }
+
+    if (m_guideLayers > 0)
+    {
+        Log() << "\t\t feeding " << a_frames.layerData.size() << " layers to the guide buffer\n";
+        UploadGuides(a_frames);
+    }
+
+    if (m_nlmFilter && !pyramid && !m_sparse && m_sweepParams.empty())
+    {
+        // weights are accumulated over frames, previous tile must not leak into this one
+        void *mappedMemory = nullptr;
+        vkMapMemory(m_device, m_bufferMemoryWeights, 0, VK_WHOLE_SIZE, 0, &mappedMemory);
+        memset(mappedMemory, 0, WeightSize() * w * h);
+        vkUnmapMemory(m_device, m_bufferMemoryWeights);
+    }
+
+    if (m_sparse)
+    {
+        // builds the list of noisy tiles, clean tiles are copied through (or become normalized weights)
+        vkResetCommandBuffer(m_commandBuffer, 0);
+        RecordCommandsOfClassifyTiles(m_commandBuffer, m_classifyPipeline, m_classifyPipelineLayout, m_descriptorSet,
+                m_descriptorSetTiles, m_bufferTiles, w, h, m_sparseThreshold, m_queryPool, m_workgroupSize);
+        Log() << "\t\t classifying tiles\n";
+        Submit(m_commandBuffer);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tperforming computations\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    if (!m_sweepParams.empty())
+    {
+        ExecuteSweep(w, h);
+    }
+    else if (pyramid)
+    {
+        RecordCommandsOfPyramid(m_commandBuffer, m_pipeline, m_pipelineLayout, m_descriptorSet,
+                bufferSize, m_bufferGPU, bufferStaging, pyramidLevels, m_queryPool, m_filterParams, m_workgroupSize);
+        Submit(m_commandBuffer);
+    }
+    else if (atrous)
+    {
+        RecordCommandsOfAtrous(m_commandBuffer, m_pipeline, m_pipelineLayout, m_descriptorSet,
+                bufferSize, m_bufferGPU, bufferStaging, w, h, m_atrousIterations, FindAtrousGuides(a_frames),
+                m_queryPool, m_filterParams, m_workgroupSize);
+        Submit(m_commandBuffer);
+    }
+    else if (guided)
+    {
+        RecordCommandsOfGuided(m_commandBuffer, m_pipeline, m_pipelineLayout, m_descriptorSet,
+                bufferSize, m_bufferGPU, bufferStaging, w, h, m_guidedRadius, m_guidedEpsilon,
+                (m_guidedLayer.empty()) ? -1 : FindLayer(a_frames, m_guidedLayer), m_queryPool, m_workgroupSize);
+        Submit(m_commandBuffer);
+    }
+    else if (m_ycbcr)
+    {
+        RecordCommandsOfYCbCr(m_commandBuffer, m_pipeline, m_pipelineLayout, m_descriptorSet,
+                bufferSize, m_bufferGPU, bufferStaging, w, h, m_queryPool, m_filterParams, m_workgroupSize);
+        Submit(m_commandBuffer);
+    }
+    else if (m_nlmFilter)
+    {
+        if (m_execAndCopyOverlap)
+        {
+            if (m_isHDR)
+            {
+                LoadImageDataToBuffer(m_device, m_physicalDevice, imageDataHDR[0], w, h, m_bufferMemoryTexel, m_bufferMemoryDynamic, false, m_half);
+            }
+            else
+            {
+                LoadImageDataToBuffer(m_device, m_physicalDevice, imageData[0], w, h, m_bufferMemoryTexel, m_bufferMemoryDynamic, false);
+            }
+
+            vkResetCommandBuffer(m_commandBuffer, 0);
+            RecordCommandsOfCopyImageDataToTexture(m_commandBuffer, w, h, m_bufferDynamic, m_neighbourImage.getpImage(), m_queryPool);
+            Submit(m_commandBuffer);
+
+            for (int ii{1}; ii < framesToUse; ++ii)
+            {
+                // We are going to copy this frame to the texture while doing computations using previous frame
+                if (m_isHDR)
+                {
+                    LoadImageDataToBuffer(m_device, m_physicalDevice, imageDataHDR[ii], w, h, m_bufferMemoryTexel, m_bufferMemoryDynamic, false, m_half);
+                }
+                else
+                {
+                    LoadImageDataToBuffer(m_device, m_physicalDevice, imageData[ii], w, h, m_bufferMemoryTexel, m_bufferMemoryDynamic, false);
+                }
+
+                vkResetCommandBuffer(m_commandBuffer, 0);
+                RecordCommandsOfOverlappingNLM(m_commandBuffer, w, h, m_bufferDynamic,
+                        (ii % 2 == 0) ? m_neighbourImage.getpImage() : m_neighbourImage2.getpImage(),
+                        (ii % 2 == 0) ? m_descriptorSet3             : m_descriptorSet,
+                        m_pipeline, m_pipelineLayout, m_queryPool, m_filterParams, m_workgroupSize, m_bufferTiles, m_descriptorSetTiles);
+                Submit(m_commandBuffer);
+            }
+        }
+        else
+        {
+            // loop for LDR images
+            for (auto frameData : imageData)
+            {
+                Log() << "\t\t feeding image to texture\n";
+
+                LoadImageDataToBuffer(m_device, m_physicalDevice, frameData, w, h, m_bufferMemoryTexel, m_bufferMemoryDynamic, false);
+
+                vkResetCommandBuffer(m_commandBuffer, 0);
+                RecordCommandsOfCopyImageDataToTexture(m_commandBuffer, w, h, m_bufferDynamic, m_neighbourImage.getpImage(), m_queryPool);
+                Submit(m_commandBuffer);
+
+                vkResetCommandBuffer(m_commandBuffer, 0);
+                RecordCommandsOfExecuteNLM(m_commandBuffer, m_pipeline, m_pipelineLayout, m_descriptorSet, w, h, m_queryPool, true, m_filterParams,
+                        m_workgroupSize, m_bufferTiles, m_descriptorSetTiles);
+                Submit(m_commandBuffer);
+
+                // preloaded frames may hold neighbours even if multiframe is off
+                if (!m_multiframe) break;
+            }
+
+            // loop for HDR images
+            for (auto frameData : imageDataHDR)
+            {
+                Log() << "\t\t feeding image to texture\n";
+
+                LoadImageDataToBuffer(m_device, m_physicalDevice, frameData, w, h, m_bufferMemoryTexel, m_bufferMemoryDynamic, false, m_half);
+
+                vkResetCommandBuffer(m_commandBuffer, 0);
+                RecordCommandsOfCopyImageDataToTexture(m_commandBuffer, w, h, m_bufferDynamic, m_neighbourImage.getpImage(), m_queryPool);
+                Submit(m_commandBuffer);
+
+                vkResetCommandBuffer(m_commandBuffer, 0);
+                RecordCommandsOfExecuteNLM(m_commandBuffer, m_pipeline, m_pipelineLayout, m_descriptorSet, w, h, m_queryPool, true, m_filterParams,
+                        m_workgroupSize, m_bufferTiles, m_descriptorSetTiles);
+                Submit(m_commandBuffer);
+
+                // preloaded frames may hold neighbours even if multiframe is off
+                if (!m_multiframe) break;
+            }
+        }
+
+        vkResetCommandBuffer(m_commandBuffer2, 0);
+        RecordCommandsOfExecuteAndTransfer(m_commandBuffer2, m_pipeline2, m_pipelineLayout2, m_descriptorSet2,
+                bufferSize, m_bufferGPU, bufferStaging, w, h, m_queryPool, true, m_filterParams, m_workgroupSize);
+        Submit(m_commandBuffer2);
+    }
+    else // in case of plain bialteral (layers are bound to the same dispatch)
+    {
+        RecordCommandsOfExecuteAndTransfer(m_commandBuffer, m_pipeline, m_pipelineLayout, m_descriptorSet,
+                bufferSize, m_bufferGPU, bufferStaging, w, h, m_queryPool, false, m_filterParams, m_workgroupSize,
+                m_bufferTiles, m_descriptorSetTiles);
+        Submit(m_commandBuffer);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tgetting image back\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    if (m_sparse)
+    {
+        void *mappedMemory = nullptr;
+        vkMapMemory(m_device, m_bufferMemoryTiles, 0, sizeof(uint32_t), 0, &mappedMemory);
+        m_activeTiles += *((uint32_t*)mappedMemory);
+        vkUnmapMemory(m_device, m_bufferMemoryTiles);
+    }
+
+    if (a_result != nullptr)
+    {
+        GetImageFromGPU(m_device, (m_unifiedMemory) ? m_bufferMemoryGPU : m_bufferMemoryStaging, w, h, a_result, m_half);
+    }
+}
+
+void ComputeApplication::ExecuteSweep(int a_w, int a_h)
+{
+    const size_t bufferSize{ OutputPixelSize() * a_w * a_h };
+    const size_t batch{ std::min(m_sweepParams.size(), std::max<size_t>(1, SWEEP_BATCH_BYTES / bufferSize)) };
+
+    if (m_sweepBufferSize < batch * bufferSize)
+    {
+        if (m_bufferSweep != VK_NULL_HANDLE)
+        {
+            vkFreeMemory   (m_device, m_bufferMemorySweep, NULL);
+            vkDestroyBuffer(m_device, m_bufferSweep, NULL);
+        }
+
+        CreateStagingBuffer(m_device, m_physicalDevice, batch * bufferSize, &m_bufferSweep, &m_bufferMemorySweep);
+        m_sweepBufferSize = batch * bufferSize;
+    }
+
+    if (m_nlmFilter)
+    {
+        // single frame NLM compares the target frame with itself, the dynamic buffer still holds it
+        vkResetCommandBuffer(m_commandBuffer, 0);
+        RecordCommandsOfCopyImageDataToTexture(m_commandBuffer, a_w, a_h, m_bufferDynamic, m_neighbourImage.getpImage(), m_queryPool);
+        Submit(m_commandBuffer);
+    }
+
+    m_sweepResults.assign(m_sweepParams.size(), std::vector<Pixel>(size_t(a_w) * a_h));
+
+    Log() << "\t\t sweeping " << m_sweepParams.size() << " parameter sets, " << batch << " per command buffer\n";
+    telemetry::Progress progress{ "sweep", m_sweepParams.size(), "sets", m_verbose };
+
+    for (size_t first{}; first < m_sweepParams.size(); first += batch)
+    {
+        const size_t count{ std::min(batch, m_sweepParams.size() - first) };
+
+        vkResetCommandBuffer(m_commandBuffer, 0);
+        RecordCommandsOfSweep(m_commandBuffer, m_pipeline, m_pipelineLayout, m_descriptorSet,
+                m_pipeline2, m_pipelineLayout2, m_descriptorSet2, (m_nlmFilter) ? m_bufferWeights : VK_NULL_HANDLE,
+                bufferSize, m_bufferGPU, m_bufferSweep, a_w, a_h, m_queryPool, &m_sweepParams[first], count, m_workgroupSize);
+        Submit(m_commandBuffer);
+
+        void *mappedMemory = nullptr;
+        vkMapMemory(m_device, m_bufferMemorySweep, 0, count * bufferSize, 0, &mappedMemory);
+
+        for (size_t i{}; i < count; ++i)
+        {
+            const char* slot{ (const char*)mappedMemory + i * bufferSize };
+
+            if (m_half)
+            {
+                pixel_format::Rgba16FToRgba32F((const uint16_t*)slot, (float*)m_sweepResults[first + i].data(), size_t(a_w) * a_h);
+            }
+            else
+            {
+                pixel_format::Copy(slot, m_sweepResults[first + i].data(), bufferSize);
+            }
+        }
+
+        vkUnmapMemory(m_device, m_bufferMemorySweep);
+        progress.Advance(count);
+    }
+
+    progress.Finish();
+}
+
+void ComputeApplication::CreateResources(int a_w, int a_h, const std::vector<PyramidLevel>& a_pyramidLevels)
+{
+    const bool   pyramid{ m_pyramidLevels > 1 };
+    const bool   atrous{ m_atrousIterations > 0 };
+    const bool   guided{ m_guidedRadius > 0 };
+    const size_t bufferSizePyramid{ 2 * sizeof(Pixel) * (a_pyramidLevels.back().offset + a_pyramidLevels.back().w * a_pyramidLevels.back().h) };
+    const size_t bufferSize{OutputPixelSize() * a_w * a_h};
+    const size_t bufferSizeWeights{WeightSize() * a_w * a_h}; // GLSL alignment
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tcreating io buffers/images of our shaders\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    // NOTE: INPUT BUFFER/IMAGE FOR SHADERS
+    if (m_linear)
+    {
+        CreateTexelBuffer(m_device, m_physicalDevice, bufferSize, &m_bufferTexel, &m_bufferMemoryTexel, m_unifiedMemory);
+        CreateTexelBufferView(m_device, bufferSize, m_bufferTexel, &m_texelBufferView, m_isHDR);
+        Log() << "\t\tlinear buffer created\n";
+    }
+    else
+    {
+        // for image #0
+        m_targetImage.create(m_device, m_physicalDevice, a_w, a_h, m_isHDR, m_half);
+        if (m_nlmFilter && !pyramid)
+        {
+            // for image #k [0..framesToUse]
+            m_neighbourImage.create(m_device, m_physicalDevice, a_w, a_h, m_isHDR, m_half);
+            if (m_execAndCopyOverlap)
+            {
+                m_neighbourImage2.create(m_device, m_physicalDevice, a_w, a_h, m_isHDR, m_half);
+            }
+        }
+        Log() << "\t\tnon-linear texture created\n";
+    }
+
+    if (m_nlmFilter && !pyramid)
+    {
+        CreateWeightBuffer(m_device, m_physicalDevice, bufferSizeWeights, &m_bufferWeights, &m_bufferMemoryWeights);
+    }
+
+    // NOTE: OUTPUT BUFFER FOR GPU (device local) [for result image]
+    CreateWriteOnlyBuffer(m_device, m_physicalDevice, bufferSize, &m_bufferGPU, &m_bufferMemoryGPU, m_unifiedMemory);
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tcreating descriptor sets for created resourses\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    if (pyramid)
+    {
+        // all levels live in one device local buffer, so the output buffer helper fits
+        CreateWriteOnlyBuffer(m_device, m_physicalDevice, bufferSizePyramid, &m_bufferPyramid, &m_bufferMemoryPyramid);
+
+        CreateDescriptorSetLayoutPyramid(m_device, &m_descriptorSetLayout);
+        CreateDescriptorSetPyramid(m_device, m_bufferPyramid, bufferSizePyramid, m_bufferGPU, bufferSize, m_targetImage,
+                &m_descriptorSetLayout, &m_descriptorPool, &m_descriptorSet);
+    }
+    else if (m_nlmFilter)
+    {
+        // DS for recording weighted pixels for result image
+        CreateDescriptorSetLayoutNLM(m_device, &m_descriptorSetLayout, m_linear, false);
+        CreateDescriptorSetNLM(m_device, m_bufferWeights, bufferSizeWeights, &m_descriptorSetLayout,
+                m_targetImage, m_neighbourImage, &m_descriptorPool, &m_descriptorSet);
+
+        if (m_execAndCopyOverlap)
+        {
+            CreateDescriptorSetNLM(m_device, m_bufferWeights, bufferSizeWeights, &m_descriptorSetLayout,
+                    m_targetImage, m_neighbourImage2, &m_descriptorPool3, &m_descriptorSet3);
+        }
+
+        // DS for building result image (by normalizing)
+        CreateDescriptorSetLayoutNLM(m_device, &m_descriptorSetLayout2, m_linear, true);
+        CreateDescriptorSetNLM2(m_device, m_bufferGPU, bufferSize, &m_descriptorSetLayout2,
+                m_bufferWeights, bufferSizeWeights, &m_descriptorPool2, &m_descriptorSet2);
+
+        // we use sepparate ds pools for each set
+    }
+    else if (m_useLayers || atrous || guided)
+    {
+        // every layer in one buffer, the joint bialteral, a-trous and guided kernels read them all in one dispatch
+        const size_t bufferSizeGuides{ GuideBufferSize(a_w, a_h, m_guideLayers) };
+
+        CreateGuideBuffer(m_device, m_physicalDevice, bufferSizeGuides, &m_bufferGuides, &m_bufferMemoryGuides, m_unifiedMemory);
+        if (!m_unifiedMemory)
+        {
+            CreateDynamicBuffer(m_device, m_physicalDevice, bufferSizeGuides, &m_bufferGuidesUpload, &m_bufferMemoryGuidesUpload);
+        }
+
+        // a-trous: iterations between the first and the last one stay on the GPU,
+        // guided: row and column prefix sums of 8 channels
+        const size_t bufferSizePingPong{ (guided) ? 4 * bufferSize : 2 * bufferSize };
+        if (atrous || guided)
+        {
+            CreateWriteOnlyBuffer(m_device, m_physicalDevice, bufferSizePingPong, &m_bufferPingPong, &m_bufferMemoryPingPong);
+        }
+
+        CreateDescriptorSetLayoutGuides(m_device, &m_descriptorSetLayout, atrous || guided);
+        CreateDescriptorSetGuides(m_device, m_bufferGPU, bufferSize, &m_descriptorSetLayout, m_targetImage,
+                m_bufferGuides, bufferSizeGuides, &m_descriptorPool, &m_descriptorSet, m_bufferPingPong, bufferSizePingPong);
+    }
+    else if (m_ycbcr)
+    {
+        // the layout of the pyramid mode fits: scratch planes, output buffer and texture
+        const size_t bufferSizeScratch{ YCbCrScratchSize(a_w, a_h) };
+        CreateWriteOnlyBuffer(m_device, m_physicalDevice, bufferSizeScratch, &m_bufferPingPong, &m_bufferMemoryPingPong);
+
+        CreateDescriptorSetLayoutPyramid(m_device, &m_descriptorSetLayout);
+        CreateDescriptorSetPyramid(m_device, m_bufferPingPong, bufferSizeScratch, m_bufferGPU, bufferSize, m_targetImage,
+                &m_descriptorSetLayout, &m_descriptorPool, &m_descriptorSet);
+    }
+    else
+    {
+        CreateDescriptorSetLayoutBialteral(m_device, &m_descriptorSetLayout, m_linear);
+        CreateDescriptorSetBialteral(m_device, m_bufferGPU, bufferSize, &m_descriptorSetLayout,
+                m_targetImage, m_bufferTexel, &m_texelBufferView,
+                &m_descriptorPool, &m_descriptorSet, m_linear);
+    }
+
+    if (m_fireflyThreshold > 0.0f)
+    {
+        // the pre-pass reads the target image and writes this buffer, which is then copied back to the image;
+        // the layout of the plain bialteral filter (output buffer + texture) fits
+        CreateWriteOnlyBuffer(m_device, m_physicalDevice, bufferSize, &m_bufferFirefly, &m_bufferMemoryFirefly);
+
+        CreateDescriptorSetLayoutBialteral(m_device, &m_descriptorSetLayoutFirefly);
+        CreateDescriptorSetBialteral(m_device, m_bufferFirefly, bufferSize, &m_descriptorSetLayoutFirefly,
+                m_targetImage, VK_NULL_HANDLE, nullptr, &m_descriptorPoolFirefly, &m_descriptorSetFirefly);
+    }
+
+    if (m_sparse)
+    {
+        const size_t bufferSizeTiles{(4 + m_totalTiles) * sizeof(uint32_t)};
+
+        CreateTileBuffer(m_device, m_physicalDevice, bufferSizeTiles, &m_bufferTiles, &m_bufferMemoryTiles);
+        CreateDescriptorSetTiles(m_device, m_bufferTiles, bufferSizeTiles, &m_descriptorSetLayoutTiles,
+                &m_descriptorPoolTiles, &m_descriptorSetTiles);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tcompiling shaders\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    if (m_sparse)
+    {
+        // classify pass binds the DS of the filter: output (or weights) buffer and target image
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_classifyShaderModule, &m_classifyPipeline, &m_classifyPipelineLayout,
+                (m_linear) ? "shaders/classify_linear.spv" : (m_nlmFilter) ? "shaders/classify_weights.spv" : "shaders/classify.spv",
+                2 * sizeof(int) + sizeof(float), m_workgroupSize, m_descriptorSetLayoutTiles); // pc: width (i), height (i), threshold (f)
+    }
+
+    if (m_fireflyThreshold > 0.0f)
+    {
+        // firefly.comp has a fixed workgroup size, the specialization constants are ignored
+        CreateComputePipelines(m_device, m_descriptorSetLayoutFirefly, &m_fireflyShaderModule, &m_fireflyPipeline, &m_fireflyPipelineLayout,
+                (m_isHDR) ? "shaders/firefly.spv" : "shaders/firefly_ldr.spv",
+                3 * sizeof(int) + sizeof(float), m_workgroupSize); // pc: width (i), height (i), mode (i), threshold (f)
+    }
+
+    if (pyramid)
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                (m_nlmFilter) ? "shaders/pyramid_nlm.spv" : "shaders/pyramid.spv",
+                8 * sizeof(int) + 3 * sizeof(float), m_workgroupSize); // pc: see RecordCommandsOfPyramid
+    }
+    else if (atrous)
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                "shaders/atrous.spv", 8 * sizeof(int) + sizeof(float), m_workgroupSize); // pc: see RecordCommandsOfAtrous
+    }
+    else if (guided)
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                "shaders/guided.spv", 6 * sizeof(int) + sizeof(float), m_workgroupSize); // pc: see RecordCommandsOfGuided
+    }
+    else if (m_nlmFilter && m_half)
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                (m_halfNative) ? "shaders/nonlocal_half_native.spv" : "shaders/nonlocal_half.spv",
+                2 * sizeof(int) + sizeof(float), m_workgroupSize, m_descriptorSetLayoutTiles); // pc: width (i), height (i), flitering param (f)
+        CreateComputePipelines(m_device, m_descriptorSetLayout2, &m_computeShaderModule2, &m_pipeline2, &m_pipelineLayout2,
+                (m_halfNative) ? "shaders/normalize_half_native.spv" : "shaders/normalize_half.spv",
+                2 * sizeof(int), m_workgroupSize); // pc: width (i), height (i)
+    }
+    else if (m_nlmFilter)
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                (m_sparse) ? "shaders/nonlocal_sparse.spv" : "shaders/nonlocal.spv",
+                2 * sizeof(int) + sizeof(float), m_workgroupSize, m_descriptorSetLayoutTiles); // pc: width (i), height (i), flitering param (f)
+        CreateComputePipelines(m_device, m_descriptorSetLayout2, &m_computeShaderModule2, &m_pipeline2, &m_pipelineLayout2,
+                "shaders/normalize.spv", 2 * sizeof(int), m_workgroupSize); // pc: width (i), height (i)
+    }
+    else if (m_useLayers)
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                (m_sparse) ? "shaders/bialteral_layers_sparse.spv" : "shaders/bialteral_layers.spv",
+                2 * sizeof(int) + 2 * sizeof(float), m_workgroupSize, m_descriptorSetLayoutTiles); // pc: width (i), height (i), spatialSigma (f), colorSigma (f)
+    }
+    else if (m_ycbcr)
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                "shaders/bialteral_ycbcr.spv", 3 * sizeof(int) + 2 * sizeof(float), m_workgroupSize); // pc: see RecordCommandsOfYCbCr
+    }
+    else if (m_half)
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                (m_halfNative) ? "shaders/bialteral_half_native.spv" : "shaders/bialteral_half.spv",
+                2 * sizeof(int) + 2 * sizeof(float), m_workgroupSize, m_descriptorSetLayoutTiles); // pc: width (i), height (i), spatialSigma (f), colorSigma (f)
+    }
+    else
+    {
+        CreateComputePipelines(m_device, m_descriptorSetLayout, &m_computeShaderModule, &m_pipeline, &m_pipelineLayout,
+                (m_linear) ? ((m_sparse) ? "shaders/bialteral_linear_sparse.spv" : "shaders/bialteral_linear.spv")
+                           : ((m_sparse) ? "shaders/bialteral_sparse.spv" : "shaders/bialteral.spv"),
+                2 * sizeof(int) + 2 * sizeof(float), m_workgroupSize, m_descriptorSetLayoutTiles); // pc: width (i), height (i), spatialSigma (f), colorSigma (f)
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tcreating command buffers\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    CreateCommandBuffer(m_device, m_sharedDevice->queueFamilyIndex, m_pipeline, m_pipelineLayout, &m_commandPool, &m_commandBuffer);
+
+    if (m_nlmFilter && !pyramid)
+    {
+        CreateCommandBuffer(m_device, m_sharedDevice->queueFamilyIndex, m_pipeline2, m_pipelineLayout2, &m_commandPool2, &m_commandBuffer2);
+    }
+
+#ifdef QUERY_TIME
+    CreateQueryPool(m_device, &m_queryPool);
+#endif
+}
+
+uint64_t ComputeApplication::TileKey(const SourceFrames& a_tile, int a_framesToUse) const
+{
+    struct Config {
+        uint32_t     version;     // bump when a shader changes its output
+        uint8_t      nlmFilter, linear, overlap, useLayers, sparse, isHDR, fireflyMedian, ycbcr, half, pad[3];
+        int32_t      framesToUse, pyramidLevels, atrousIterations, guidedRadius, guidedLayer, w, h;
+        float        sparseThreshold, guidedEpsilon, fireflyThreshold;
+        FilterParams filterParams;
+        uint32_t     workgroupX, workgroupY; // sparse tiles are workgroups
+    } config{};
+
+    config.version       = 4;
+    config.nlmFilter     = m_nlmFilter;
+    config.linear        = m_linear;
+    config.overlap       = m_execAndCopyOverlap;
+    config.useLayers     = m_useLayers;
+    config.sparse        = m_sparse;
+    config.isHDR         = a_tile.isHDR;
+    config.framesToUse   = a_framesToUse;
+    config.pyramidLevels = m_pyramidLevels;
+    config.atrousIterations = m_atrousIterations;
+    config.guidedRadius  = m_guidedRadius;
+    config.guidedEpsilon = (m_guidedRadius > 0) ? m_guidedEpsilon : 0.0f;
+    config.guidedLayer   = (m_guidedRadius > 0 && !m_guidedLayer.empty()) ? FindLayer(a_tile, m_guidedLayer) : -1;
+    config.w             = a_tile.w;
+    config.h             = a_tile.h;
+    config.sparseThreshold = (m_sparse) ? m_sparseThreshold : 0.0f;
+    config.fireflyThreshold = m_fireflyThreshold;
+    config.fireflyMedian = (m_fireflyThreshold > 0.0f) && m_fireflyMedian;
+    config.ycbcr         = m_ycbcr;
+    config.half          = m_half;
+    config.filterParams  = m_filterParams;
+    config.workgroupX    = m_workgroupSize.x;
+    config.workgroupY    = m_workgroupSize.y;
+
+    uint64_t key{ TileCache::Hash(&config, sizeof(config), 0) };
+
+    for (int i{}; i < a_framesToUse && i < int(a_tile.imageData.size()); ++i)
+    {
+        key = TileCache::Hash(a_tile.imageData[i].data(), a_tile.imageData[i].size() * sizeof(unsigned int), key);
+    }
+
+    for (int i{}; i < a_framesToUse && i < int(a_tile.imageDataHDR.size()); ++i)
+    {
+        key = TileCache::Hash(a_tile.imageDataHDR[i].data(), a_tile.imageDataHDR[i].size() * sizeof(Pixel), key);
+    }
+
+    if (m_guideLayers > 0)
+    {
+        for (const auto& layer : a_tile.layerData)
+        {
+            key = TileCache::Hash(layer.data(), layer.size() * sizeof(unsigned int), key);
+        }
+
+        // a-trous takes the roles of the layers (normal, depth, albedo) from their file names
+        for (const std::string& name : a_tile.layerNames)
+        {
+            key = TileCache::Hash(name.c_str(), name.size() + 1, key);
+        }
+
+        if (m_useLayers && !m_guideWeights.empty())
+        {
+            key = TileCache::Hash(m_guideWeights.data(), m_guideWeights.size() * sizeof(float), key);
+        }
+    }
+
+    return key;
+}
+
+std::ostream& ComputeApplication::Log() const
+{
+    // no buffer: writes only set its state, one per thread since workers log at once
+    thread_local std::ostream silent{nullptr};
+    return (m_verbose) ? std::cout : silent;
+}
+
+std::string ComputeApplication::OutputFileName() const
+{
+    if (!m_outputPath.empty())
+    {
+        return m_outputPath;
+    }
+
+    std::string outputFileName{"output"};
+    outputFileName += (m_linear) ?             "-linear"     : "-nonlinear";
+    outputFileName += (m_nlmFilter) ?          "-nlm"        : "-bialteral";
+    outputFileName += (m_multiframe) ?         "-multiframe" : "";
+    outputFileName += (m_execAndCopyOverlap) ? "-overlap"    : "";
+    outputFileName += (m_useLayers) ?          "-layers"     : "";
+    outputFileName += (m_sparse) ?             "-sparse"     : "";
+    outputFileName += (m_pyramidLevels > 1) ?  "-pyramid"    : "";
+    outputFileName += (m_atrousIterations > 0) ? "-atrous"   : "";
+    outputFileName += (m_guidedRadius > 0) ?   "-guided"     : "";
+    outputFileName += (m_ycbcr) ?              "-ycbcr"      : "";
+    outputFileName += (m_half) ?               "-fp16"       : "";
+
+    return outputFileName + ((m_isHDR) ? ".exr" : ".png");
+}
+
+std::string ComputeApplication::SweepFileName(size_t a_index) const
+{
+    std::filesystem::path path{ OutputFileName() };
+    path.replace_filename(path.stem().string() + "-sweep" + std::to_string(a_index) + path.extension().string());
+    return path.string();
+}
+
+void ComputeApplication::SaveImage(const std::string& a_fileName, const std::vector<Pixel>& a_pixels, int a_w, int a_h, bool a_isHDR)
+{
+    const int w{a_w}, h{a_h};
+
+    if (a_isHDR)
+    {
+        const char* err = nullptr;
+
+        // Pixel is interleaved RGBA32F already
+        int ret = SaveEXR((const float*)a_pixels.data(), w, h, 4, 0, a_fileName.c_str(), &err);
+
+        if (ret != TINYEXR_SUCCESS)
+        {
+            const std::string message{ (err) ? err : "can't save " + a_fileName };
+            if (err)
+            {
+                FreeEXRErrorMessage(err);
+            }
+            throw(std::runtime_error(message));
+        }
+    }
+    else
+    {
+        std::vector<unsigned char> resultData(w * h * 4);
+        pixel_format::Rgba32FToRgba8((const float*)a_pixels.data(), resultData.data(), size_t(w) * h);
+
+        unsigned error = lodepng::encode(a_fileName.c_str(), resultData, (unsigned)w, (unsigned)h);
+
+        if (error) throw(std::runtime_error(lodepng_error_text(error)));
+    }
+}
+
+void ComputeApplication::RunOnGPU(bool nlmFilter, bool nonlinear, bool multiframe, bool execAndCopyOverlap, bool useLayers)
+{
+    // Set members (bad design goes brrrrr)
+    m_nlmFilter = nlmFilter;
+    m_linear = !nonlinear;
+    m_multiframe = multiframe;
+    m_execAndCopyOverlap = execAndCopyOverlap;
+    m_useLayers = useLayers;
+    assert(m_nlmFilter || !multiframe);
+    assert(multiframe || !execAndCopyOverlap);
+
+    if (m_pyramidLevels > 1 && (m_linear || multiframe || useLayers || m_sparse))
+    {
+        RUN_TIME_ERROR("pyramid mode works only with single frame texture input (no layers, no sparse dispatch)");
+    }
+
+    const bool atrous{ m_atrousIterations > 0 };
+    if (atrous && (m_nlmFilter || m_linear || multiframe || useLayers || m_sparse || m_pyramidLevels > 1))
+    {
+        RUN_TIME_ERROR("a-trous mode works only with single frame texture input (it loads the layers itself)");
+    }
+
+    const bool guided{ m_guidedRadius > 0 };
+    if (guided && (m_nlmFilter || m_linear || multiframe || useLayers || m_sparse || m_pyramidLevels > 1 || atrous))
+    {
+        RUN_TIME_ERROR("guided filter mode works only with single frame texture input (it loads its guide layer itself)");
+    }
+
+    if (m_ycbcr && (m_nlmFilter || m_linear || multiframe || useLayers || m_sparse || m_pyramidLevels > 1 || atrous || guided))
+    {
+        RUN_TIME_ERROR("YCbCr mode works only with the plain bialteral filter on texture input");
+    }
+
+    if (m_fireflyThreshold > 0.0f && m_linear)
+    {
+        RUN_TIME_ERROR("firefly pre-pass works only with texture input");
+    }
+
+    const bool hostFrame{ m_hostFrame.input != nullptr };
+    if (hostFrame && (multiframe || useLayers))
+    {
+        RUN_TIME_ERROR("host frames carry a single frame without layers");
+    }
+
+    const bool sweep{ !m_sweepParams.empty() };
+    if (sweep && (multiframe || m_sparse || m_pyramidLevels > 1 || atrous || guided || m_ycbcr || hostFrame || m_tileSize > 0 || m_tileCache))
+    {
+        RUN_TIME_ERROR("sweep mode works only with the plain bialteral (texture, texel buffer or layers) and single frame NLM filters, without tiles");
+    }
+    m_sweepResults.clear();
+    m_inputImported  = false;
+    m_outputImported = false;
+    m_execTimeElapsed = 0;
+    m_transferTimeElapsed = 0;
+    m_activeTiles = 0;
+    m_totalTiles = 0;
+    m_cachedTiles = 0;
+    m_frameTiles = 0;
+    //
+
+    const int deviceId{m_deviceId};
+
+    if (m_device != VK_NULL_HANDLE && (!m_keepDevice || m_sharedDevice->deviceId != deviceId))
+    {
+        // left by a failed run or by the warm mode on another device
+        Cleanup();
+    }
+
+    if (m_device != VK_NULL_HANDLE)
+    {
+        Log() << "\twarm vulkan device " << deviceId << "\n";
+    }
+    else
+    {
+        if (m_sharedDevice)
+        {
+            Log() << "\tshared vulkan device " << deviceId << "\n";
+        }
+        else
+        {
+            Log() << "\tinit vulkan for device " << deviceId << "\n";
+
+            // host frames are imported as they are when the device can do that,
+            // a warm device enables the import up front since it outlives the current frame
+            m_sharedDevice = CreateSharedDevice(deviceId, hostFrame || m_keepDevice);
+        }
+
+        m_instance        = m_sharedDevice->instance;
+        m_physicalDevice  = m_sharedDevice->physicalDevice;
+        m_device          = m_sharedDevice->device;
+        m_queue           = m_sharedDevice->queue;
+        m_deviceName      = m_sharedDevice->deviceName;
+        m_timestampPeriod = m_sharedDevice->timestampPeriod;
+    }
+
+    const VkDeviceSize hostPointerAlignment{ (hostFrame) ? m_sharedDevice->hostPointerAlignment : 0 };
+
+    // imported output is written by a copy, so it replaces the unified memory path
+    m_unifiedMemory = m_zeroCopy && hostPointerAlignment == 0 && HasUnifiedMemory(m_device, m_physicalDevice);
+    if (m_unifiedMemory)
+    {
+        Log() << "\tunified memory: zero-copy input/output buffers\n";
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tloading image data\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    const bool   preloaded{ !m_sourceFrames.imageData.empty() || !m_sourceFrames.imageDataHDR.empty() };
+    SourceFrames loadedFrames{};
+
+    if (hostFrame)
+    {
+        // pixels are imported or copied once the resources are known
+        loadedFrames.w     = m_hostFrame.w;
+        loadedFrames.h     = m_hostFrame.h;
+        loadedFrames.isHDR = m_hostFrame.isHDR;
+    }
+    else if (!preloaded)
+    {
+        LoadSourceFrames(loadedFrames, m_multiframe, m_useLayers || atrous || (guided && !m_guidedLayer.empty()));
+    }
+
+    const SourceFrames& frames{ (preloaded && !hostFrame) ? m_sourceFrames : loadedFrames };
+    const std::vector<std::vector<unsigned int>>& imageData{ frames.imageData };
+    const std::vector<std::vector<unsigned int>>& layerData{ frames.layerData };
+    const std::vector<std::vector<Pixel>>&        imageDataHDR{ frames.imageDataHDR };
+    const int w{ frames.w }, h{ frames.h };
+    m_isHDR = frames.isHDR;
+
+    const int framesToUse{(multiframe) ? std::min(10, int(imageData.size() + imageDataHDR.size())) : 1};
+
+    // FP16 mode has shaders for the plain bialteral and NLM filters only, anything else runs in FP32
+    std::string halfFallback{};
+    if (!m_isHDR)
+    {
+        halfFallback = "LDR input is 8 bit already";
+    }
+    else if (m_linear || m_sparse || m_pyramidLevels > 1 || atrous || guided || m_ycbcr || useLayers)
+    {
+        halfFallback = "the mode has no FP16 shaders";
+    }
+    else if (m_fireflyThreshold > 0.0f)
+    {
+        halfFallback = "the firefly pre-pass writes FP32 texels";
+    }
+    else if (hostFrame)
+    {
+        halfFallback = "host frames are FP32";
+    }
+    else if (!HasHalfTextures(m_physicalDevice))
+    {
+        halfFallback = "the device cannot sample RGBA16F images";
+    }
+
+    m_half       = m_halfRequested && halfFallback.empty();
+    m_halfNative = m_half && m_sharedDevice->halfNative;
+    if (m_half)
+    {
+        Log() << "\tFP16 storage" << ((m_halfNative) ? " and arithmetic" : " (halves packed in uints)") << "\n";
+    }
+    else if (m_halfRequested)
+    {
+        Log() << "\tFP16 is not available (" << halfFallback << "), running in FP32\n";
+    }
+
+    m_guideLayers = (m_useLayers || atrous || (guided && !m_guidedLayer.empty())) ? int(layerData.size()) : 0;
+    if (m_useLayers && (m_guideLayers == 0 || m_guideLayers > MAX_GUIDE_LAYERS))
+    {
+        RUN_TIME_ERROR(("layers mode needs 1.." + std::to_string(MAX_GUIDE_LAYERS) + " RenderElements layers, found "
+                    + std::to_string(m_guideLayers)).c_str());
+    }
+
+    if (atrous)
+    {
+        if (m_guideLayers > MAX_GUIDE_LAYERS)
+        {
+            RUN_TIME_ERROR(("a-trous mode reads at most " + std::to_string(MAX_GUIDE_LAYERS) + " RenderElements layers").c_str());
+        }
+
+        const AtrousGuides guides{ FindAtrousGuides(frames) };
+        Log() << "\ta-trous edge-stopping: color"
+            << ((guides.normal >= 0) ? ", normal" : "") << ((guides.depth >= 0) ? ", depth" : "")
+            << ((guides.albedo >= 0) ? ", albedo" : "") << "\n";
+    }
+
+    if (guided && !m_guidedLayer.empty() && (m_guideLayers > MAX_GUIDE_LAYERS || FindLayer(frames, m_guidedLayer) < 0))
+    {
+        RUN_TIME_ERROR(("no RenderElements layer \"" + m_guidedLayer + "\" for the guided filter (or more than "
+                    + std::to_string(MAX_GUIDE_LAYERS) + " layers)").c_str());
+    }
+
+    // out-of-core mode: the GPU sees one padded tile at a time, so every resource below is sized by the tile
+    const bool pyramid{ m_pyramidLevels > 1 };
+    // the tile cache keys the tiles of this grid, or the whole frame when the run is not tiled
+    const int  requestedTile{ m_tileSize };
+    const bool tiled{ requestedTile > 0 && (requestedTile < w || requestedTile < h) };
+    const int  tileAlign{ (pyramid) ? (1 << (m_pyramidLevels - 1)) : 1 }; // keeps 2x2 downsampling in step with the whole image
+    const int  tileSize{ (requestedTile + tileAlign - 1) / tileAlign * tileAlign };
+    // the firefly pre-pass widens the window of the filter by its radius (rounded up to keep the alignment)
+    const int  fireflyApron{ (m_fireflyThreshold > 0.0f) ? (FIREFLY_RADIUS + tileAlign - 1) / tileAlign * tileAlign : 0 };
+    const int  apron{ (tiled) ? TileApron(m_nlmFilter, (pyramid) ? m_pyramidLevels : 0, m_atrousIterations, m_guidedRadius, m_ycbcr)
+        + fireflyApron : 0 };
+    const int  tileW{ (tiled) ? std::min(tileSize, w) : w }, tileH{ (tiled) ? std::min(tileSize, h) : h };
+    const int  gw{ tileW + 2 * apron }, gh{ tileH + 2 * apron };
+
+    const std::vector<PyramidLevel> pyramidLevels{ PyramidLevels(gw, gh, (pyramid) ? m_pyramidLevels : 1) };
+
+    if (pyramid && pyramidLevels.size() < 2)
+    {
+        RUN_TIME_ERROR("image is too small for pyramid mode");
+    }
+
+    const size_t bufferSize{OutputPixelSize() * gw * gh};
+
+    if (m_sparse)
+    {
+        // one tile per workgroup of the filter
+        m_totalTiles = uint32_t(ceil(gw / float(m_workgroupSize.x))) * uint32_t(ceil(gh / float(m_workgroupSize.y)));
+    }
+
+    // a warm device keeps the resources of the previous run while nothing they depend on changes
+    const RunKey runKey{ m_nlmFilter, m_linear, m_execAndCopyOverlap, m_useLayers, m_sparse, m_isHDR, m_unifiedMemory, guided,
+            m_fireflyThreshold > 0.0f, m_ycbcr, m_half, m_pyramidLevels, m_guideLayers, m_atrousIterations, gw, gh, m_workgroupSize.x, m_workgroupSize.y };
+
+    if (m_resourcesReady && runKey == m_runKey)
+    {
+        Log() << "\treusing buffers, images and pipelines of the previous run\n";
+    }
+    else
+    {
+        ReleaseResources();
+        CreateResources(gw, gh, pyramidLevels);
+        m_runKey         = runKey;
+        m_resourcesReady = true;
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tcreating transfer buffers\n";
+    //----------------------------------------------------------------------------------------------------------------------
+
+    if (hostPointerAlignment != 0)
+    {
+        // kept transfer buffers would shadow the caller memory
+        ReleaseTransferBuffers();
+    }
+
+    if (!m_linear && m_bufferDynamic == VK_NULL_HANDLE)
+    {
+        // caller memory is the upload source as it is (only filters that upload just the target frame)
+        m_inputImported = !m_nlmFilter && !tiled && !m_tileCache && CreateImportedHostBuffer(m_device, m_physicalDevice,
+                m_hostFrame.input, gw * gh * ((m_isHDR) ? sizeof(Pixel) : sizeof(int)), m_hostFrame.inputCapacity,
+                hostPointerAlignment, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, &m_bufferDynamic, &m_bufferMemoryDynamic);
+
+        if (!m_inputImported)
+        {
+            // we feed our textures this buffer's data
+            const size_t texelSize{ (m_half) ? HALF_PIXEL_SIZE : (m_isHDR) ? sizeof(Pixel) : sizeof(int) };
+            CreateDynamicBuffer(m_device, m_physicalDevice, gw * gh * texelSize, &m_bufferDynamic, &m_bufferMemoryDynamic);
+        }
+    }
+
+    if (hostFrame && !m_inputImported)
+    {
+        CopyHostFrame(m_hostFrame, loadedFrames);
+    }
+
+    // result is copied straight into the caller memory
+    m_outputImported = !tiled && !m_tileCache && m_bufferStaging == VK_NULL_HANDLE && CreateImportedHostBuffer(m_device, m_physicalDevice, m_hostFrame.output, bufferSize,
+            m_hostFrame.outputCapacity, hostPointerAlignment, VK_BUFFER_USAGE_TRANSFER_DST_BIT, &m_bufferStaging, &m_bufferMemoryStaging);
+
+    if (hostFrame)
+    {
+        Log() << "\thost frame: input " << ((m_inputImported) ? "imported" : "copied")
+            << ", output " << ((m_outputImported) ? "imported" : "copied") << "\n";
+    }
+
+    if (!m_unifiedMemory && m_bufferStaging == VK_NULL_HANDLE)
+    {
+        // BUFFER TO TAKE DATA FROM GPU
+        CreateStagingBuffer(m_device, m_physicalDevice, bufferSize, &m_bufferStaging, &m_bufferMemoryStaging);
+    }
+
+    std::vector<Pixel> resultHDRData((m_outputImported || sweep) ? 0 : w * h);
+
+    if (sweep)
+    {
+        // results land in m_sweepResults
+        ExecuteFilters(frames, framesToUse, pyramidLevels, nullptr);
+    }
+    else if (!tiled && m_tileCache)
+    {
+        // the whole frame is one entry of the cache (pixels are hashed, so nothing is imported)
+        const uint64_t frameKey{ TileKey(frames, framesToUse) };
+
+        if (m_tileCache->Lookup(frameKey, resultHDRData.data(), resultHDRData.size() * sizeof(Pixel)))
+        {
+            ++m_cachedTiles;
+        }
+        else
+        {
+            ExecuteFilters(frames, framesToUse, pyramidLevels, resultHDRData.data());
+            m_tileCache->Store(frameKey, resultHDRData.data(), resultHDRData.size() * sizeof(Pixel));
+        }
+
+        m_frameTiles = 1;
+        Log() << "\t\ttile cache: " << ((m_cachedTiles > 0) ? "frame reused" : "frame filtered") << "\n";
+    }
+    else if (!tiled)
+    {
+        ExecuteFilters(frames, framesToUse, pyramidLevels, (m_outputImported) ? nullptr : resultHDRData.data());
+    }
+    else
+    {
+        const int tilesX{ (w + tileW - 1) / tileW }, tilesY{ (h + tileH - 1) / tileH };
+        std::vector<Pixel> tileData(gw * gh);
+
+        Log() << "\tprocessing " << tilesX << "x" << tilesY << " tiles of " << tileW << "x" << tileH
+            << " (apron " << apron << ")\n";
+
+        telemetry::Progress progress{ "tiles", size_t(tilesX) * tilesY, "tiles", m_verbose };
+
+        for (int ty{}; ty < tilesY; ++ty)
+        {
+            for (int tx{}; tx < tilesX; ++tx)
+            {
+                const int x0{ tx * tileW }, y0{ ty * tileH };
+                const SourceFrames tile{ CropFrames(frames, x0 - apron, y0 - apron, gw, gh) };
+                const uint64_t     tileKey{ (m_tileCache) ? TileKey(tile, framesToUse) : 0 };
+
+                if (m_tileCache && m_tileCache->Lookup(tileKey, tileData.data(), tileData.size() * sizeof(Pixel)))
+                {
+                    ++m_cachedTiles;
+                }
+                else
+                {
+                    ExecuteFilters(tile, framesToUse, pyramidLevels, tileData.data());
+
+                    if (m_tileCache)
+                    {
+                        m_tileCache->Store(tileKey, tileData.data(), tileData.size() * sizeof(Pixel));
+                    }
+                }
+
+                // stitching: the apron is thrown away, only the interior of the tile lands in the result
+                for (int y{ y0 }; y < std::min(y0 + tileH, h); ++y)
+                {
+                    memcpy(&resultHDRData[y * w + x0], &tileData[(y - y0 + apron) * gw + apron],
+                            std::min(tileW, w - x0) * sizeof(Pixel));
+                }
+
+                progress.Advance();
+            }
+        }
+
+        progress.Finish();
+
+        m_totalTiles *= tilesX * tilesY;
+        m_frameTiles  = tilesX * tilesY;
+
+        if (m_tileCache)
+        {
+            Log() << "\t\ttile cache: " << m_cachedTiles << " of " << m_frameTiles << " tiles reused\n";
+        }
+    }
+
+    if (m_sparse)
+    {
+        Log() << "\t\tsparse dispatch: " << m_activeTiles << " of " << m_totalTiles << " tiles filtered\n";
+    }
+
+    if (hostFrame && !m_outputImported)
+    {
+        memcpy(m_hostFrame.output, resultHDRData.data(), sizeof(Pixel) * w * h);
+    }
+
+    if (m_resultOutput != nullptr && !hostFrame && !sweep)
+    {
+        memcpy(m_resultOutput, resultHDRData.data(), sizeof(Pixel) * w * h);
+    }
+
+    if (m_saveOutput && (sweep || !hostFrame))
+    {
+        Log() << "\tsaving image\n";
+    }
+
+    if (m_saveOutput && sweep)
+    {
+        for (size_t i{}; i < m_sweepResults.size(); ++i)
+        {
+            SaveImage(SweepFileName(i), m_sweepResults[i], w, h, m_isHDR);
+        }
+    }
+    else if (m_saveOutput && !hostFrame)
+    {
+        SaveImage(OutputFileName(), resultHDRData, w, h, m_isHDR);
+    }
+
+    //----------------------------------------------------------------------------------------------------------------------
+    Log() << "\tcleaning up\n";
+    //----------------------------------------------------------------------------------------------------------------------
+    resultHDRData = std::vector<Pixel>();
+    loadedFrames = SourceFrames();
+
+    if (m_keepDevice)
+    {
+        // imports are bound to this frame's memory
+        if (m_inputImported || m_outputImported) ReleaseTransferBuffers();
+    }
+    else
+    {
+        Cleanup();
+    }
+}
+
+void ComputeApplication::RunOnCPU(std::string fileName, int numThreads)
+{
+    int w{}, h{};
+    m_isHDR = std::filesystem::path(fileName.c_str()).extension() == ".exr";
+
+    std::vector<Pixel> inputPixels(0);
+
+    if (!m_sourceFrames.imageData.empty() || !m_sourceFrames.imageDataHDR.empty())
+    {
+        w = m_sourceFrames.w;
+        h = m_sourceFrames.h;
+        m_isHDR = m_sourceFrames.isHDR;
+
+        if (m_isHDR)
+        {
+            inputPixels = m_sourceFrames.imageDataHDR[0];
+        }
+        else
+        {
+            inputPixels.resize(w * h);
+            pixel_format::Rgba8ToRgba32F((const uint8_t*)m_sourceFrames.imageData[0].data(), (float*)inputPixels.data(), size_t(w) * h);
+        }
+    }
+    else if (m_isHDR)
+    {
+        float* rgba{nullptr};
+        const char* err = nullptr;
+
+        int ret = LoadEXR(&rgba, &w, &h, fileName.c_str(), &err);
+
+        if (ret != TINYEXR_SUCCESS)
+        {
+            if (err)
+            {
+                fprintf(stderr, "ERR : %s\n", err);
+                FreeEXRErrorMessage(err); // release memory of error message.
+            }
+        }
+        else
+        {
+            Log() << "\tloading hdr\n";
+
+            inputPixels.resize(w * h);
+            pixel_format::Copy(rgba, inputPixels.data(), sizeof(Pixel) * w * h);
+            free(rgba);
+        }
+    }
+    else
+    {
+        std::vector<unsigned char> rgba(0);
+        const char* err = nullptr;
+
+        unsigned uw{}, uh{};
+        unsigned ret = lodepng::decode(rgba, uw, uh, fileName.c_str());
+        w = uw; h = uh;
+
+        if (ret)
+        {
+            throw(std::runtime_error(lodepng_error_text(ret)));
+        }
+        else
+        {
+            inputPixels.resize(w * h);
+            pixel_format::Rgba8ToRgba32F(rgba.data(), (float*)inputPixels.data(), size_t(w) * h);
+            rgba = std::vector<unsigned char>();
+        }
+    }
+
+    std::vector<Pixel> outputPixels(w * h);
+
+    if (m_fireflyThreshold > 0.0f)
+    {
+        Log() << "\tremoving fireflies\n";
+        FireflyFilterCPU(inputPixels, w, h, m_fireflyThreshold, m_fireflyMedian, numThreads);
+    }
+
+    if (m_guidedRadius > 0)
+    {
+        // gray guide: a RenderElements layer or the input itself
+        std::vector<float> guide(w * h);
+        SourceFrames       layers{};
+
+        if (!m_guidedLayer.empty())
+        {
+            if (m_sourceFrames.layerData.empty())
+            {
+                LoadSourceFrames(layers, false, true);
+            }
+            else
+            {
+                layers = m_sourceFrames;
+            }
+        }
+
+        const int layer{ (m_guidedLayer.empty()) ? -1 : FindLayer(layers, m_guidedLayer) };
+        if (!m_guidedLayer.empty() && (layer < 0 || layers.w != w || layers.h != h))
+        {
+            RUN_TIME_ERROR(("no RenderElements layer \"" + m_guidedLayer + "\" of the image size for the guided filter").c_str());
+        }
+
+        for (int i{}; i < w * h; ++i)
+        {
+            if (layer < 0)
+            {
+                guide[i] = 0.2126f * inputPixels[i].r + 0.7152f * inputPixels[i].g + 0.0722f * inputPixels[i].b;
+            }
+            else
+            {
+                const uint32_t packed{ layers.layerData[layer][i] };
+                guide[i] = (0.2126f * float((packed >> 0) & 0xFF) + 0.7152f * float((packed >> 8) & 0xFF)
+                        + 0.0722f * float((packed >> 16) & 0xFF)) / 255.0f;
+            }
+        }
+
+        Log() << "\tguided filter, radius " << m_guidedRadius << "\n";
+        GuidedFilterCPU(inputPixels, guide, w, h, m_guidedRadius, m_guidedEpsilon, numThreads, outputPixels.data());
+    }
+    else if (m_domainSpatialSigma > 0.0f)
+    {
+        Log() << "\tdomain transform, " << m_domainIterations << " iterations\n";
+        DomainTransformCPU(inputPixels, w, h, m_domainSpatialSigma, m_domainRangeSigma, m_domainIterations, numThreads,
+                outputPixels.data());
+    }
+    else
+    {
+        Log() << "\tdoing computations\n";
+
+        // same window and weights as bialteral.comp, the input after the firefly pass is the target frame
+        SourceFrames frames{};
+        frames.w     = w;
+        frames.h     = h;
+        frames.isHDR = true;
+        frames.imageDataHDR.push_back(std::move(inputPixels));
+
+        BialteralFilterCPU(frames, m_filterParams, 0, h, numThreads, outputPixels.data(), m_verbose);
+    }
+
+    if (m_resultOutput != nullptr)
+    {
+        memcpy(m_resultOutput, outputPixels.data(), sizeof(Pixel) * w * h);
+    }
+
+    if (m_saveOutput)
+    {
+        Log() << "\tsaving image\n";
+
+        std::string outputFileName{ (m_guidedRadius > 0) ? "output-cpu-guided" : (m_domainSpatialSigma > 0.0f) ? "output-cpu-dt" : "output-cpu" };
+
+        if (!m_outputPath.empty())
+        {
+            outputFileName = m_outputPath;
+        }
+        else
+        {
+            outputFileName += (m_isHDR) ? ".exr" : ".png";
+        }
+
+        SaveImage(outputFileName, outputPixels, w, h, m_isHDR);
+    }
+}
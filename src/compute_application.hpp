@@ -0,0 +1,615 @@
+#ifndef COMPUTE_APPLICATION_HPP
+#define COMPUTE_APPLICATION_HPP
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <ostream>
+
+#include "texture.hpp"
+
+#include "vk_utils.h"
+#include "queue_scheduler.hpp"
+#include "tile_cache.hpp"
+
+const int WORKGROUP_SIZE = 16;
+
+#ifdef NDEBUG
+constexpr bool enableValidationLayers = false;
+#else
+constexpr bool enableValidationLayers = true;
+#endif
+
+#define QUERY_TIME
+
+class ComputeApplication
+{
+    public:
+
+        struct Pixel {
+            float r, g, b, a;
+        };
+        static_assert(sizeof(Pixel) == 4 * sizeof(float), "Pixel is interleaved RGBA32F for pixel_format and the shaders");
+
+        // Filtering parameters that are passed to the shaders through push-constants
+        struct FilterParams {
+            float spatialSigma{2.0f};      // bialteral: influence of distant pixels
+            float colorSigma{0.2f};        // bialteral: influence of pixels with different intensity
+            float filteringParameter{0.5f}; // nlm: patch distance decay
+        };
+
+        // Frames fed to RunOnGPU/RunOnCPU instead of the files near m_imageSource (target frame goes first)
+        struct SourceFrames {
+            int  w{}, h{};
+            bool isHDR{};
+            std::vector<std::vector<unsigned int>> imageData{};    // LDR frames (packed RGBA8)
+            std::vector<std::vector<Pixel>>        imageDataHDR{}; // HDR frames
+            std::vector<std::vector<unsigned int>> layerData{};    // RenderElements layers (packed RGBA8)
+            std::vector<std::string>               layerNames{};   // lower case file names of layerData, may be empty
+        };
+
+        // Every compute shader gets local_size_x/y through specialization constants 0 and 1
+        struct WorkgroupSize {
+            uint32_t x{WORKGROUP_SIZE};
+            uint32_t y{WORKGROUP_SIZE};
+        };
+
+        // Raw frame owned by the caller (e.g. a shared-memory slot), used instead of image files:
+        // input is packed RGBA8 or RGBA32F (isHDR) without row padding, output always gets RGBA32F.
+        // Pointers aligned to minImportedHostPointerAlignment are imported (VK_EXT_external_memory_host) and used without copies.
+        struct HostFrame {
+            int    w{}, h{};
+            bool   isHDR{};
+            void*  input{};
+            void*  output{};
+            size_t inputCapacity{};  // bytes available at input/output, imports are rounded up to the alignment
+            size_t outputCapacity{};
+        };
+
+        // Level of the pyramid mode, offset is counted in texels from the start of the pyramid buffer
+        struct PyramidLevel {
+            int w{}, h{};
+            int offset{};
+        };
+
+        // Layers the edge-stopping functions of the a-trous mode read (indices in layerData, -1 - missing)
+        struct AtrousGuides {
+            int normal{-1}, depth{-1}, albedo{-1};
+        };
+
+        // Instance, logical device and compute queue, see CreateSharedDevice. Every ComputeApplication attached to it keeps
+        // its own command pools, descriptor sets and buffers, so several jobs run on one device at once;
+        // submissions to the queue go through the scheduler.
+        struct SharedDevice {
+            int                       deviceId{};
+            VkInstance                instance{};
+            VkDebugReportCallbackEXT  debugReportCallback{};
+            VkPhysicalDevice          physicalDevice{};
+            VkDevice                  device{};
+            VkQueue                   queue{};
+            uint32_t                  queueFamilyIndex{};
+            VkDeviceSize              hostPointerAlignment{}; // 0 - VK_EXT_external_memory_host is not enabled
+            bool                      halfNative{};           // 16-bit storage and float16 arithmetic are enabled
+            std::string               deviceName{};
+            float                     timestampPeriod{1.0f};
+            std::vector<const char *> enabledLayers{};
+            QueueScheduler            scheduler{};
+
+            SharedDevice() = default;
+            SharedDevice(const SharedDevice&) = delete;
+            SharedDevice& operator=(const SharedDevice&) = delete;
+
+            ~SharedDevice();
+        };
+
+    private:
+
+        // Everything the resources of CreateResources depend on, push constants are not here
+        struct RunKey {
+            bool     nlmFilter{}, linear{}, overlap{}, layers{}, sparse{}, isHDR{}, unifiedMemory{}, guided{}, firefly{}, ycbcr{}, half{};
+            int      pyramidLevels{}, guideLayers{}, atrousIterations{};
+            int      w{}, h{};
+            uint32_t workgroupX{}, workgroupY{};
+
+            bool operator==(const RunKey&) const = default;
+        };
+
+        VkInstance                m_instance{};            // handles of m_sharedDevice while a run is going on
+        VkPhysicalDevice          m_physicalDevice{};
+        VkDevice                  m_device{};
+        VkPipeline                m_pipeline{},            m_pipeline2{};
+        VkPipelineLayout          m_pipelineLayout{},      m_pipelineLayout2{};
+        VkShaderModule            m_computeShaderModule{}, m_computeShaderModule2{};
+        VkCommandBuffer           m_commandBuffer{},       m_commandBuffer2{};
+        VkQueue                   m_queue{},               m_queue2{};
+        VkDescriptorSet           m_descriptorSet{},       m_descriptorSet2{}, m_descriptorSet3{};
+        VkDescriptorSetLayout     m_descriptorSetLayout{}, m_descriptorSetLayout2{};
+        VkDescriptorPool          m_descriptorPool{},      m_descriptorPool2{}, m_descriptorPool3{};
+        VkCommandPool             m_commandPool{},         m_commandPool2{};
+        CustomVulkanTexture       m_neighbourImage{},      m_neighbourImage2{};
+        VkBuffer                  m_bufferGPU{};
+        VkBuffer                  m_bufferDynamic{};
+        VkBuffer                  m_bufferStaging{};
+        VkBuffer                  m_bufferTexel{};
+        VkBuffer                  m_bufferWeights{};
+        VkDeviceMemory            m_bufferMemoryGPU{}, m_bufferMemoryStaging{}, m_bufferMemoryTexel{}, m_bufferMemoryWeights{}, m_bufferMemoryDynamic{};
+        VkBufferView              m_texelBufferView{};
+        VkBuffer                  m_bufferTiles{};         // sparse dispatch: indirect args + noisy tile list
+        VkDeviceMemory            m_bufferMemoryTiles{};
+        VkDescriptorSetLayout     m_descriptorSetLayoutTiles{};
+        VkDescriptorPool          m_descriptorPoolTiles{};
+        VkDescriptorSet           m_descriptorSetTiles{};
+        VkShaderModule            m_classifyShaderModule{};
+        VkPipeline                m_classifyPipeline{};
+        VkPipelineLayout          m_classifyPipelineLayout{};
+        VkBuffer                  m_bufferFirefly{};       // firefly pre-pass: cleaned target image in the texel format of the texture
+        VkDeviceMemory            m_bufferMemoryFirefly{};
+        VkDescriptorSetLayout     m_descriptorSetLayoutFirefly{};
+        VkDescriptorPool          m_descriptorPoolFirefly{};
+        VkDescriptorSet           m_descriptorSetFirefly{};
+        VkShaderModule            m_fireflyShaderModule{};
+        VkPipeline                m_fireflyPipeline{};
+        VkPipelineLayout          m_fireflyPipelineLayout{};
+        VkBuffer                  m_bufferPyramid{};       // pyramid mode: G levels followed by F levels (float4)
+        VkDeviceMemory            m_bufferMemoryPyramid{};
+        VkBuffer                  m_bufferPingPong{};      // a-trous: results of the iterations, guided: prefix sums; two halves
+        VkDeviceMemory            m_bufferMemoryPingPong{};
+        VkBuffer                  m_bufferGuides{};        // layers mode: all RenderElements layers for one dispatch
+        VkBuffer                  m_bufferGuidesUpload{};  // its upload buffer (no unified memory)
+        VkDeviceMemory            m_bufferMemoryGuides{}, m_bufferMemoryGuidesUpload{};
+        int                       m_guideLayers{};         // layers of the current run
+        std::vector<float>        m_guideWeights{};        // weight of every layer in the range distance, missing ones are 1
+        VkQueryPool               m_queryPool{};
+        bool                      m_linear{};
+        bool                      m_nlmFilter{};          // if false then bialteral (default)
+        bool                      m_multiframe{};         // works only with nlm
+        bool                      m_execAndCopyOverlap{}; // if false then dispathes and copy/clear commands dont overlap
+        bool                      m_isHDR{};
+        bool                      m_useLayers{};
+        bool                      m_sparse{};             // filter only the tiles that classify.comp found noisy
+        float                     m_sparseThreshold{0.01f};
+        uint32_t                  m_activeTiles{}, m_totalTiles{};
+        int                       m_pyramidLevels{};      // 0 - pyramid mode is off
+        int                       m_atrousIterations{};   // 0 - a-trous mode is off
+        int                       m_guidedRadius{};       // 0 - guided filter mode is off
+        float                     m_guidedEpsilon{0.01f};
+        std::string               m_guidedLayer{};        // name of the guide layer, empty - the input itself
+        float                     m_domainSpatialSigma{}; // RunOnCPU: domain-transform filter, 0 - off
+        float                     m_domainRangeSigma{0.4f};
+        int                       m_domainIterations{3};
+        bool                      m_ycbcr{};              // bialteral in YCbCr: luma at full, chroma at half resolution
+        float                     m_fireflyThreshold{};   // pre-pass: outliers above mean + threshold * sigma of the neighbours, 0 - off
+        bool                      m_fireflyMedian{true};  // outliers get the median of the window, false - they are clamped
+        bool                      m_halfRequested{};      // FP16 mode was asked for (SetHalfPrecision)
+        bool                      m_half{};               // textures, NLM weights and output are FP16 in this run
+        bool                      m_halfNative{};         // ... and the shaders compute in halves (16-bit storage + float16)
+        int                       m_tileSize{};           // out-of-core tiles (without apron), 0 - whole image at once
+        bool                      m_zeroCopy{true};       // use unified memory when the device has it
+        bool                      m_unifiedMemory{};      // output (and texel buffer) are DEVICE_LOCAL | HOST_VISIBLE in this run
+        HostFrame                 m_hostFrame{};          // used instead of files and m_sourceFrames when input is set
+        bool                      m_inputImported{};      // m_bufferDynamic is m_hostFrame.input itself
+        bool                      m_outputImported{};     // m_bufferStaging is m_hostFrame.output itself
+        CustomVulkanTexture       m_targetImage{};
+        uint64_t                  m_transferTimeElapsed{};
+        uint64_t                  m_execTimeElapsed{};
+        std::string               m_imageSource{};
+        int                       m_format{};
+        FilterParams              m_filterParams{};
+        WorkgroupSize             m_workgroupSize{};
+        int                       m_deviceId{};
+        SourceFrames              m_sourceFrames{};     // used instead of m_imageSource when not empty
+        bool                      m_saveOutput{true};
+        bool                      m_verbose{true};          // RunOnGPU/RunOnCPU print their steps and progress to std::cout
+        float                     m_timestampPeriod{1.0f};
+        std::string               m_deviceName{};
+        bool                      m_keepDevice{};           // device and resources outlive RunOnGPU (daemon)
+        std::shared_ptr<SharedDevice> m_sharedDevice{};     // made by RunOnGPU or given by SetSharedDevice
+        bool                      m_externalDevice{};       // m_sharedDevice came from SetSharedDevice and outlives Cleanup
+        QueueScheduler::Priority  m_priority{QueueScheduler::PRIORITY_BATCH};
+        RunKey                    m_runKey{};               // configuration of the kept resources
+        bool                      m_resourcesReady{};
+        std::string               m_outputPath{};           // result file, empty - output-<mode>.png/exr in the working directory
+        Pixel*                    m_resultOutput{};         // gets a copy of the result of RunOnGPU/RunOnCPU when set
+        std::shared_ptr<TileCache> m_tileCache{};           // incremental mode: unchanged tiles are not dispatched
+        uint32_t                  m_cachedTiles{}, m_frameTiles{};
+        std::vector<FilterParams> m_sweepParams{};          // sweep mode: one result per parameter set, empty - off
+        std::vector<std::vector<Pixel>> m_sweepResults{};   // ... in the order of m_sweepParams
+        VkBuffer                  m_bufferSweep{};          // ... host visible slots of one batch of results
+        VkDeviceMemory            m_bufferMemorySweep{};
+        size_t                    m_sweepBufferSize{};
+
+    public:
+
+        // Vulkan timestamps are counted in ticks of VkPhysicalDeviceLimits::timestampPeriod nanoseconds
+        uint64_t GetTranferTimeElapsed() { return uint64_t(double(m_transferTimeElapsed) * m_timestampPeriod); }
+        uint64_t GetExecTimeElapsed() { return uint64_t(double(m_execTimeElapsed) * m_timestampPeriod); }
+        const std::string& GetDeviceName() { return m_deviceName; }
+
+        void SetFilterParams(const FilterParams& a_params) { m_filterParams = a_params; }
+        // layers mode: weight of every RenderElements layer (in name order) in the joint range distance, 0 ignores a layer
+        void SetGuideWeights(const std::vector<float>& a_weights) { m_guideWeights = a_weights; }
+        void SetWorkgroupSize(const WorkgroupSize& a_size) { m_workgroupSize = a_size; }
+        WorkgroupSize GetWorkgroupSize() { return m_workgroupSize; }
+        void SetDeviceId(int a_deviceId) { m_deviceId = a_deviceId; }
+        void SetSourceFrames(SourceFrames a_frames) { m_sourceFrames = std::move(a_frames); }
+        void SetSaveOutput(bool a_saveOutput) { m_saveOutput = a_saveOutput; }
+        // false keeps RunOnGPU/RunOnCPU quiet without touching std::cout (library, daemon workers, several devices at once)
+        void SetVerbose(bool a_verbose) { m_verbose = a_verbose; }
+        // a_threshold is the noise standard deviation (in luminance) below which a tile is copied through
+        void SetSparseDispatch(bool a_sparse, float a_threshold = 0.01f) { m_sparse = a_sparse; m_sparseThreshold = a_threshold; }
+        // a_levels > 1 filters every level of a mip chain with a small kernel and recombines them (0 - off)
+        void SetPyramidLevels(int a_levels) { m_pyramidLevels = a_levels; }
+        // a_iterations > 0 runs the edge-avoiding a-trous filter guided by the normal, depth and albedo layers (0 - off)
+        void SetAtrousIterations(int a_iterations) { m_atrousIterations = a_iterations; }
+        // a_radius > 0 runs the guided filter (same cost for any radius) with the RenderElements layer whose file name
+        // contains a_guideLayer as the guide, empty - the input itself; a_epsilon is the variance of the guide that is smoothed away
+        void SetGuidedFilter(int a_radius, float a_epsilon = 0.01f, const std::string& a_guideLayer = "")
+        {
+            m_guidedRadius  = a_radius;
+            m_guidedEpsilon = a_epsilon;
+            m_guidedLayer   = a_guideLayer;
+        }
+        // a_spatialSigma > 0 makes RunOnCPU run the domain-transform recursive filter instead of the window (0 - off)
+        void SetDomainTransform(float a_spatialSigma, float a_rangeSigma = 0.4f, int a_iterations = 3)
+        {
+            m_domainSpatialSigma = a_spatialSigma;
+            m_domainRangeSigma   = a_rangeSigma;
+            m_domainIterations   = a_iterations;
+        }
+        // true runs the plain bialteral filter on luma at full resolution and on chroma at half resolution
+        void SetYCbCr(bool a_ycbcr) { m_ycbcr = a_ycbcr; }
+        // a_threshold > 0 cleans fireflies of the target image before any filter (GPU and CPU): pixels more than a_threshold
+        // standard deviations brighter than their neighbours get the median of the window, or are clamped when a_median is false
+        void SetFireflyFilter(float a_threshold, bool a_median = true)
+        {
+            m_fireflyThreshold = a_threshold;
+            m_fireflyMedian    = a_median;
+        }
+        // true stores the texels, the NLM weights and the output of HDR images as halves, which halves their memory traffic;
+        // modes and devices without FP16 shaders or RGBA16F textures fall back to FP32 (see GetHalfPrecision)
+        void SetHalfPrecision(bool a_half) { m_halfRequested = a_half; }
+        // true if the last RunOnGPU ran in FP16
+        bool GetHalfPrecision() { return m_half; }
+        // a_tileSize > 0 streams the image through the GPU in tiles, device memory then depends on the tile size only
+        void SetTileSize(int a_tileSize) { m_tileSize = a_tileSize; }
+        // false forces staging copies even on integrated GPUs
+        void SetZeroCopy(bool a_zeroCopy) { m_zeroCopy = a_zeroCopy; }
+        // true if the last RunOnGPU read the result straight from the output buffer
+        bool GetUnifiedMemory() { return m_unifiedMemory; }
+        // next RunOnGPU reads a_frame.input and writes a_frame.output instead of files (HostFrame{} - back to files)
+        void SetHostFrame(const HostFrame& a_frame) { m_hostFrame = a_frame; }
+        // true keeps the device, pipelines and buffers between RunOnGPU calls, they are rebuilt only when the mode or size changes
+        void SetKeepDevice(bool a_keepDevice) { m_keepDevice = a_keepDevice; }
+        // runs on a device shared with other ComputeApplication objects (nullptr - own device again)
+        void SetSharedDevice(std::shared_ptr<SharedDevice> a_device);
+        // order of the submissions of this object on a shared queue
+        void SetPriority(QueueScheduler::Priority a_priority) { m_priority = a_priority; }
+        void SetImageSource(const std::string& a_imageSource) { m_imageSource = a_imageSource; }
+        // result file of the next RunOnGPU/RunOnCPU (empty - output-<mode>.png/exr)
+        void SetOutputPath(const std::string& a_outputPath) { m_outputPath = a_outputPath; }
+        // next RunOnGPU/RunOnCPU also copies its w * h result pixels to a_result (nullptr - off), e.g. with SetSaveOutput(false)
+        void SetResultOutput(Pixel* a_result) { m_resultOutput = a_result; }
+        // a_params not empty makes RunOnGPU filter the uploaded input once per parameter set instead of once with SetFilterParams,
+        // all dispatches go into one command buffer (plain bialteral, texel buffer, layers or single frame NLM, which reads
+        // filteringParameter only); results are saved as output-...-sweep<i> and kept for GetSweepResults
+        void SetSweep(const std::vector<FilterParams>& a_params) { m_sweepParams = a_params; }
+        // w * h pixels per parameter set of the last sweep
+        const std::vector<std::vector<Pixel>>& GetSweepResults() { return m_sweepResults; }
+        // tiles filtered by the last sparse RunOnGPU (tile = one workgroup)
+        uint32_t GetActiveTiles() { return m_activeTiles; }
+        uint32_t GetTotalTiles() { return m_totalTiles; }
+        // incremental mode: a tile of SetTileSize (the whole frame if the run is not tiled) whose padded input and
+        // configuration hash like an earlier one is copied from a_cache instead of filtered (nullptr - off)
+        void SetTileCache(std::shared_ptr<TileCache> a_cache) { m_tileCache = std::move(a_cache); }
+        // tiles of the last RunOnGPU taken from the tile cache and all of its tiles
+        uint32_t GetCachedTiles() { return m_cachedTiles; }
+        uint32_t GetFrameTiles() { return m_frameTiles; }
+
+        ComputeApplication(const std::string imageSource)
+            : m_bufferDynamic(NULL), m_bufferMemoryDynamic(NULL), m_imageSource(imageSource) { }
+
+        ComputeApplication(const ComputeApplication&) = delete;
+        ComputeApplication& operator=(const ComputeApplication&) = delete;
+
+        // a kept device (SetKeepDevice) lives until here
+        ~ComputeApplication();
+
+        static void GetImageFromGPU(VkDevice a_device, VkDeviceMemory a_stagingMem, int a_w, int a_h, unsigned char *a_imageData);
+
+        // a_half - the buffer holds four halves per pixel (FP16 mode)
+        static void GetImageFromGPU(VkDevice a_device, VkDeviceMemory a_stagingMem, int a_w, int a_h, Pixel *a_imageData, bool a_half = false);
+
+        static void PutImageToGPU(VkDevice a_device, VkDeviceMemory a_dynamicMem, int a_w, int a_h, const uint32_t *a_imageData);
+
+        static void LoadImages(int& a_w, int& a_h, const std::vector<std::string> a_fileNames, std::vector<std::vector<unsigned int>>& a_imageData,
+                std::vector<std::vector<Pixel>>& a_imageDataHDR, const bool a_isHDR);
+
+        static VKAPI_ATTR VkBool32 VKAPI_CALL debugReportCallbackFn(
+                VkDebugReportFlagsEXT                       flags,
+                VkDebugReportObjectTypeEXT                  objectType,
+                uint64_t                                    object,
+                size_t                                      location,
+                int32_t                                     messageCode,
+                const char*                                 pLayerPrefix,
+                const char*                                 pMessage,
+                void*                                       pUserData);
+
+        // CPU (this buffer takes data from GPU)
+        static void CreateStagingBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
+                VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory);
+
+        static void CreateDynamicBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
+                VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory);
+
+        static void CreateTexelBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
+                VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory, bool a_deviceLocal = false);
+
+        static void CreateTexelBufferView(VkDevice a_device, const size_t a_bufferSize, VkBuffer a_buffer,
+                VkBufferView *a_pBufferView, bool a_isHDR = false);
+
+        // a_hostVisible: output is mapped by the host instead of being copied to a staging buffer (unified memory only)
+        static void CreateWriteOnlyBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, const size_t a_bufferSize,
+                VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory, bool a_hostVisible = false);
+
+        // Integrated GPUs and software ICDs have memory that is DEVICE_LOCAL and HOST_VISIBLE at once,
+        // there staging copies only double the memory traffic.
+        // Discrete GPUs may expose such memory too (PCIe BAR), but host reads from it are uncached, so they keep the copies.
+        static bool HasUnifiedMemory(VkDevice a_device, VkPhysicalDevice a_physDevice);
+
+        // FP16 mode samples RGBA16F images filled by buffer copies, Vulkan does not require that for compute-only devices
+        static bool HasHalfTextures(VkPhysicalDevice a_physDevice);
+
+        // minImportedHostPointerAlignment, the device must support VK_EXT_external_memory_host and Vulkan 1.1
+        static VkDeviceSize HostPointerAlignment(VkPhysicalDevice a_physDevice);
+
+        // Wraps caller memory into a buffer (VK_EXT_external_memory_host),
+        // false if the pointer is not aligned, the capacity is too small or the driver can't import it
+        static bool CreateImportedHostBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, void* a_hostPtr, size_t a_size, size_t a_capacity,
+                VkDeviceSize a_alignment, VkBufferUsageFlags a_usage, VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory);
+
+        // Makes the output visible to the host: copies it to a_bufferStaging (at a_stagingOffset), or only waits for the shader
+        // writes when a_bufferStaging is VK_NULL_HANDLE (output lives in mapped unified memory)
+        static void RecordTransferToHost(VkCommandBuffer a_cmdBuff, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, size_t a_bufferSize,
+                VkDeviceSize a_stagingOffset = 0);
+
+        static void CreateWeightBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, size_t a_bufferSize,
+                VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory);
+
+        // Indirect dispatch arguments followed by the list of noisy tiles, read back to count filtered tiles
+        static void CreateTileBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, size_t a_bufferSize,
+                VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory);
+
+        // Guides of the layers mode, filled by a copy from the upload buffer or mapped by the host on unified memory
+        static void CreateGuideBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, size_t a_bufferSize,
+                VkBuffer *a_pBuffer, VkDeviceMemory *a_pBufferMemory, bool a_hostVisible = false);
+
+        static std::vector<PyramidLevel> PyramidLevels(int a_w, int a_h, int a_levels);
+
+        // Border a tile needs so that its interior matches the whole image result, mirrors the windows of the shaders
+        static int TileApron(bool a_nlmFilter, int a_pyramidLevels, int a_atrousIterations = 0, int a_guidedRadius = 0, bool a_ycbcr = false);
+
+        static constexpr int MAX_GUIDE_LAYERS = 16; // MAX_GUIDES of bialteral_layers.comp
+        static constexpr int FIREFLY_RADIUS   = 2;  // RADIUS of firefly.comp
+        static constexpr int FIREFLY_TILE     = 16; // TILE of firefly.comp, also its workgroup size
+        static constexpr size_t HALF_PIXEL_SIZE  = 4 * sizeof(uint16_t); // texel and output pixel in FP16 mode
+        static constexpr size_t HALF_WEIGHT_SIZE = 16;                   // WeightInfo of the HALF variant of nonlocal.comp
+        static constexpr size_t SWEEP_BATCH_BYTES = size_t(512) << 20;   // result slots of one sweep command buffer
+
+        // output buffer pixel and NLM weight of the current run (FP32 sizes follow GLSL alignment)
+        size_t OutputPixelSize() const { return (m_half) ? HALF_PIXEL_SIZE : sizeof(Pixel); }
+        size_t WeightSize() const { return (m_half) ? HALF_WEIGHT_SIZE : sizeof(Pixel) + 4 * sizeof(float); }
+
+        // Guide buffer of the layers mode: number of layers and their weights (the std430 header of bialteral_layers.comp),
+        // then one packed RGBA8 plane per layer
+        static size_t GuideBufferSize(int a_w, int a_h, int a_layers);
+
+        // Planes of bialteral_ycbcr.comp: luma in and out, then (Y, Cb, Cr, -) in and (Cb, Cr) out at half resolution
+        static size_t YCbCrScratchSize(int a_w, int a_h);
+
+        // Device memory RunOnGPU allocates for an a_w x a_h frame (images, filter and transfer buffers), used for admission control.
+        // a_guideLayers - RenderElements layers of the layers mode (0 - off)
+        static size_t EstimateDeviceMemory(int a_w, int a_h, bool a_isHDR, bool a_nlmFilter, int a_guideLayers, bool a_overlap,
+                int a_pyramidLevels, int a_tileSize, int a_atrousIterations = 0, int a_guidedRadius = 0);
+
+        // Copy of the a_w x a_h window at (a_x, a_y) of every frame and layer, pixels outside of the image repeat the edge
+        static SourceFrames CropFrames(const SourceFrames& a_frames, int a_x, int a_y, int a_w, int a_h);
+
+        // bialteral.comp on the CPU (same window and weights, pixels outside of the image repeat the edge):
+        // rows [a_y0, a_y1) of the target frame of a_frames, a_result gets a_frames.w pixels per row (a_progress - report them)
+        static void BialteralFilterCPU(const SourceFrames& a_frames, const FilterParams& a_params, int a_y0, int a_y1, int a_numThreads,
+                Pixel* a_result, bool a_progress = true);
+
+        // firefly.comp on the CPU, in place. The median comes from sliding histograms (Perreault and Hebert 2007): every
+        // column keeps a histogram of its window rows and moves down one row at a time, the window histogram adds the column
+        // entering on the right and drops the one leaving on the left, so a pixel costs a fixed number of bin updates
+        // whatever the radius. Luminance is binned as l / (l + knee), which keeps HDR values apart and LDR ones fine enough;
+        // mean and variance of the window slide the same way in double precision. Threads take bands of rows.
+        static void FireflyFilterCPU(std::vector<Pixel>& a_image, int a_w, int a_h, float a_threshold, bool a_median, int a_numThreads);
+
+        // guided.comp on the CPU: the box means are sliding sums in double precision (rows, then columns), so the cost per pixel
+        // does not depend on a_radius either. a_guide is the gray guide, a_result gets a_w * a_h pixels
+        static void GuidedFilterCPU(const std::vector<Pixel>& a_input, const std::vector<float>& a_guide, int a_w, int a_h,
+                int a_radius, float a_epsilon, int a_numThreads, Pixel* a_result);
+
+        // Domain-transform edge-aware smoothing (recursive filter of Gastal and Oliveira 2011): a_iterations rounds of a
+        // horizontal and a vertical 1D recursive pass whose feedback weight falls with the color distance between neighbours,
+        // the cost does not depend on a_spatialSigma. Channels are planar and every pass runs down the columns of a plane
+        // (the horizontal ones on a transposed copy), so the inner loops go along memory and vectorize across rows;
+        // threads take bands of columns. a_result gets a_w * a_h pixels, alpha is copied.
+        static void DomainTransformCPU(const std::vector<Pixel>& a_input, int a_w, int a_h, float a_spatialSigma, float a_rangeSigma,
+                int a_iterations, int a_numThreads, Pixel* a_result);
+
+        // Pixels of a_frame as the target frame of a_frames (when it can't be imported)
+        static void CopyHostFrame(const HostFrame& a_frame, SourceFrames& a_frames);
+
+        static void CreateDescriptorSetLayoutPyramid(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout);
+
+        void CreateDescriptorSetPyramid(VkDevice a_device, VkBuffer a_bufferPyramid, size_t a_bufferPyramidSize, VkBuffer a_bufferGPU,
+                size_t a_bufferSize, CustomVulkanTexture a_image, const VkDescriptorSetLayout *a_pDSLayout,
+                VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS);
+
+        static void CreateDescriptorSetLayoutBialteral(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout, bool a_linear = false);
+
+        static void CreateDescriptorSetLayoutNLM(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout, bool a_linear = false, bool a_buildImage = false);
+
+        void CreateDescriptorSetNLM(VkDevice a_device, VkBuffer a_bufferNLM, size_t a_bufferSize, const VkDescriptorSetLayout *a_pDSLayout,
+                CustomVulkanTexture a_targetImage, CustomVulkanTexture a_neighbourImage,
+                VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS);
+
+        void CreateDescriptorSetNLM2(VkDevice a_device, VkBuffer a_bufferGPU, size_t a_bufferSize, const VkDescriptorSetLayout *a_pDSLayout,
+                VkBuffer a_bufferNLM, size_t a_bufferNLMSize, VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS);
+
+        void CreateDescriptorSetBialteral(VkDevice a_device, VkBuffer a_buffer, size_t a_bufferSize, const VkDescriptorSetLayout *a_pDSLayout, CustomVulkanTexture a_image,
+                VkBuffer a_texelBuffer, VkBufferView *a_texelBufferView, VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS, bool a_linear = false);
+
+        // a_pingPong adds binding 3, the ping-pong buffer of the a-trous iterations
+        static void CreateDescriptorSetLayoutGuides(VkDevice a_device, VkDescriptorSetLayout *a_pDSLayout, bool a_pingPong = false);
+
+        void CreateDescriptorSetGuides(VkDevice a_device, VkBuffer a_buffer, size_t a_bufferSize, const VkDescriptorSetLayout *a_pDSLayout,
+                CustomVulkanTexture a_image, VkBuffer a_bufferGuides, size_t a_bufferGuidesSize, VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS,
+                VkBuffer a_bufferPingPong = VK_NULL_HANDLE, size_t a_bufferPingPongSize = 0);
+
+        // set = 1 of the classify pass and of sparse filters
+        static void CreateDescriptorSetTiles(VkDevice a_device, VkBuffer a_bufferTiles, size_t a_bufferSize,
+                VkDescriptorSetLayout *a_pDSLayout, VkDescriptorPool *a_pDSPool, VkDescriptorSet *a_pDS);
+
+        static void CreateComputePipelines(VkDevice a_device, const VkDescriptorSetLayout &a_dsLayout,
+                VkShaderModule *a_pShaderModule, VkPipeline *a_pPipeline, VkPipelineLayout *a_pPipelineLayout,
+                const char *a_shaderFileName, const size_t pcSize, const WorkgroupSize& a_workgroupSize,
+                VkDescriptorSetLayout a_tilesDSLayout = VK_NULL_HANDLE);
+
+        static void CreateCommandBuffer(VkDevice a_device, uint32_t a_queueFamilyIndex, VkPipeline a_pipeline, VkPipelineLayout a_layout,
+                VkCommandPool *a_pool, VkCommandBuffer *a_pCmdBuff);
+
+        static void CreateQueryPool(VkDevice a_device, VkQueryPool *a_pQueryPool);
+
+        static VkImageMemoryBarrier imBarTransfer(VkImage a_image, const VkImageSubresourceRange& a_range, VkImageLayout before, VkImageLayout after);
+
+        static VkImageSubresourceRange WholeImageRange();
+
+        // Whole image, or only the noisy tiles listed in a_bufferTiles (sparse dispatch)
+        static void RecordDispatch(VkCommandBuffer a_cmdBuff, VkPipelineLayout a_layout, int a_w, int a_h, const WorkgroupSize& a_wg,
+                VkBuffer a_bufferTiles, VkDescriptorSet a_dsTiles);
+
+        static void RecordCommandsOfClassifyTiles(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout,
+                const VkDescriptorSet &a_ds, const VkDescriptorSet &a_dsTiles, VkBuffer a_bufferTiles, int a_w, int a_h,
+                float a_threshold, VkQueryPool a_queryPool, const WorkgroupSize& a_wg);
+
+        static void RecordCommandsOfFirefly(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout,
+                const VkDescriptorSet &a_ds, int a_w, int a_h, float a_threshold, bool a_median, VkQueryPool a_queryPool);
+
+        static void RecordCommandsOfPyramid(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+                size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, const std::vector<PyramidLevel>& a_levels,
+                VkQueryPool a_queryPool, const FilterParams& a_params, const WorkgroupSize& a_wg);
+
+        // Normal, depth and albedo layers told apart by the names of their files (V-Ray and Blender naming)
+        static AtrousGuides FindAtrousGuides(const SourceFrames& a_frames);
+
+        static void RecordCommandsOfAtrous(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+                size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, int a_w, int a_h, int a_iterations,
+                const AtrousGuides& a_guides, VkQueryPool a_queryPool, const FilterParams& a_params, const WorkgroupSize& a_wg);
+
+        // Index of the layer whose file name contains a_name, -1 - none
+        static int FindLayer(const SourceFrames& a_frames, const std::string& a_name);
+
+        static void RecordCommandsOfGuided(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+                size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, int a_w, int a_h, int a_radius, float a_epsilon,
+                int a_guideLayer, VkQueryPool a_queryPool, const WorkgroupSize& a_wg);
+
+        static void RecordCommandsOfYCbCr(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+                size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, int a_w, int a_h, VkQueryPool a_queryPool,
+                const FilterParams& a_params, const WorkgroupSize& a_wg);
+
+        static void RecordCommandsOfExecuteAndTransfer(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline,VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+                size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferStaging, int a_w, int a_h, VkQueryPool a_queryPool, bool normKernel,
+                const FilterParams& a_params, const WorkgroupSize& a_wg, VkBuffer a_bufferTiles = VK_NULL_HANDLE, VkDescriptorSet a_dsTiles = VK_NULL_HANDLE);
+
+        static void RecordCommandsOfExecuteNLM(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline,VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+                int a_w, int a_h, VkQueryPool a_queryPool, bool nlm, const FilterParams& a_params,
+                const WorkgroupSize& a_wg, VkBuffer a_bufferTiles = VK_NULL_HANDLE, VkDescriptorSet a_dsTiles = VK_NULL_HANDLE);
+
+        // Sweep mode: the uploaded input is filtered with every one of a_count parameter sets in one command buffer, result i
+        // is copied to slot i of a_bufferSweep. NLM (a_bufferWeights set) clears the weights on the GPU, accumulates the target
+        // frame with itself and normalizes with a_pipelineNorm for every set; the bialteral filters take a single dispatch.
+        static void RecordCommandsOfSweep(VkCommandBuffer a_cmdBuff, VkPipeline a_pipeline, VkPipelineLayout a_layout, const VkDescriptorSet &a_ds,
+                VkPipeline a_pipelineNorm, VkPipelineLayout a_layoutNorm, const VkDescriptorSet &a_dsNorm, VkBuffer a_bufferWeights,
+                size_t a_bufferSize, VkBuffer a_bufferGPU, VkBuffer a_bufferSweep, int a_w, int a_h, VkQueryPool a_queryPool,
+                const FilterParams* a_params, size_t a_count, const WorkgroupSize& a_wg);
+
+        static void RecordCommandsOfOverlappingNLM(VkCommandBuffer a_cmdBuff, int a_w, int a_h, VkBuffer a_bufferDynamic,
+                VkImage *a_images,  const VkDescriptorSet &a_ds, VkPipeline a_pipeline, VkPipelineLayout a_layout, VkQueryPool a_queryPool,
+                const FilterParams& a_params, const WorkgroupSize& a_wg, VkBuffer a_bufferTiles = VK_NULL_HANDLE, VkDescriptorSet a_dsTiles = VK_NULL_HANDLE);
+        static void RecordCommandsOfCopyImageDataToTexture(VkCommandBuffer a_cmdBuff, int a_width, int a_height, VkBuffer a_bufferDynamic,
+                VkImage *a_images, VkQueryPool a_queryPool);
+
+        // Upload buffer => storage buffer the next dispatch reads
+        static void RecordCommandsOfCopyBuffer(VkCommandBuffer a_cmdBuff, VkBuffer a_bufferSrc, VkBuffer a_bufferDst, size_t a_bufferSize,
+                VkQueryPool a_queryPool);
+
+        static void RunCommandBuffer(VkCommandBuffer a_cmdBuff, VkQueue a_queue, VkDevice a_device, VkQueryPool a_queryPool,
+                uint64_t& a_execElapsedTime, uint64_t& a_transferElapsedTime);
+
+        static void LoadImageDataToBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, std::vector<unsigned int> a_imageData,
+                int a_w, int a_h, VkDeviceMemory a_bufferMemoryTexel, VkDeviceMemory a_bufferMemoryDynamic, bool a_linear);
+
+        // a_half - the texture is RGBA16F, pixels are converted on the way (texture input only)
+        static void LoadImageDataToBuffer(VkDevice a_device, VkPhysicalDevice a_physDevice, std::vector<Pixel> a_imageDataHDR,
+                int a_w, int a_h, VkDeviceMemory a_bufferMemoryTexel, VkDeviceMemory a_bufferMemoryDynamic, bool a_linear, bool a_half = false);
+
+        // Upload and readback buffers, imported ones included
+        void ReleaseTransferBuffers();
+
+        // Everything made for one filter configuration, the device stays
+        void ReleaseResources();
+
+        void Cleanup();
+
+        // Vulkan instance and logical device for one or more ComputeApplication objects (a_hostImport - enable
+        // VK_EXT_external_memory_host when the device has it)
+        static std::shared_ptr<SharedDevice> CreateSharedDevice(int a_deviceId, bool a_hostImport = true);
+
+        // Submits a_cmdBuff and waits for it, other jobs of a shared device submit in between in the order of their priorities
+        void Submit(VkCommandBuffer a_cmdBuff);
+
+        // Target image, neighbour frames (multiframe) and RenderElements layers found near m_imageSource
+        void LoadSourceFrames(SourceFrames& a_frames, bool a_multiframe, bool a_useLayers);
+
+        // Layers of a_frames and their weights into the guide buffer of the layers mode
+        void UploadGuides(const SourceFrames& a_frames);
+
+        // Runs the filter over one set of frames (whole image or a padded tile) with resources made by RunOnGPU,
+        // a_result gets a_frames.w * a_frames.h pixels (nullptr - result stays in the imported output)
+        void ExecuteFilters(const SourceFrames& a_frames, int a_framesToUse, const std::vector<PyramidLevel>& a_pyramidLevels, Pixel* a_result);
+
+        // Sweep mode: every set of m_sweepParams filters the input that ExecuteFilters uploaded, results go to m_sweepResults.
+        // Sets are recorded in batches of SWEEP_BATCH_BYTES of results, one command buffer and one readback per batch.
+        void ExecuteSweep(int a_w, int a_h);
+
+        // Images, buffers sized by the padded tile, descriptor sets, pipelines and command buffers of one filter configuration
+        void CreateResources(int a_w, int a_h, const std::vector<PyramidLevel>& a_pyramidLevels);
+
+        // Key of a padded tile in the tile cache: pixels of the frames and layers the filters read and everything
+        // in the configuration that changes the result
+        uint64_t TileKey(const SourceFrames& a_tile, int a_framesToUse) const;
+
+        // std::cout, or a stream that drops everything when SetVerbose(false)
+        std::ostream& Log() const;
+
+        // m_outputPath or output-<mode of the last RunOnGPU>.png/exr
+        std::string OutputFileName() const;
+
+        // OutputFileName with -sweep<a_index> before the extension
+        std::string SweepFileName(size_t a_index) const;
+
+        // Writes a_w x a_h pixels as EXR (a_isHDR) or PNG
+        static void SaveImage(const std::string& a_fileName, const std::vector<Pixel>& a_pixels, int a_w, int a_h, bool a_isHDR);
+
+        void RunOnGPU(bool nlmFilter, bool nonlinear, bool multiframe, bool execAndCopyOverlap, bool useLayers);
+
+        void RunOnCPU(std::string fileName, int numThreads);
+};
+
+#endif // COMPUTE_APPLICATION_HPP
@@ -0,0 +1,738 @@
+#include "daemon.hpp"
+#include "autotune.hpp"
+#include "shm_ring.hpp"
+#include "option_check.hpp"
+#include "json_string.hpp"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include <functional>
+#include <condition_variable>
+#include <cerrno>
+#include <cctype>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using Clock    = std::chrono::steady_clock;
+using Priority = QueueScheduler::Priority;
+
+// Where the replies of one connection (or of stdin) go, jobs keep it alive after the connection is read to the end
+class Client
+{
+    public:
+
+        Client(int a_fd, bool a_owner) : m_fd(a_fd), m_owner(a_owner) { }
+        ~Client() { if (m_owner) close(m_fd); }
+
+        Client(const Client&) = delete;
+        Client& operator=(const Client&) = delete;
+
+        int GetFd() const { return m_fd; }
+
+        void Send(const std::string& a_line)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            const std::string data{ a_line + "\n" };
+            size_t sent{};
+
+            while (sent < data.size())
+            {
+                const ssize_t written{ write(m_fd, data.data() + sent, data.size() - sent) };
+                if (written < 0 && errno == EINTR) continue;
+                if (written <= 0) return; // the client went away, the job is done anyway
+
+                sent += size_t(written);
+            }
+        }
+
+    private:
+
+        int        m_fd{};
+        bool       m_owner{};
+        std::mutex m_mutex{};
+};
+
+struct Job
+{
+    std::string  id{};
+    std::string  input{};
+    std::string  shm{};
+    std::string  output{};
+    bool         nlmFilter{}, linear{}, texture{}, multiframe{}, overlap{}, layers{};
+    ComputeApplication::FilterParams filterParams{};
+    int          pyramidLevels{};
+    float        sparseThreshold{};
+    int          tileSize{};
+    Priority     priority{QueueScheduler::PRIORITY_BATCH};
+    std::shared_ptr<Client> client{};
+    Clock::time_point       submitted{};
+};
+
+class JobQueue
+{
+    public:
+
+        enum PopResult
+        {
+            POP_JOB,
+            POP_TIMEOUT,
+            POP_CLOSED, // closed and drained
+        };
+
+        void Push(Job a_job)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_jobs[a_job.priority].push_back(std::move(a_job));
+            }
+            // one of the waiting workers may take interactive jobs only
+            m_changed.notify_all();
+        }
+
+        // interactive jobs go first, a_interactiveOnly - leave batch jobs to the other workers
+        PopResult Pop(Job& a_job, std::chrono::milliseconds a_timeout, bool a_interactiveOnly = false)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            auto ready = [&]{ return !m_jobs[QueueScheduler::PRIORITY_INTERACTIVE].empty()
+                || (!a_interactiveOnly && !m_jobs[QueueScheduler::PRIORITY_BATCH].empty()); };
+
+            if (!m_changed.wait_for(lock, a_timeout, [&]{ return ready() || m_closed; }))
+            {
+                return POP_TIMEOUT;
+            }
+
+            if (!ready())
+            {
+                return POP_CLOSED;
+            }
+
+            std::deque<Job>& jobs{ m_jobs[(m_jobs[QueueScheduler::PRIORITY_INTERACTIVE].empty())
+                ? QueueScheduler::PRIORITY_BATCH : QueueScheduler::PRIORITY_INTERACTIVE] };
+
+            a_job = std::move(jobs.front());
+            jobs.pop_front();
+            return POP_JOB;
+        }
+
+        void Close()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = true;
+            }
+            m_changed.notify_all();
+        }
+
+    private:
+
+        std::mutex              m_mutex{};
+        std::condition_variable m_changed{};
+        std::deque<Job>         m_jobs[QueueScheduler::PRIORITY_COUNT]{};
+        bool                    m_closed{};
+};
+
+// Device memory of the running jobs (and of the resources idle workers keep warm)
+class MemoryBudget
+{
+    public:
+
+        explicit MemoryBudget(size_t a_budget) : m_budget(a_budget) { }
+
+        size_t GetBudget() const { return m_budget; }
+
+        // blocks until a_bytes fit next to the reservations of the other workers,
+        // batch jobs also wait while an interactive one does
+        void Reserve(size_t a_bytes, Priority a_priority)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            ++m_waiting[a_priority];
+            m_released.wait(lock, [&]{ return m_reserved + a_bytes <= m_budget
+                && (a_priority == QueueScheduler::PRIORITY_INTERACTIVE || m_waiting[QueueScheduler::PRIORITY_INTERACTIVE] == 0); });
+            --m_waiting[a_priority];
+
+            m_reserved += a_bytes;
+            m_released.notify_all();
+        }
+
+        void Release(size_t a_bytes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_reserved -= a_bytes;
+            }
+            m_released.notify_all();
+        }
+
+        // a worker waits for memory, idle workers should give up their warm resources
+        bool Contended()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_waiting[QueueScheduler::PRIORITY_INTERACTIVE] + m_waiting[QueueScheduler::PRIORITY_BATCH] > 0;
+        }
+
+    private:
+
+        std::mutex              m_mutex{};
+        std::condition_variable m_released{};
+        size_t                  m_budget{};
+        size_t                  m_reserved{};
+        int                     m_waiting[QueueScheduler::PRIORITY_COUNT]{};
+};
+
+static size_t DeviceLocalMemory(VkPhysicalDevice a_physicalDevice)
+{
+    VkPhysicalDeviceMemoryProperties memoryProps{};
+    vkGetPhysicalDeviceMemoryProperties(a_physicalDevice, &memoryProps);
+
+    VkDeviceSize largest{};
+    for (uint32_t i{}; i < memoryProps.memoryHeapCount; ++i)
+    {
+        if (memoryProps.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            largest = std::max(largest, memoryProps.memoryHeaps[i].size);
+        }
+    }
+
+    return size_t(largest);
+}
+
+static std::string ErrorReply(const std::string& a_id, std::string a_message)
+{
+    // RUN_TIME_ERROR messages end with a new line
+    while (!a_message.empty() && isspace((unsigned char)a_message.back())) a_message.pop_back();
+
+    return "{\"id\":" + JsonString(a_id) + ",\"status\":\"error\",\"message\":" + JsonString(a_message) + "}";
+}
+
+// empty string - a_job is valid
+static std::string ParseJob(const std::string& a_line, Job& a_job)
+{
+    std::istringstream tokens{a_line};
+    std::string token{};
+
+    while (tokens >> token)
+    {
+        const size_t      eq{ token.find('=') };
+        const std::string key{ token.substr(0, eq) };
+        const std::string value{ (eq == std::string::npos) ? "" : token.substr(eq + 1) };
+
+        if      (key == "id")         a_job.id     = value;
+        else if (key == "input")      a_job.input  = value;
+        else if (key == "shm")        a_job.shm    = value;
+        else if (key == "output")     a_job.output = value;
+        else if (key == "spatial")    a_job.filterParams.spatialSigma       = float(atof(value.c_str()));
+        else if (key == "color")      a_job.filterParams.colorSigma         = float(atof(value.c_str()));
+        else if (key == "h")          a_job.filterParams.filteringParameter = float(atof(value.c_str()));
+        else if (key == "pyramid")    a_job.pyramidLevels   = atoi(value.c_str());
+        else if (key == "sparse")     a_job.sparseThreshold = float(atof(value.c_str()));
+        else if (key == "tile")       a_job.tileSize        = atoi(value.c_str());
+        else if (key == "linear")     a_job.linear     = true;
+        else if (key == "texture")    a_job.texture    = true;
+        else if (key == "multiframe") a_job.multiframe = true;
+        else if (key == "overlap")    a_job.overlap    = true;
+        else if (key == "layers")     a_job.layers     = true;
+        else if (key == "priority")
+        {
+            if      (value == "interactive") a_job.priority = QueueScheduler::PRIORITY_INTERACTIVE;
+            else if (value == "batch")       a_job.priority = QueueScheduler::PRIORITY_BATCH;
+            else return "unknown priority " + value;
+        }
+        else if (key == "filter")
+        {
+            if      (value == "nlm")       a_job.nlmFilter = true;
+            else if (value == "bialteral") a_job.nlmFilter = false;
+            else return "unknown filter " + value;
+        }
+        else return "unknown key " + key;
+    }
+
+    if (a_job.input.empty() == a_job.shm.empty())
+    {
+        return "a job needs either input= or shm=";
+    }
+
+    if (!a_job.input.empty() && a_job.output.empty())
+    {
+        return "output= is required for file input";
+    }
+
+    // same rules as the command line, named by the keys of the job
+    const Option optNlm{ a_job.nlmFilter, "filter=nlm" }, optLinear{ a_job.linear, "linear" }, optTexture{ a_job.texture, "texture" };
+    const Option optMultiframe{ a_job.multiframe, "multiframe" }, optLayers{ a_job.layers, "layers" };
+    const Option optSparse{ a_job.sparseThreshold > 0.0f, "sparse" }, optPyramid{ a_job.pyramidLevels > 0, "pyramid" };
+    const Option optShm{ !a_job.shm.empty(), "shm" };
+
+    OptionCheck check{};
+
+    check.Require(!a_job.multiframe || a_job.nlmFilter, "multiframe works with filter=nlm only");
+    check.Require(!a_job.overlap || a_job.multiframe, "overlap needs multiframe");
+    check.Exclude(optLinear, { optNlm, optLayers, optTexture });
+
+    check.Require(a_job.pyramidLevels == 0 || a_job.pyramidLevels >= 2, "pyramid needs at least 2 levels");
+    check.Exclude(optPyramid, { optLinear, optMultiframe, optLayers, optSparse });
+
+    check.Require(a_job.tileSize >= 0, "tile needs a positive size");
+    check.Exclude(optShm, { optMultiframe, optLayers });
+
+    return check.GetMessage();
+}
+
+// Calls a_onLine for every line of a_fd until the end of input or until a_onLine returns false
+static void ReadLines(int a_fd, const std::function<bool(const std::string&)>& a_onLine)
+{
+    std::string pending{};
+    char        buffer[4096];
+
+    while (true)
+    {
+        const ssize_t count{ read(a_fd, buffer, sizeof(buffer)) };
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+
+        pending.append(buffer, size_t(count));
+
+        size_t eol{};
+        while ((eol = pending.find('\n')) != std::string::npos)
+        {
+            std::string line{ pending.substr(0, eol) };
+            pending.erase(0, eol + 1);
+
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!a_onLine(line)) return;
+        }
+    }
+
+    if (!pending.empty())
+    {
+        a_onLine(pending);
+    }
+}
+
+int RunShmIngestion(ComputeApplication& a_app, ShmRing& a_ring, bool a_nlmFilter, bool a_nonlinear)
+{
+    ShmRing::Header* header{ a_ring.GetHeader() };
+
+    a_app.Log() << "shm ring: " << header->width << "x" << header->height << " "
+        << ((header->format == ShmRing::FORMAT_RGBA8) ? "RGBA8" : "RGBA32F") << ", " << header->slots << " slots\n";
+
+    int frames{};
+
+    while (true)
+    {
+        const int slot{ a_ring.Acquire(ShmRing::SLOT_READY, ShmRing::SLOT_BUSY, 1000) };
+        if (slot < 0)
+        {
+            if (header->closed.load()) break;
+            continue;
+        }
+
+        ComputeApplication::HostFrame frame{};
+        frame.w              = int(header->width);
+        frame.h              = int(header->height);
+        frame.isHDR          = header->format == ShmRing::FORMAT_RGBA32F;
+        frame.input          = a_ring.GetInput(slot);
+        frame.output         = a_ring.GetOutput(slot);
+        frame.inputCapacity  = header->inputStride;
+        frame.outputCapacity = header->outputStride;
+
+        a_app.Log() << "######\nframe " << header->frameId[slot] << " (slot " << slot << ")\n######\n";
+        a_app.SetHostFrame(frame);
+
+        try
+        {
+            a_app.RunOnGPU(a_nlmFilter, a_nonlinear, false, false, false);
+        }
+        catch (...)
+        {
+            a_app.SetHostFrame(ComputeApplication::HostFrame{});
+            throw;
+        }
+
+        a_ring.Release(slot, ShmRing::SLOT_DONE);
+        ++frames;
+
+        a_app.Log() << "transfer time: " << a_app.GetTranferTimeElapsed() << "ns; "
+            << "execution time: " << a_app.GetExecTimeElapsed() << "ns\n\n";
+    }
+
+    a_app.SetHostFrame(ComputeApplication::HostFrame{});
+    return frames;
+}
+
+class Daemon
+{
+    public:
+
+        explicit Daemon(const DaemonOptions& a_options)
+            : m_options(a_options),
+              m_device(ComputeApplication::CreateSharedDevice(a_options.deviceId)),
+              m_budget((a_options.memoryBudget > 0) ? a_options.memoryBudget : DeviceLocalMemory(m_device->physicalDevice) / 10 * 8)
+        {
+            if (m_options.useTuning)
+            {
+                m_deviceKey = AutoTuner::DeviceKey(m_options.deviceId);
+            }
+
+            if (m_options.tileCacheBytes > 0)
+            {
+                m_tileCache = std::make_shared<TileCache>(m_options.tileCacheBytes, m_options.tileCacheDir);
+            }
+        }
+
+        int Run()
+        {
+            std::cerr << "daemon: " << m_options.workers << " + 1 interactive workers on device " << m_options.deviceId
+                << " (" << m_device->deviceName << "), "
+                << (m_budget.GetBudget() >> 20) << " MiB budget, jobs from "
+                << ((m_options.socketPath.empty()) ? std::string("stdin") : m_options.socketPath) << "\n";
+
+            // replies are written to the client descriptors, a closed one must not kill the daemon
+            signal(SIGPIPE, SIG_IGN);
+
+            std::vector<std::thread> workers{};
+            for (int i{}; i < std::max(1, m_options.workers); ++i)
+            {
+                workers.emplace_back([this]{ WorkerLoop(false); });
+            }
+
+            // previews don't wait behind long batch jobs for a free worker
+            workers.emplace_back([this]{ WorkerLoop(true); });
+
+            int result{EXIT_SUCCESS};
+            try
+            {
+                if (m_options.socketPath.empty())
+                {
+                    auto client{ std::make_shared<Client>(STDOUT_FILENO, false) };
+                    ReadLines(STDIN_FILENO, [&](const std::string& a_line){ return HandleLine(a_line, client); });
+                }
+                else
+                {
+                    ServeSocket();
+                }
+            }
+            catch (const std::runtime_error& e)
+            {
+                std::cerr << e.what();
+                result = EXIT_FAILURE;
+            }
+
+            // queued jobs still run
+            m_queue.Close();
+            for (std::thread& worker : workers) worker.join();
+
+            return result;
+        }
+
+    private:
+
+        // false - stop reading
+        bool HandleLine(const std::string& a_line, const std::shared_ptr<Client>& a_client)
+        {
+            const size_t first{ a_line.find_first_not_of(" \t") };
+            if (first == std::string::npos || a_line[first] == '#')
+            {
+                return true;
+            }
+
+            std::string command{};
+            std::istringstream(a_line) >> command;
+
+            if (command == "quit")
+            {
+                Stop();
+                return false;
+            }
+
+            Job job{};
+            job.client    = a_client;
+            job.submitted = Clock::now();
+
+            const std::string error{ ParseJob(a_line, job) };
+            if (!error.empty())
+            {
+                a_client->Send(ErrorReply(job.id, error));
+                return true;
+            }
+
+            m_queue.Push(std::move(job));
+            return true;
+        }
+
+        void Stop()
+        {
+            m_stopping = true;
+
+            if (m_listenFd >= 0)
+            {
+                // wakes up accept
+                shutdown(m_listenFd, SHUT_RDWR);
+            }
+        }
+
+        void ServeSocket()
+        {
+            const std::string& path{ m_options.socketPath };
+
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (path.size() >= sizeof(address.sun_path))
+            {
+                RUN_TIME_ERROR(("daemon: socket path is too long: " + path).c_str());
+            }
+            strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+            const int listenFd{ socket(AF_UNIX, SOCK_STREAM, 0) };
+            if (listenFd < 0)
+            {
+                RUN_TIME_ERROR("daemon: can't create a socket");
+            }
+
+            unlink(path.c_str());
+            if (bind(listenFd, (sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 16) != 0)
+            {
+                close(listenFd);
+                RUN_TIME_ERROR(("daemon: can't listen on " + path).c_str());
+            }
+            m_listenFd = listenFd;
+
+            struct Connection
+            {
+                std::shared_ptr<Client>            client{};
+                std::shared_ptr<std::atomic<bool>> done{};
+                std::thread                        reader{};
+            };
+            std::vector<Connection> connections{};
+
+            while (!m_stopping)
+            {
+                const int fd{ accept(listenFd, nullptr, nullptr) };
+                if (fd < 0)
+                {
+                    if (!m_stopping && (errno == EINTR || errno == ECONNABORTED)) continue;
+                    break;
+                }
+
+                // join the readers of closed connections
+                for (size_t i{}; i < connections.size();)
+                {
+                    if (connections[i].done->load())
+                    {
+                        connections[i].reader.join();
+                        connections.erase(connections.begin() + i);
+                    }
+                    else ++i;
+                }
+
+                Connection connection{};
+                connection.client = std::make_shared<Client>(fd, true);
+                connection.done   = std::make_shared<std::atomic<bool>>(false);
+                connection.reader = std::thread([this, client = connection.client, done = connection.done]
+                {
+                    ReadLines(client->GetFd(), [&](const std::string& a_line){ return HandleLine(a_line, client); });
+                    done->store(true);
+                });
+                connections.push_back(std::move(connection));
+            }
+
+            // new jobs are not taken any more, the replies of the queued ones still reach their clients
+            for (Connection& connection : connections)
+            {
+                shutdown(connection.client->GetFd(), SHUT_RD);
+                connection.reader.join();
+            }
+
+            m_listenFd = -1;
+            close(listenFd);
+            unlink(path.c_str());
+        }
+
+        void WorkerLoop(bool a_interactiveOnly)
+        {
+            // own pools, descriptor sets and buffers on the device of the daemon
+            ComputeApplication app{""};
+            app.SetSharedDevice(m_device);
+            app.SetKeepDevice(true);
+            app.SetVerbose(m_options.verbose);
+            app.SetTileCache(m_tileCache);
+
+            size_t held{}; // reservation of the resources app keeps between jobs
+            Job    job{};
+
+            while (true)
+            {
+                const JobQueue::PopResult popped{ m_queue.Pop(job, std::chrono::milliseconds(100), a_interactiveOnly) };
+
+                if (popped == JobQueue::POP_CLOSED)
+                {
+                    break;
+                }
+
+                if (popped == JobQueue::POP_TIMEOUT)
+                {
+                    if (held > 0 && m_budget.Contended())
+                    {
+                        app.ReleaseResources();
+                        m_budget.Release(held);
+                        held = 0;
+                    }
+                    continue;
+                }
+
+                RunJob(app, job, held);
+                job = Job{};
+            }
+
+            m_budget.Release(held);
+        }
+
+        void RunJob(ComputeApplication& a_app, const Job& a_job, size_t& a_held)
+        {
+            try
+            {
+                // the size of the frame is known after loading (or from the ring header)
+                ComputeApplication::SourceFrames frames{};
+                std::unique_ptr<ShmRing>         ring{};
+                int  w{}, h{};
+                bool isHDR{};
+
+                if (!a_job.input.empty())
+                {
+                    a_app.SetImageSource(a_job.input);
+                    a_app.LoadSourceFrames(frames, a_job.multiframe, a_job.layers);
+
+                    if (frames.imageData.empty() && frames.imageDataHDR.empty())
+                    {
+                        RUN_TIME_ERROR(("can't load " + a_job.input).c_str());
+                    }
+
+                    w     = frames.w;
+                    h     = frames.h;
+                    isHDR = frames.isHDR;
+                }
+                else
+                {
+                    ring  = std::make_unique<ShmRing>(ShmRing::Open(a_job.shm));
+                    w     = int(ring->GetHeader()->width);
+                    h     = int(ring->GetHeader()->height);
+                    isHDR = ring->GetHeader()->format == ShmRing::FORMAT_RGBA32F;
+                }
+
+                ComputeApplication::WorkgroupSize workgroupSize{};
+                bool linear{ a_job.linear };
+
+                AutoTuner::Kernel kernel{};
+                kernel.nlmFilter     = a_job.nlmFilter;
+                kernel.useLayers     = a_job.layers;
+                kernel.sparse        = a_job.sparseThreshold > 0.0f;
+                kernel.pyramidLevels = a_job.pyramidLevels;
+
+                AutoTuner::Entry tuned{};
+                if (m_options.useTuning && m_tuner.Lookup(m_deviceKey, AutoTuner::FilterName(kernel), tuned))
+                {
+                    workgroupSize = tuned.workgroupSize;
+                    linear = linear || (tuned.linear && !a_job.texture && !a_job.multiframe && a_job.pyramidLevels == 0);
+                }
+
+                const size_t bytes{ ComputeApplication::EstimateDeviceMemory(w, h, isHDR, a_job.nlmFilter,
+                        (a_job.layers) ? int(frames.layerData.size()) : 0, a_job.overlap,
+                        a_job.pyramidLevels, a_job.tileSize) };
+
+                if (bytes > m_budget.GetBudget())
+                {
+                    RUN_TIME_ERROR(("job needs " + std::to_string(bytes >> 20) + " MiB of device memory, the budget is "
+                                + std::to_string(m_budget.GetBudget() >> 20) + " MiB (try tile=)").c_str());
+                }
+
+                // admission: resources of the previous job give way to this one's
+                if (bytes != a_held)
+                {
+                    a_app.ReleaseResources();
+                    m_budget.Release(a_held);
+                    a_held = 0;
+
+                    m_budget.Reserve(bytes, a_job.priority);
+                    a_held = bytes;
+                }
+
+                const Clock::time_point started{ Clock::now() };
+
+                a_app.SetPriority(a_job.priority);
+                a_app.SetWorkgroupSize(workgroupSize);
+                a_app.SetFilterParams(a_job.filterParams);
+                a_app.SetSparseDispatch(a_job.sparseThreshold > 0.0f, a_job.sparseThreshold);
+                a_app.SetPyramidLevels(a_job.pyramidLevels);
+                a_app.SetTileSize(a_job.tileSize);
+
+                int framesDone{1};
+                if (ring)
+                {
+                    framesDone = RunShmIngestion(a_app, *ring, a_job.nlmFilter, !linear);
+                }
+                else
+                {
+                    a_app.SetOutputPath(a_job.output);
+                    a_app.SetSourceFrames(std::move(frames));
+
+                    try
+                    {
+                        a_app.RunOnGPU(a_job.nlmFilter, !linear, a_job.multiframe, a_job.overlap, a_job.layers);
+                    }
+                    catch (...)
+                    {
+                        a_app.SetSourceFrames(ComputeApplication::SourceFrames{});
+                        throw;
+                    }
+
+                    a_app.SetSourceFrames(ComputeApplication::SourceFrames{});
+                }
+
+                const Clock::time_point finished{ Clock::now() };
+                auto ms = [](Clock::duration a_duration) { return std::chrono::duration<double, std::milli>(a_duration).count(); };
+
+                std::ostringstream reply{};
+                reply << "{\"id\":" << JsonString(a_job.id) << ",\"status\":\"ok\""
+                    << ",\"frames\":" << framesDone
+                    << ",\"cached_tiles\":" << a_app.GetCachedTiles()
+                    << ",\"queue_ms\":" << ms(started - a_job.submitted)
+                    << ",\"total_ms\":" << ms(finished - a_job.submitted)
+                    << ",\"exec_ms\":" << double(a_app.GetExecTimeElapsed()) * 1e-6
+                    << ",\"transfer_ms\":" << double(a_app.GetTranferTimeElapsed()) * 1e-6 << "}";
+                a_job.client->Send(reply.str());
+            }
+            catch (const std::exception& e)
+            {
+                a_job.client->Send(ErrorReply(a_job.id, e.what()));
+            }
+        }
+
+        DaemonOptions     m_options{};
+        std::shared_ptr<ComputeApplication::SharedDevice> m_device{}; // outlives the workers
+        std::shared_ptr<TileCache> m_tileCache{};
+        AutoTuner         m_tuner{};     // read only after construction
+        std::string       m_deviceKey{};
+        JobQueue          m_queue{};
+        MemoryBudget      m_budget;
+        std::atomic<bool> m_stopping{};
+        std::atomic<int>  m_listenFd{-1};
+};
+
+int RunDaemon(const DaemonOptions& a_options)
+{
+    Daemon daemon{a_options};
+    return daemon.Run();
+}
@@ -0,0 +1,53 @@
+#ifndef DAEMON_HPP
+#define DAEMON_HPP
+
+#include <string>
+#include <cstddef>
+
+#include "compute_application.hpp"
+
+class ShmRing;
+
+// Long-running mode of vulkan_denoice (`--daemon`): the workers share one Vulkan device (ComputeApplication::SetSharedDevice),
+// every worker keeps its own pipelines, command pools and buffers warm (SetKeepDevice) and takes jobs from a queue fed by
+// a Unix socket or stdin. Command buffers of the running jobs go to the queue through QueueScheduler.
+//
+// One job per line, whitespace separated key=value pairs and flags:
+//
+//     id=frame42 input=/farm/frame42.exr output=/farm/out/frame42.exr filter=nlm sparse=0.01
+//     id=live shm=/vulkan_denoice filter=bialteral spatial=3 color=0.1
+//
+//     input=<path> | shm=<name>  image file (neighbour frames and layers are searched near it) or shared-memory ring,
+//                                the job then lasts until the producer closes the ring; paths can't contain spaces
+//     output=<path>              result file, required for file input
+//     filter=bialteral|nlm       spatial=, color=, h= - filter parameters
+//     pyramid=<n> sparse=<t> tile=<size>, flags: linear texture multiframe overlap layers
+//     priority=interactive|batch interactive jobs are taken first, get device memory first and submit before batch ones;
+//                                one more worker takes interactive jobs only (default batch)
+//
+// Every job gets one JSON line back: {"id":..,"status":"ok",...timings} or {"id":..,"status":"error","message":..}.
+// `quit` stops the daemon once the queued jobs are done (so does the end of stdin).
+//
+// With a tile cache (`--tile-cache`) the workers share it: a job whose tiles did not change since an earlier job
+// (a re-render with local edits) only dispatches the changed tiles.
+//
+// Admission control: a job starts only when its EstimateDeviceMemory fits into the memory budget next to the jobs
+// that are running; a job that does not fit even alone is refused.
+struct DaemonOptions
+{
+    std::string socketPath{};   // empty - jobs come from stdin, replies go to stdout
+    int         workers{2};     // batch jobs that run at once (plus one interactive worker)
+    int         deviceId{};
+    size_t      memoryBudget{}; // bytes, 0 - 80% of the largest device local heap
+    bool        useTuning{true};
+    bool        verbose{};      // keep the progress output of the engine
+    size_t      tileCacheBytes{}; // > 0 - all jobs run incrementally on one TileCache of that size
+    std::string tileCacheDir{};   // where the tile cache is mirrored, empty - memory only
+};
+
+int RunDaemon(const DaemonOptions& a_options);
+
+// Denoises frames of the shared-memory ring until the producer closes it, returns the number of frames
+int RunShmIngestion(ComputeApplication& a_app, ShmRing& a_ring, bool a_nlmFilter, bool a_nonlinear);
+
+#endif // DAEMON_HPP
@@ -0,0 +1,185 @@
+#include "denoise.hpp"
+#include "compute_application.hpp"
+#include "autotune.hpp"
+#include "pixel_format.hpp"
+
+#include <cstring>
+
+using Pixel = ComputeApplication::Pixel;
+
+static void CheckView(const denoise::ImageView& a_view, const char* a_name)
+{
+    if (a_view.data == nullptr || a_view.width <= 0 || a_view.height <= 0)
+    {
+        RUN_TIME_ERROR((std::string("denoise: empty ") + a_name + " view").c_str());
+    }
+
+    if (a_view.rowPitch != 0 && a_view.rowPitch < size_t(a_view.width) * denoise::BytesPerPixel(a_view.format))
+    {
+        RUN_TIME_ERROR((std::string("denoise: row pitch of ") + a_name + " view is smaller than a row").c_str());
+    }
+}
+
+static size_t RowPitch(const denoise::ImageView& a_view)
+{
+    return (a_view.rowPitch != 0) ? a_view.rowPitch : size_t(a_view.width) * denoise::BytesPerPixel(a_view.format);
+}
+
+size_t denoise::BytesPerPixel(PixelFormat a_format)
+{
+    switch (a_format)
+    {
+        case PixelFormat::RGBA8:   return 4;
+        case PixelFormat::RGBA16F: return 8;
+        case PixelFormat::RGBA32F: return 16;
+    }
+
+    return 0;
+}
+
+denoise::Session::Session(int a_deviceId, bool a_useTuning)
+    : m_app(std::make_unique<ComputeApplication>("")), m_deviceId(a_deviceId), m_useTuning(a_useTuning)
+{
+    m_app->SetDeviceId(a_deviceId);
+    m_app->SetSaveOutput(false);
+    m_app->SetKeepDevice(true);
+
+    if (m_useTuning)
+    {
+        m_tuner     = std::make_unique<AutoTuner>();
+        m_deviceKey = AutoTuner::DeviceKey(a_deviceId);
+    }
+}
+
+denoise::Session::~Session() = default;
+
+uint64_t denoise::Session::GetExecTimeElapsed() const
+{
+    return m_app->GetExecTimeElapsed();
+}
+
+uint64_t denoise::Session::GetTransferTimeElapsed() const
+{
+    return m_app->GetTranferTimeElapsed();
+}
+
+void denoise::Session::Denoise(const ImageView& a_in, const ImageView& a_out, const Params& a_params)
+{
+    CheckView(a_in, "input");
+    CheckView(a_out, "output");
+
+    if (a_in.width != a_out.width || a_in.height != a_out.height)
+    {
+        RUN_TIME_ERROR("denoise: input and output views have different sizes");
+    }
+
+    const int  w{ a_in.width }, h{ a_in.height };
+    const bool nlmFilter{ a_params.filter == Filter::NonLocalMeans };
+
+    // engine takes tightly packed RGBA8 (8-bit texture) or RGBA32F and writes RGBA32F: such views are passed as they are,
+    // so aligned caller buffers are imported and used in place; half floats and padded rows go through a copy
+    const bool isHDR{ a_in.format != PixelFormat::RGBA8 };
+    const bool inputInPlace{ a_in.format != PixelFormat::RGBA16F && RowPitch(a_in) == size_t(w) * BytesPerPixel(a_in.format) };
+    const bool outputInPlace{ a_out.format == PixelFormat::RGBA32F && RowPitch(a_out) == size_t(w) * sizeof(Pixel) };
+
+    std::vector<uint8_t> input{};
+    std::vector<Pixel>   output{};
+
+    if (!inputInPlace)
+    {
+        input.resize(size_t(w) * h * ((isHDR) ? sizeof(Pixel) : sizeof(uint32_t)));
+
+        // rows of a large frame go to several threads
+#pragma omp parallel for if (size_t(w) * h >= pixel_format::PARALLEL_PIXELS)
+        for (int y = 0; y < h; ++y)
+        {
+            const uint8_t* row{ (const uint8_t*)a_in.data + y * RowPitch(a_in) };
+
+            if (a_in.format == PixelFormat::RGBA16F)
+            {
+                pixel_format::Rgba16FToRgba32F((const uint16_t*)row, (float*)input.data() + size_t(y) * w * 4, w);
+            }
+            else
+            {
+                const size_t rowSize{ size_t(w) * BytesPerPixel(a_in.format) };
+                memcpy(input.data() + y * rowSize, row, rowSize);
+            }
+        }
+    }
+
+    if (!outputInPlace)
+    {
+        output.resize(size_t(w) * h);
+    }
+
+    ComputeApplication::HostFrame frame{};
+    frame.w              = w;
+    frame.h              = h;
+    frame.isHDR          = isHDR;
+    frame.input          = (inputInPlace) ? a_in.data : input.data();
+    frame.output         = (outputInPlace) ? a_out.data : output.data();
+    frame.inputCapacity  = (inputInPlace) ? RowPitch(a_in) * h : input.size();
+    frame.outputCapacity = (outputInPlace) ? RowPitch(a_out) * h : sizeof(Pixel) * output.size();
+
+    ComputeApplication::FilterParams filterParams{};
+    filterParams.spatialSigma       = a_params.spatialSigma;
+    filterParams.colorSigma         = a_params.colorSigma;
+    filterParams.filteringParameter = a_params.filteringParameter;
+
+    m_app->SetFilterParams(filterParams);
+    m_app->SetPyramidLevels(a_params.pyramidLevels);
+    m_app->SetSparseDispatch(a_params.sparseThreshold > 0.0f, a_params.sparseThreshold);
+    m_app->SetTileSize(a_params.tileSize);
+    m_app->SetHostFrame(frame);
+
+    AutoTuner::Kernel kernel{};
+    kernel.nlmFilter     = nlmFilter;
+    kernel.sparse        = a_params.sparseThreshold > 0.0f;
+    kernel.pyramidLevels = a_params.pyramidLevels;
+
+    AutoTuner::Entry tuned{};
+    if (m_tuner && m_tuner->Lookup(m_deviceKey, AutoTuner::FilterName(kernel), tuned))
+    {
+        m_app->SetWorkgroupSize(tuned.workgroupSize);
+    }
+
+    // texel buffer only where the tuner found it faster and the mode supports it
+    const bool linear{ tuned.linear && !nlmFilter && a_params.pyramidLevels <= 1 };
+
+    m_app->SetVerbose(a_params.verbose);
+    try
+    {
+        m_app->RunOnGPU(nlmFilter, !linear, false, false, false);
+    }
+    catch (...)
+    {
+        m_app->SetHostFrame(ComputeApplication::HostFrame{});
+        throw;
+    }
+    m_app->SetHostFrame(ComputeApplication::HostFrame{});
+
+    if (outputInPlace)
+    {
+        return;
+    }
+
+#pragma omp parallel for if (size_t(w) * h >= pixel_format::PARALLEL_PIXELS)
+    for (int y = 0; y < h; ++y)
+    {
+        uint8_t*     row{ (uint8_t*)a_out.data + y * RowPitch(a_out) };
+        const float* src{ (const float*)(output.data() + size_t(y) * w) };
+
+        switch (a_out.format)
+        {
+            case PixelFormat::RGBA8:
+                pixel_format::Rgba32FToRgba8(src, row, w);
+                break;
+            case PixelFormat::RGBA16F:
+                pixel_format::Rgba32FToRgba16F(src, (uint16_t*)row, w);
+                break;
+            case PixelFormat::RGBA32F:
+                memcpy(row, src, sizeof(Pixel) * w);
+                break;
+        }
+    }
+}
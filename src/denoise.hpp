@@ -0,0 +1,86 @@
+#ifndef DENOISE_HPP
+#define DENOISE_HPP
+
+#include <memory>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+class ComputeApplication;
+class AutoTuner;
+
+// In-process API of the denoiser (libdenoise): pixels come from and go to caller memory, no files are touched.
+//
+//     denoise::Session session{};
+//     session.Denoise(denoise::ImageView{src, w, h, denoise::PixelFormat::RGBA32F},
+//                     denoise::ImageView{dst, w, h, denoise::PixelFormat::RGBA8, dstPitch}, denoise::Params{});
+//
+// Errors are reported with std::runtime_error.
+namespace denoise
+{
+    enum class PixelFormat
+    {
+        RGBA8,   // unorm, 4 bytes per pixel
+        RGBA16F, // IEEE half, 8 bytes per pixel
+        RGBA32F, // 16 bytes per pixel
+    };
+
+    enum class Filter
+    {
+        Bialteral,
+        NonLocalMeans,
+    };
+
+    // Caller-owned image, rows are rowPitch bytes apart (0 - tightly packed). Input views are never written.
+    struct ImageView
+    {
+        void*       data{};
+        int         width{}, height{};
+        PixelFormat format{PixelFormat::RGBA32F};
+        size_t      rowPitch{};
+    };
+
+    struct Params
+    {
+        Filter filter{Filter::Bialteral};
+        float  spatialSigma{2.0f};       // bialteral: influence of distant pixels
+        float  colorSigma{0.2f};         // bialteral: influence of pixels with different intensity
+        float  filteringParameter{0.5f}; // nlm: patch distance decay
+        int    pyramidLevels{};          // > 1 - multi-scale mode (see SetPyramidLevels)
+        float  sparseThreshold{};        // > 0 - filter only tiles noisier than this (see SetSparseDispatch)
+        int    tileSize{};               // > 0 - out-of-core tiles (see SetTileSize)
+        bool   verbose{};                // let the engine print its progress to stdout
+    };
+
+    size_t BytesPerPixel(PixelFormat a_format);
+
+    // One GPU (a_deviceId), tuned workgroup sizes are taken from the auto-tuner cache when it has them.
+    // The device and the resources of the last image size stay alive until the session is destroyed.
+    class Session
+    {
+        public:
+
+            explicit Session(int a_deviceId = 0, bool a_useTuning = true);
+            ~Session();
+
+            Session(const Session&) = delete;
+            Session& operator=(const Session&) = delete;
+
+            // a_in and a_out must have the same size, formats may differ
+            void Denoise(const ImageView& a_in, const ImageView& a_out, const Params& a_params);
+
+            // GPU time of the last Denoise (ns)
+            uint64_t GetExecTimeElapsed() const;
+            uint64_t GetTransferTimeElapsed() const;
+
+        private:
+
+            std::unique_ptr<ComputeApplication> m_app;
+            std::unique_ptr<AutoTuner>          m_tuner{};     // cache read once, nullptr - no tuning
+            std::string                         m_deviceKey{};
+            int                                 m_deviceId{};
+            bool                                m_useTuning{};
+    };
+}
+
+#endif // DENOISE_HPP
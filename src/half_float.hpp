@@ -0,0 +1,94 @@
+#ifndef HALF_FLOAT_HPP
+#define HALF_FLOAT_HPP
+
+#include <cstdint>
+#include <cstring>
+
+// IEEE 754 binary16 <-> binary32 on the host, bit exact with packHalf2x16/unpackHalf2x16 of the shaders for finite values.
+// Rounding is to nearest even, values above the half range become infinity, NaN stays NaN.
+namespace half_float
+{
+    inline uint16_t FromFloat(float a_value)
+    {
+        uint32_t bits{};
+        memcpy(&bits, &a_value, sizeof(bits));
+
+        const uint32_t sign{ (bits >> 16) & 0x8000u };
+        const uint32_t absBits{ bits & 0x7FFFFFFFu };
+
+        if (absBits >= 0x7F800000u)
+        {
+            // infinity or NaN (with a quiet bit so it stays NaN)
+            return uint16_t(sign | 0x7C00u | ((absBits > 0x7F800000u) ? 0x0200u : 0u));
+        }
+
+        if (absBits >= 0x477FF000u)
+        {
+            // rounds to 65520 or more
+            return uint16_t(sign | 0x7C00u);
+        }
+
+        if (absBits < 0x38800000u)
+        {
+            // subnormal half: the implicit bit joins the mantissa, which is then shifted into place with rounding
+            if (absBits < 0x33000000u)
+            {
+                return uint16_t(sign);
+            }
+
+            const uint32_t exponent{ absBits >> 23 };
+            const uint32_t mantissa{ (absBits & 0x007FFFFFu) | 0x00800000u };
+            const uint32_t shift{ 126u - exponent };
+            const uint32_t halfMantissa{ mantissa >> shift };
+            const uint32_t rest{ mantissa & ((1u << shift) - 1u) };
+            const uint32_t halfway{ 1u << (shift - 1u) };
+            const uint32_t rounded{ halfMantissa + ((rest > halfway || (rest == halfway && (halfMantissa & 1u))) ? 1u : 0u) };
+
+            return uint16_t(sign | rounded);
+        }
+
+        // normal half: rebias the exponent and round the 13 dropped mantissa bits to nearest even
+        const uint32_t rebased{ absBits - 0x38000000u };
+        const uint32_t rounded{ rebased + 0x0FFFu + ((rebased >> 13) & 1u) };
+
+        return uint16_t(sign | (rounded >> 13));
+    }
+
+    inline float ToFloat(uint16_t a_value)
+    {
+        const uint32_t sign{ uint32_t(a_value & 0x8000u) << 16 };
+        const uint32_t exponent{ (a_value >> 10) & 0x1Fu };
+        uint32_t       mantissa{ a_value & 0x03FFu };
+        uint32_t       bits{};
+
+        if (exponent == 0x1Fu)
+        {
+            bits = sign | 0x7F800000u | (mantissa << 13);
+        }
+        else if (exponent != 0)
+        {
+            bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+        }
+        else if (mantissa != 0)
+        {
+            // subnormal half: normalize it for the float exponent
+            uint32_t e{ 113u };
+            while ((mantissa & 0x0400u) == 0)
+            {
+                mantissa <<= 1;
+                --e;
+            }
+            bits = sign | (e << 23) | ((mantissa & 0x03FFu) << 13);
+        }
+        else
+        {
+            bits = sign;
+        }
+
+        float value{};
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+#endif // HALF_FLOAT_HPP
@@ -0,0 +1,32 @@
+#ifndef JSON_STRING_HPP
+#define JSON_STRING_HPP
+
+#include <string>
+#include <cstdio>
+
+// JSON string literal with quotes, backslashes and control characters escaped (bench results, daemon replies)
+inline std::string JsonString(const std::string& a_value)
+{
+    std::string literal{"\""};
+    for (const char c : a_value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            literal += '\\';
+            literal += c;
+        }
+        else if ((unsigned char)c < 0x20)
+        {
+            char escaped[8]{};
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+            literal += escaped;
+        }
+        else
+        {
+            literal += c;
+        }
+    }
+    return literal + "\"";
+}
+
+#endif // JSON_STRING_HPP
@@ -0,0 +1,423 @@
+#include "multi_device.hpp"
+#include "autotune.hpp"
+#include "telemetry.hpp"
+
+#include <thread>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <filesystem>
+
+using Pixel        = ComputeApplication::Pixel;
+using SourceFrames = ComputeApplication::SourceFrames;
+
+MultiDevice::MultiDevice(const Options& a_options) : m_options(a_options)
+{
+    if (m_options.deviceIds.empty())
+    {
+        m_options.deviceIds = AllDevices();
+    }
+
+    if (m_options.deviceIds.empty())
+    {
+        RUN_TIME_ERROR("no Vulkan devices with a compute queue");
+    }
+
+    if (m_options.cpuThreads > 0 && (m_options.nlmFilter || m_options.layers || m_options.sparse || m_options.pyramidLevels > 1))
+    {
+        RUN_TIME_ERROR("the CPU filter is bialteral only (no layers, sparse dispatch or pyramid)");
+    }
+
+    AutoTuner tuner{};
+
+    for (const int deviceId : m_options.deviceIds)
+    {
+        Device device{};
+        device.id  = deviceId;
+        device.app = std::make_unique<ComputeApplication>("");
+
+        ComputeApplication& app{ *device.app };
+        app.SetDeviceId(deviceId);
+        app.SetKeepDevice(true);
+        app.SetVerbose(m_options.verbose); // step messages of several threads would be interleaved
+        app.SetZeroCopy(m_options.zeroCopy);
+        app.SetFilterParams(m_options.filterParams);
+        app.SetSparseDispatch(m_options.sparse, m_options.sparseThreshold);
+        app.SetPyramidLevels(m_options.pyramidLevels);
+        app.SetTileSize(m_options.tileSize);
+
+        AutoTuner::Kernel kernel{};
+        kernel.nlmFilter     = m_options.nlmFilter;
+        kernel.useLayers     = m_options.layers;
+        kernel.sparse        = m_options.sparse;
+        kernel.pyramidLevels = m_options.pyramidLevels;
+
+        AutoTuner::Entry tuned{};
+        if (m_options.useTuning && tuner.Lookup(AutoTuner::DeviceKey(deviceId), AutoTuner::FilterName(kernel), tuned))
+        {
+            app.SetWorkgroupSize(tuned.workgroupSize);
+        }
+
+        m_devices.push_back(std::move(device));
+    }
+
+    if (m_options.cpuThreads > 0)
+    {
+        // goes last, the probe of RunSplit takes the first device as the GPU
+        Device cpu{};
+        cpu.id  = CPU_DEVICE;
+        cpu.app = std::make_unique<ComputeApplication>("");
+        cpu.app->SetVerbose(m_options.verbose);
+        m_devices.push_back(std::move(cpu));
+    }
+}
+
+std::vector<int> MultiDevice::AllDevices()
+{
+    std::vector<const char *> enabledLayers{};
+    VkInstance instance{ vk_utils::CreateInstance(false, enabledLayers) };
+
+    const std::vector<int> deviceIds{ vk_utils::FindComputeDevices(instance) };
+
+    vkDestroyInstance(instance, NULL);
+    return deviceIds;
+}
+
+int MultiDevice::Take(size_t a_device, int& a_units)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Device& device{ m_devices[a_device] };
+
+    if (m_next >= m_count || m_error)
+    {
+        device.finished = true;
+        return -1;
+    }
+
+    int units{ m_chunk };
+
+    if (device.id == CPU_DEVICE && m_splitChunks)
+    {
+        // as many rows as the CPU filters while the fastest GPU does a band, a few rows until both are measured
+        double fastest{};
+        for (const Device& other : m_devices)
+        {
+            if (other.id != CPU_DEVICE) fastest = std::max(fastest, other.rowsPerSecond);
+        }
+
+        units = (device.rowsPerSecond > 0.0 && fastest > 0.0) ? int(m_chunk * device.rowsPerSecond / fastest) : m_chunk / 8;
+        units = std::clamp(units, 1, m_chunk);
+    }
+
+    units = std::min(units, m_count - m_next);
+
+    const Clock::time_point now{ Clock::now() };
+    auto duration = [&](const Device& a_other) { return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(units / a_other.rowsPerSecond)); };
+
+    if (device.rowsPerSecond > 0.0)
+    {
+        // devices that would be done with this band earlier than we are, even after their current one
+        const Clock::time_point own{ now + duration(device) };
+        int faster{};
+
+        for (const Device& other : m_devices)
+        {
+            if (&other != &device && !other.finished && other.rowsPerSecond > 0.0 && std::max(now, other.busyUntil) + duration(other) < own)
+            {
+                ++faster;
+            }
+        }
+
+        // the tail is theirs, the fastest device never steps back so every band is taken
+        if (m_count - m_next <= faster * m_chunk)
+        {
+            device.finished = true;
+            return -1;
+        }
+
+        device.busyUntil = own;
+    }
+
+    a_units = units;
+    const int first{ m_next };
+    m_next += units;
+    return first;
+}
+
+void MultiDevice::Done(size_t a_device, int a_units, Clock::duration a_elapsed)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Device& device{ m_devices[a_device] };
+    const double seconds{ std::max(1e-6, std::chrono::duration<double>(a_elapsed).count()) };
+
+    // the first band also pays for device creation and pipelines, later ones pull the average down to the real speed
+    device.rowsPerSecond = (device.rowsPerSecond > 0.0) ? 0.5 * device.rowsPerSecond + 0.5 * a_units / seconds : a_units / seconds;
+    device.busyUntil     = Clock::now();
+    device.items        += 1;
+    device.rows         += a_units;
+    device.seconds      += seconds;
+}
+
+void MultiDevice::Distribute(int a_first, int a_count, int a_chunk, bool a_splitChunks, const std::function<void(Device&, int, int)>& a_work)
+{
+    m_next        = a_first;
+    m_count       = a_count;
+    m_chunk       = a_chunk;
+    m_splitChunks = a_splitChunks;
+    m_error       = nullptr;
+    for (Device& device : m_devices) device.finished = false;
+
+    std::vector<std::thread> threads{};
+    for (size_t i{}; i < m_devices.size(); ++i)
+    {
+        threads.emplace_back([this, i, &a_work]
+        {
+            int first{}, units{};
+            while ((first = Take(i, units)) >= 0)
+            {
+                const Clock::time_point started{ Clock::now() };
+
+                try
+                {
+                    a_work(m_devices[i], first, units);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_error) m_error = std::current_exception();
+                    m_devices[i].finished = true;
+                    return;
+                }
+
+                Done(i, units, Clock::now() - started);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) thread.join();
+
+    if (m_error)
+    {
+        std::rethrow_exception(m_error);
+    }
+}
+
+void MultiDevice::FilterBand(Device& a_device, const SourceFrames& a_frames, int a_y0, int a_rows, int a_bandH, Pixel* a_result)
+{
+    const int w{ a_frames.w };
+
+    if (a_device.id == CPU_DEVICE)
+    {
+        ComputeApplication::BialteralFilterCPU(a_frames, m_options.filterParams, a_y0, a_y0 + a_rows, m_options.cpuThreads, a_result);
+        return;
+    }
+
+    // the GPU sees the band with the apron on every side, so its reads outside of the image repeat the edge as on the CPU;
+    // it is padded to a_bandH rows, all bands then have one size and the resources are built once
+    const bool pyramid{ m_options.pyramidLevels > 1 };
+    const int  apron{ ComputeApplication::TileApron(m_options.nlmFilter, (pyramid) ? m_options.pyramidLevels : 0) };
+    const int  gw{ w + 2 * apron }, gh{ a_bandH + 2 * apron };
+
+    std::vector<Pixel> bandData(size_t(gw) * gh);
+
+    ComputeApplication& app{ *a_device.app };
+    app.SetSaveOutput(false);
+    app.SetSourceFrames(ComputeApplication::CropFrames(a_frames, -apron, a_y0 - apron, gw, gh));
+    app.SetResultOutput(bandData.data());
+
+    try
+    {
+        app.RunOnGPU(m_options.nlmFilter, !m_options.linear, m_options.multiframe, m_options.overlap, m_options.layers);
+    }
+    catch (...)
+    {
+        app.SetResultOutput(nullptr);
+        app.SetSourceFrames(SourceFrames{});
+        throw;
+    }
+
+    app.SetResultOutput(nullptr);
+    app.SetSourceFrames(SourceFrames{});
+
+    // stitching: only the interior of the band lands in the result
+    for (int y{}; y < a_rows; ++y)
+    {
+        memcpy(a_result + size_t(y) * w, &bandData[size_t(y + apron) * gw + apron], w * sizeof(Pixel));
+    }
+}
+
+void MultiDevice::RunSplit(const std::string& a_imageSource, const std::string& a_outputPath)
+{
+    SourceFrames frames{};
+    m_devices[0].app->SetImageSource(a_imageSource);
+    m_devices[0].app->LoadSourceFrames(frames, m_options.multiframe, m_options.layers);
+
+    if (frames.imageData.empty() && frames.imageDataHDR.empty())
+    {
+        RUN_TIME_ERROR(("can't load " + a_imageSource).c_str());
+    }
+
+    const int  w{ frames.w }, h{ frames.h };
+    const bool pyramid{ m_options.pyramidLevels > 1 };
+    const int  align{ (pyramid) ? (1 << (m_options.pyramidLevels - 1)) : 1 }; // keeps 2x2 downsampling in step with the whole image
+    const int  apron{ ComputeApplication::TileApron(m_options.nlmFilter, (pyramid) ? m_options.pyramidLevels : 0) };
+    const int  bands{ std::max(1, int(m_devices.size()) * m_options.bandsPerDevice) };
+
+    int bandH{ (h + bands - 1) / bands };
+    bandH = std::max(bandH, apron);
+    bandH = (bandH + align - 1) / align * align;
+
+    std::vector<Pixel> result(size_t(w) * h);
+
+    std::cout << "split " << w << "x" << h << " into bands of " << bandH << " rows (apron " << apron << ") on "
+        << m_devices.size() << " devices\n";
+
+    // the outermost Progress, quiet devices don't report their own
+    telemetry::Progress progress{ "bands", size_t(h), "rows" };
+
+    int first{};
+
+    if (m_options.cpuThreads > 0)
+    {
+        // probe: the first band on a GPU and its first rows on the CPU, both filters have to agree and the scheduler
+        // starts with the throughput of both sides instead of handing a whole band to the CPU blindly
+        const size_t gpu{ 0 }, cpu{ m_devices.size() - 1 };
+        const int    gpuRows{ std::min(bandH, h) }, cpuRows{ std::min(gpuRows, std::max(1, bandH / 8)) };
+        std::vector<Pixel> probe(size_t(cpuRows) * w);
+
+        Clock::time_point started{ Clock::now() };
+        FilterBand(m_devices[gpu], frames, 0, gpuRows, bandH, result.data());
+        Done(gpu, gpuRows, Clock::now() - started);
+
+        started = Clock::now();
+        FilterBand(m_devices[cpu], frames, 0, cpuRows, bandH, probe.data());
+        Done(cpu, cpuRows, Clock::now() - started);
+
+        float difference{};
+        for (size_t i{}; i < probe.size(); ++i)
+        {
+            difference = std::max({ difference, fabsf(probe[i].r - result[i].r), fabsf(probe[i].g - result[i].g),
+                    fabsf(probe[i].b - result[i].b), fabsf(probe[i].a - result[i].a) });
+        }
+
+        std::cerr << "cpu/gpu probe: " << cpuRows << " rows, max difference " << difference << "\n";
+
+        if (!(difference <= m_options.cpuTolerance))
+        {
+            RUN_TIME_ERROR(("CPU and GPU results differ by " + std::to_string(difference) + ", more than the tolerance "
+                        + std::to_string(m_options.cpuTolerance)).c_str());
+        }
+
+        first = gpuRows;
+        progress.Advance(gpuRows);
+    }
+
+    Distribute(first, h, bandH, true, [&](Device& a_device, int a_y0, int a_rows)
+    {
+        // bands don't overlap in the result, so no lock is needed
+        FilterBand(a_device, frames, a_y0, a_rows, bandH, &result[size_t(a_y0) * w]);
+        progress.Advance(a_rows);
+    });
+
+    progress.Finish();
+
+    std::string outputPath{ a_outputPath };
+    for (const Device& device : m_devices)
+    {
+        // mode of the run is known to the GPUs that took a band
+        if (outputPath.empty() && device.id != CPU_DEVICE && device.items > 0)
+        {
+            outputPath = device.app->OutputFileName();
+        }
+    }
+
+    if (outputPath.empty())
+    {
+        outputPath = std::string("output-cpu") + ((frames.isHDR) ? ".exr" : ".png");
+    }
+
+    ComputeApplication::SaveImage(outputPath, result, w, h, frames.isHDR);
+    std::cerr << "saved " << outputPath << "\n";
+}
+
+void MultiDevice::RunSequence(const std::vector<std::string>& a_frames)
+{
+    if (a_frames.empty())
+    {
+        return;
+    }
+
+    std::cout << "sequence of " << a_frames.size() << " frames on " << m_devices.size() << " devices\n";
+
+    telemetry::Progress progress{ "frames", a_frames.size(), "frames" };
+
+    // a frame is the unit of work (frames of a sequence have one size), throughput is then counted in frames
+    Distribute(0, int(a_frames.size()), 1, false, [&](Device& a_device, int a_frame, int)
+    {
+        const std::filesystem::path source{ a_frames[a_frame] };
+        const bool        isHDR{ source.extension() == ".exr" };
+        const std::string outputPath{ "output-" + source.stem().string() + ((isHDR) ? ".exr" : ".png") };
+
+        ComputeApplication& app{ *a_device.app };
+        app.SetImageSource(a_frames[a_frame]);
+
+        if (m_options.cpuThreads > 0)
+        {
+            // with the CPU in the game every device filters the frame as one band, the edges then match
+            SourceFrames frames{};
+            app.LoadSourceFrames(frames, false, false);
+
+            if (frames.imageData.empty() && frames.imageDataHDR.empty())
+            {
+                RUN_TIME_ERROR(("can't load " + a_frames[a_frame]).c_str());
+            }
+
+            std::vector<Pixel> result(size_t(frames.w) * frames.h);
+            FilterBand(a_device, frames, 0, frames.h, frames.h, result.data());
+            ComputeApplication::SaveImage(outputPath, result, frames.w, frames.h, frames.isHDR);
+            progress.Advance();
+            return;
+        }
+
+        app.SetSaveOutput(true);
+        app.SetOutputPath(outputPath);
+        app.RunOnGPU(m_options.nlmFilter, !m_options.linear, m_options.multiframe, m_options.overlap, m_options.layers);
+        app.SetOutputPath("");
+        progress.Advance();
+    });
+
+    progress.Finish();
+}
+
+void MultiDevice::PrintStats(std::ostream& a_out) const
+{
+    const bool split{ m_options.mode == MODE_SPLIT };
+
+    for (const Device& device : m_devices)
+    {
+        if (device.id == CPU_DEVICE)
+        {
+            a_out << "cpu (" << m_options.cpuThreads << " threads): ";
+        }
+        else
+        {
+            a_out << "device " << device.id << " (" << device.app->GetDeviceName() << "): ";
+        }
+
+        a_out << device.items << ((split) ? " bands, " : " frames, ")
+            << std::fixed << std::setprecision(1) << device.seconds << " s, "
+            << device.rowsPerSecond << ((split) ? " rows/s" : " frames/s");
+
+        if (split)
+        {
+            a_out << ", " << device.rows << " rows";
+        }
+
+        a_out << "\n";
+        a_out.unsetf(std::ios::fixed);
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef MULTI_DEVICE_HPP
+#define MULTI_DEVICE_HPP
+
+#include <mutex>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "compute_application.hpp"
+
+// Runs the filter on several logical devices at once (`--devices`). Every device gets its own ComputeApplication with
+// warm resources (SetKeepDevice); an id may repeat, that opens several logical devices on one physical device
+// (e.g. a software rasterizer on a host without GPU). With cpuThreads > 0 the OpenMP CPU filter
+// (ComputeApplication::BialteralFilterCPU) joins them as one more device (`--hybrid`, bialteral only).
+//
+// MODE_SPLIT cuts a frame into horizontal bands, every band is filtered with TileApron rows and columns around it and
+// only its interior lands in the result (the same stitching as the tiled mode), so the result does not depend on the
+// number of devices. MODE_SEQUENCE hands out whole frames of a sequence instead.
+//
+// Scheduling is dynamic: a device takes the next band (frame) as soon as it is done with the previous one, so a faster
+// device takes more of them. Throughput of every device is measured on the way (rows per second, moving average) and
+// the tail is weighted by it: a device leaves the last bands to the devices that would finish them earlier even after
+// their current band, instead of making everybody wait for the slowest one. GPU bands have one height (the resources
+// are built once), the CPU takes as many rows as it filters in the time the fastest GPU spends on a band.
+class MultiDevice
+{
+    public:
+
+        enum Mode
+        {
+            MODE_SPLIT,
+            MODE_SEQUENCE,
+        };
+
+        static constexpr int CPU_DEVICE = -1; // id of the CPU in the statistics
+
+        struct Options {
+            std::vector<int> deviceIds{};     // empty - every device with a compute queue
+            Mode  mode{MODE_SPLIT};
+            bool  nlmFilter{}, linear{}, multiframe{}, overlap{}, layers{};
+            bool  sparse{};
+            float sparseThreshold{};
+            int   pyramidLevels{};
+            int   tileSize{};                 // tiles inside of a band (frame)
+            int   bandsPerDevice{4};          // split: a frame is cut into devices * bandsPerDevice bands
+            int   cpuThreads{};               // > 0 - the CPU filters bands (frames) too
+            float cpuTolerance{1e-3f};        // largest CPU/GPU difference of a pixel channel the probe band accepts
+            ComputeApplication::FilterParams filterParams{};
+            bool  zeroCopy{true};
+            bool  useTuning{true};            // tuned workgroup size of every device
+            bool  verbose{};                  // keep the progress output of the engine
+        };
+
+        explicit MultiDevice(const Options& a_options);
+
+        // Ids of all physical devices with a compute queue
+        static std::vector<int> AllDevices();
+
+        // One frame (with its neighbour frames and layers as the options say) filtered in bands by all devices,
+        // the stitched result is saved to a_outputPath (empty - output-<mode>.png/exr)
+        void RunSplit(const std::string& a_imageSource, const std::string& a_outputPath);
+
+        // Every frame goes to one device, results are saved to output-<frame name>.png/exr
+        void RunSequence(const std::vector<std::string>& a_frames);
+
+        void PrintStats(std::ostream& a_out) const;
+
+    private:
+
+        using Clock = std::chrono::steady_clock;
+
+        struct Device {
+            int    id{};                      // CPU_DEVICE - the OpenMP filter
+            std::unique_ptr<ComputeApplication> app{}; // the CPU uses it only to load and name frames
+            double rowsPerSecond{};           // 0 - not measured yet
+            Clock::time_point busyUntil{};    // expected end of the current band
+            bool   finished{};                // left the current Distribute
+            int    items{};                   // bands (frames) done
+            int    rows{};
+            double seconds{};
+        };
+
+        // Runs a_work(device, first, count) over units [a_first, a_count) on all devices, rethrows the first error.
+        // A GPU takes a_chunk units at once, the CPU fewer of them if a_splitChunks.
+        void Distribute(int a_first, int a_count, int a_chunk, bool a_splitChunks, const std::function<void(Device&, int, int)>& a_work);
+
+        // First unit of the next chunk of a_device and its size, -1 - nothing left (or the rest is left to faster devices)
+        int  Take(size_t a_device, int& a_units);
+        void Done(size_t a_device, int a_units, Clock::duration a_elapsed);
+
+        // Band [a_y0, a_y0 + a_rows) of a_frames filtered on a_device, a_result gets a_rows rows of a_frames.w pixels
+        void FilterBand(Device& a_device, const ComputeApplication::SourceFrames& a_frames, int a_y0, int a_rows, int a_bandH,
+                ComputeApplication::Pixel* a_result);
+
+        Options             m_options{};
+        std::vector<Device> m_devices{};
+
+        std::mutex          m_mutex{};
+        int                 m_next{}, m_count{}, m_chunk{};
+        bool                m_splitChunks{};
+        std::exception_ptr  m_error{};
+};
+
+#endif // MULTI_DEVICE_HPP
@@ -0,0 +1,58 @@
+#ifndef OPTION_CHECK_HPP
+#define OPTION_CHECK_HPP
+
+#include <string>
+#include <initializer_list>
+
+// Option for OptionCheck: whether it was given and how it is spelled (command line option, daemon job key)
+struct Option
+{
+    bool        set;
+    const char* name;
+};
+
+// Checks of the options of a run (main, daemon jobs), only the first problem is kept so that the message names the
+// option that does not fit
+class OptionCheck
+{
+    public:
+
+        // a_mode does not work together with any of a_others
+        void Exclude(const Option& a_mode, std::initializer_list<Option> a_others)
+        {
+            for (const Option& other : a_others)
+            {
+                if (a_mode.set && other.set)
+                {
+                    Fail(std::string(a_mode.name) + " does not work with " + other.name);
+                    return;
+                }
+            }
+        }
+
+        // a_message when a_valid is false (a value out of range, a missing option)
+        void Require(bool a_valid, const std::string& a_message)
+        {
+            if (!a_valid)
+            {
+                Fail(a_message);
+            }
+        }
+
+        // empty if every check passed
+        const std::string& GetMessage() const { return m_message; }
+
+    private:
+
+        void Fail(const std::string& a_message)
+        {
+            if (m_message.empty())
+            {
+                m_message = a_message;
+            }
+        }
+
+        std::string m_message{};
+};
+
+#endif // OPTION_CHECK_HPP
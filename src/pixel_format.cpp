@@ -0,0 +1,305 @@
+#include "pixel_format.hpp"
+#include "half_float.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PIXEL_FORMAT_SSE2 1
+#endif
+
+#if defined(PIXEL_FORMAT_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define PIXEL_FORMAT_F16C 1
+#endif
+
+static constexpr size_t CHUNK_PIXELS = size_t(1) << 16; // work item of a thread, a multiple of the SIMD width
+
+// a_kernel(first, count) over [0, a_pixels), in chunks on OpenMP threads when the frame is large
+template <class Kernel>
+static void ForChunks(size_t a_pixels, const Kernel& a_kernel)
+{
+    if (a_pixels < pixel_format::PARALLEL_PIXELS)
+    {
+        a_kernel(size_t(0), a_pixels);
+        return;
+    }
+
+    const long long chunks{ (long long)((a_pixels + CHUNK_PIXELS - 1) / CHUNK_PIXELS) };
+
+#pragma omp parallel for schedule(static)
+    for (long long c = 0; c < chunks; ++c)
+    {
+        const size_t first{ size_t(c) * CHUNK_PIXELS };
+        a_kernel(first, std::min(CHUNK_PIXELS, a_pixels - first));
+    }
+}
+
+static inline uint8_t SaturateUnorm8(float a_value)
+{
+    // NaN fails the comparison and becomes 0, as in the SIMD path
+    const float scaled{ (a_value * 255.0f > 0.0f) ? std::min(a_value * 255.0f, 255.0f) : 0.0f };
+    return uint8_t(std::lrint(scaled));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// RGBA8 <-> RGBA32F
+//----------------------------------------------------------------------------------------------------------------------
+
+static void Rgba8ToRgba32FKernel(const uint8_t* a_src, float* a_dst, size_t a_pixels)
+{
+    size_t i{};
+
+#ifdef PIXEL_FORMAT_SSE2
+    const __m128  scale{ _mm_set1_ps(1.0f / 255.0f) };
+    const __m128i zero{ _mm_setzero_si128() };
+
+    // 4 pixels: 16 bytes -> 16 floats
+    for (; i + 4 <= a_pixels; i += 4)
+    {
+        const __m128i bytes{ _mm_loadu_si128((const __m128i*)(a_src + 4 * i)) };
+        const __m128i lo{ _mm_unpacklo_epi8(bytes, zero) }, hi{ _mm_unpackhi_epi8(bytes, zero) };
+
+        float* dst{ a_dst + 4 * i };
+        _mm_storeu_ps(dst + 0,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), scale));
+        _mm_storeu_ps(dst + 4,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), scale));
+        _mm_storeu_ps(dst + 8,  _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), scale));
+        _mm_storeu_ps(dst + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), scale));
+    }
+#endif
+
+    for (; i < a_pixels; ++i)
+    {
+        for (int c{}; c < 4; ++c)
+        {
+            a_dst[4 * i + c] = float(a_src[4 * i + c]) * (1.0f / 255.0f);
+        }
+    }
+}
+
+static void Rgba32FToRgba8Kernel(const float* a_src, uint8_t* a_dst, size_t a_pixels)
+{
+    size_t i{};
+
+#ifdef PIXEL_FORMAT_SSE2
+    const __m128 scale{ _mm_set1_ps(255.0f) };
+    const __m128 zero{ _mm_setzero_ps() }, maxValue{ _mm_set1_ps(255.0f) };
+
+    // 4 pixels: 16 floats -> 16 bytes; max(x, 0) picks 0 for NaN, cvtps rounds to nearest even
+    for (; i + 4 <= a_pixels; i += 4)
+    {
+        const float* src{ a_src + 4 * i };
+        __m128i v[4];
+
+        for (int k{}; k < 4; ++k)
+        {
+            const __m128 scaled{ _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + 4 * k), scale), zero), maxValue) };
+            v[k] = _mm_cvtps_epi32(scaled);
+        }
+
+        const __m128i words{ _mm_packs_epi32(v[0], v[1]) }, words2{ _mm_packs_epi32(v[2], v[3]) };
+        _mm_storeu_si128((__m128i*)(a_dst + 4 * i), _mm_packus_epi16(words, words2));
+    }
+#endif
+
+    for (; i < a_pixels; ++i)
+    {
+        for (int c{}; c < 4; ++c)
+        {
+            a_dst[4 * i + c] = SaturateUnorm8(a_src[4 * i + c]);
+        }
+    }
+}
+
+void pixel_format::Rgba8ToRgba32F(const uint8_t* a_src, float* a_dst, size_t a_pixels)
+{
+    ForChunks(a_pixels, [&](size_t a_first, size_t a_count) { Rgba8ToRgba32FKernel(a_src + 4 * a_first, a_dst + 4 * a_first, a_count); });
+}
+
+void pixel_format::Rgba32FToRgba8(const float* a_src, uint8_t* a_dst, size_t a_pixels)
+{
+    ForChunks(a_pixels, [&](size_t a_first, size_t a_count) { Rgba32FToRgba8Kernel(a_src + 4 * a_first, a_dst + 4 * a_first, a_count); });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// RGBA32F <-> RGBA16F
+//----------------------------------------------------------------------------------------------------------------------
+
+#ifdef PIXEL_FORMAT_F16C
+__attribute__((target("f16c")))
+static void Rgba32FToRgba16FF16C(const float* a_src, uint16_t* a_dst, size_t a_values)
+{
+    size_t i{};
+
+    for (; i + 4 <= a_values; i += 4)
+    {
+        const __m128i halves{ _mm_cvtps_ph(_mm_loadu_ps(a_src + i), _MM_FROUND_TO_NEAREST_INT) };
+        _mm_storel_epi64((__m128i*)(a_dst + i), halves);
+    }
+
+    for (; i < a_values; ++i)
+    {
+        a_dst[i] = half_float::FromFloat(a_src[i]);
+    }
+}
+
+__attribute__((target("f16c")))
+static void Rgba16FToRgba32FF16C(const uint16_t* a_src, float* a_dst, size_t a_values)
+{
+    size_t i{};
+
+    for (; i + 4 <= a_values; i += 4)
+    {
+        _mm_storeu_ps(a_dst + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(a_src + i))));
+    }
+
+    for (; i < a_values; ++i)
+    {
+        a_dst[i] = half_float::ToFloat(a_src[i]);
+    }
+}
+
+static bool HasF16C()
+{
+    static const bool f16c{ __builtin_cpu_supports("f16c") != 0 };
+    return f16c;
+}
+#endif
+
+static void Rgba32FToRgba16FKernel(const float* a_src, uint16_t* a_dst, size_t a_values)
+{
+#ifdef PIXEL_FORMAT_F16C
+    if (HasF16C())
+    {
+        Rgba32FToRgba16FF16C(a_src, a_dst, a_values);
+        return;
+    }
+#endif
+
+    for (size_t i{}; i < a_values; ++i)
+    {
+        a_dst[i] = half_float::FromFloat(a_src[i]);
+    }
+}
+
+static void Rgba16FToRgba32FKernel(const uint16_t* a_src, float* a_dst, size_t a_values)
+{
+#ifdef PIXEL_FORMAT_F16C
+    if (HasF16C())
+    {
+        Rgba16FToRgba32FF16C(a_src, a_dst, a_values);
+        return;
+    }
+#endif
+
+    for (size_t i{}; i < a_values; ++i)
+    {
+        a_dst[i] = half_float::ToFloat(a_src[i]);
+    }
+}
+
+void pixel_format::Rgba32FToRgba16F(const float* a_src, uint16_t* a_dst, size_t a_pixels)
+{
+    ForChunks(a_pixels, [&](size_t a_first, size_t a_count) { Rgba32FToRgba16FKernel(a_src + 4 * a_first, a_dst + 4 * a_first, 4 * a_count); });
+}
+
+void pixel_format::Rgba16FToRgba32F(const uint16_t* a_src, float* a_dst, size_t a_pixels)
+{
+    ForChunks(a_pixels, [&](size_t a_first, size_t a_count) { Rgba16FToRgba32FKernel(a_src + 4 * a_first, a_dst + 4 * a_first, 4 * a_count); });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// AoS <-> SoA
+//----------------------------------------------------------------------------------------------------------------------
+
+static void Rgba32FToPlanesKernel(const float* a_src, float* a_r, float* a_g, float* a_b, float* a_a, size_t a_pixels)
+{
+    size_t i{};
+
+#ifdef PIXEL_FORMAT_SSE2
+    // 4 pixels are a 4x4 matrix, its transpose is 4 values of every plane
+    for (; i + 4 <= a_pixels; i += 4)
+    {
+        __m128 p0{ _mm_loadu_ps(a_src + 4 * i) },     p1{ _mm_loadu_ps(a_src + 4 * i + 4) };
+        __m128 p2{ _mm_loadu_ps(a_src + 4 * i + 8) }, p3{ _mm_loadu_ps(a_src + 4 * i + 12) };
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+        _mm_storeu_ps(a_r + i, p0);
+        _mm_storeu_ps(a_g + i, p1);
+        _mm_storeu_ps(a_b + i, p2);
+        if (a_a != nullptr) _mm_storeu_ps(a_a + i, p3);
+    }
+#endif
+
+    for (; i < a_pixels; ++i)
+    {
+        a_r[i] = a_src[4 * i + 0];
+        a_g[i] = a_src[4 * i + 1];
+        a_b[i] = a_src[4 * i + 2];
+        if (a_a != nullptr) a_a[i] = a_src[4 * i + 3];
+    }
+}
+
+static void PlanesToRgba32FKernel(const float* a_r, const float* a_g, const float* a_b, const float* a_a, float* a_dst,
+        size_t a_pixels, float a_alpha)
+{
+    size_t i{};
+
+#ifdef PIXEL_FORMAT_SSE2
+    const __m128 alpha{ _mm_set1_ps(a_alpha) };
+
+    for (; i + 4 <= a_pixels; i += 4)
+    {
+        __m128 p0{ _mm_loadu_ps(a_r + i) }, p1{ _mm_loadu_ps(a_g + i) }, p2{ _mm_loadu_ps(a_b + i) };
+        __m128 p3{ (a_a != nullptr) ? _mm_loadu_ps(a_a + i) : alpha };
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+
+        _mm_storeu_ps(a_dst + 4 * i,      p0);
+        _mm_storeu_ps(a_dst + 4 * i + 4,  p1);
+        _mm_storeu_ps(a_dst + 4 * i + 8,  p2);
+        _mm_storeu_ps(a_dst + 4 * i + 12, p3);
+    }
+#endif
+
+    for (; i < a_pixels; ++i)
+    {
+        a_dst[4 * i + 0] = a_r[i];
+        a_dst[4 * i + 1] = a_g[i];
+        a_dst[4 * i + 2] = a_b[i];
+        a_dst[4 * i + 3] = (a_a != nullptr) ? a_a[i] : a_alpha;
+    }
+}
+
+void pixel_format::Rgba32FToPlanes(const float* a_src, float* a_r, float* a_g, float* a_b, float* a_a, size_t a_pixels)
+{
+    ForChunks(a_pixels, [&](size_t a_first, size_t a_count)
+    {
+        Rgba32FToPlanesKernel(a_src + 4 * a_first, a_r + a_first, a_g + a_first, a_b + a_first,
+                (a_a != nullptr) ? a_a + a_first : nullptr, a_count);
+    });
+}
+
+void pixel_format::PlanesToRgba32F(const float* a_r, const float* a_g, const float* a_b, const float* a_a, float* a_dst, size_t a_pixels,
+        float a_alpha)
+{
+    ForChunks(a_pixels, [&](size_t a_first, size_t a_count)
+    {
+        PlanesToRgba32FKernel(a_r + a_first, a_g + a_first, a_b + a_first, (a_a != nullptr) ? a_a + a_first : nullptr,
+                a_dst + 4 * a_first, a_count, a_alpha);
+    });
+}
+
+void pixel_format::Copy(const void* a_src, void* a_dst, size_t a_bytes)
+{
+    // in 16 byte "pixels", so the chunks follow the same threshold as the conversions
+    const size_t pixels{ a_bytes / 16 };
+
+    ForChunks(pixels, [&](size_t a_first, size_t a_count)
+    {
+        memcpy((uint8_t*)a_dst + 16 * a_first, (const uint8_t*)a_src + 16 * a_first, 16 * a_count);
+    });
+
+    memcpy((uint8_t*)a_dst + 16 * pixels, (const uint8_t*)a_src + 16 * pixels, a_bytes - 16 * pixels);
+}
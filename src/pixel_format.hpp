@@ -0,0 +1,36 @@
+#ifndef PIXEL_FORMAT_HPP
+#define PIXEL_FORMAT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <bit>
+
+// Host-side conversions between the pixel formats of the engine: RGBA8 (UNORM, also the packed uint32 images with
+// red in the low byte), RGBA16F (IEEE halves, FP16 mode) and RGBA32F (Pixel), interleaved (AoS) or as planes (SoA).
+// Kernels are SSE2 (F16C for halves when the CPU has it, picked at run time) with a scalar tail; frames above
+// PARALLEL_PIXELS are split between OpenMP threads. Conversions to RGBA8 round to nearest and saturate, NaN becomes 0.
+namespace pixel_format
+{
+    // packed uint32 images and RGBA8 bytes are the same memory
+    static_assert(std::endian::native == std::endian::little, "packed RGBA8 pixels assume a little-endian host");
+
+    constexpr size_t PARALLEL_PIXELS = size_t(1) << 18; // smaller frames are converted by the calling thread
+
+    // RGBA8 <-> RGBA32F, a_pixels pixels (4 channels each)
+    void Rgba8ToRgba32F(const uint8_t* a_src, float* a_dst, size_t a_pixels);
+    void Rgba32FToRgba8(const float* a_src, uint8_t* a_dst, size_t a_pixels);
+
+    // RGBA32F <-> RGBA16F, round to nearest even, values above the half range become infinity
+    void Rgba32FToRgba16F(const float* a_src, uint16_t* a_dst, size_t a_pixels);
+    void Rgba16FToRgba32F(const uint16_t* a_src, float* a_dst, size_t a_pixels);
+
+    // interleaved RGBA32F <-> planes; a_a may be nullptr (alpha is dropped, or set to a_alpha on the way back)
+    void Rgba32FToPlanes(const float* a_src, float* a_r, float* a_g, float* a_b, float* a_a, size_t a_pixels);
+    void PlanesToRgba32F(const float* a_r, const float* a_g, const float* a_b, const float* a_a, float* a_dst, size_t a_pixels,
+            float a_alpha = 1.0f);
+
+    // large copies (frame buffers, mapped memory) on several threads
+    void Copy(const void* a_src, void* a_dst, size_t a_bytes);
+}
+
+#endif // PIXEL_FORMAT_HPP
@@ -0,0 +1,404 @@
+#include "quality_metrics.hpp"
+#include "pixel_format.hpp"
+
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <iomanip>
+#include <algorithm>
+
+// Push constants of metrics.comp
+struct MetricsParams {
+    int width{}, height{};
+    int flags{};
+};
+
+enum MetricsFlags
+{
+    FLAG_REFERENCE = 1,
+    FLAG_HDR       = 2,
+};
+
+static constexpr int   SSIM_RADIUS = 3;           // RADIUS of metrics.comp
+static constexpr float SSIM_C1     = 0.01f * 0.01f;
+static constexpr float SSIM_C2     = 0.03f * 0.03f;
+
+// subgroupAdd/subgroupMax in compute shaders (Vulkan 1.1)
+static bool HasSubgroupArithmetic(VkPhysicalDevice a_physDevice)
+{
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(a_physDevice, &props);
+
+    if (props.apiVersion < VK_API_VERSION_1_1)
+    {
+        return false;
+    }
+
+    VkPhysicalDeviceSubgroupProperties subgroupProps{};
+    subgroupProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+    VkPhysicalDeviceProperties2 deviceProps{};
+    deviceProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    deviceProps.pNext = &subgroupProps;
+
+    vkGetPhysicalDeviceProperties2(a_physDevice, &deviceProps);
+
+    const VkSubgroupFeatureFlags needed{ VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT };
+    return (subgroupProps.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) && (subgroupProps.supportedOperations & needed) == needed;
+}
+
+// luminance of metrics.comp
+static float MetricsLuminance(const QualityMetrics::Pixel& a_color, bool a_isHDR)
+{
+    const float l{ 0.2126f * a_color.r + 0.7152f * a_color.g + 0.0722f * a_color.b };
+    return (a_isHDR) ? std::max(l, 0.0f) / (1.0f + std::max(l, 0.0f)) : l;
+}
+
+QualityMetrics::QualityMetrics(int a_deviceId)
+{
+    m_device    = ComputeApplication::CreateSharedDevice(a_deviceId, false);
+    m_subgroups = HasSubgroupArithmetic(m_device->physicalDevice);
+}
+
+QualityMetrics::~QualityMetrics()
+{
+    ReleaseResources();
+}
+
+QualityMetrics::Report QualityMetrics::MakeReport(double a_squaredError, double a_ssim, double a_noise, double a_peak, int a_w, int a_h,
+        bool a_hasReference)
+{
+    const double pixels{ double(a_w) * double(a_h) };
+
+    Report report{};
+    report.hasReference = a_hasReference;
+
+    if (a_hasReference)
+    {
+        const double peak{ std::max(1.0, a_peak) };
+
+        report.mse  = a_squaredError / (3.0 * pixels);
+        report.psnr = (report.mse > 0.0) ? 10.0 * std::log10(peak * peak / report.mse) : std::numeric_limits<double>::infinity();
+        report.ssim = a_ssim / pixels;
+    }
+
+    // sigma = sqrt(pi / 2) * sum |I * N| / (6 (W - 2) (H - 2))
+    const double interior{ double(std::max(a_w - 2, 0)) * double(std::max(a_h - 2, 0)) };
+    report.noise = (interior > 0.0) ? std::sqrt(0.5 * M_PI) * a_noise / (6.0 * interior) : 0.0;
+
+    return report;
+}
+
+QualityMetrics::Report QualityMetrics::Compute(const Pixel* a_image, const Pixel* a_reference, int a_w, int a_h, bool a_isHDR)
+{
+    if (a_w != m_w || a_h != m_h)
+    {
+        ReleaseResources();
+        CreateResources(a_w, a_h);
+    }
+
+    const VkDevice device{ m_device->device };
+    const size_t   bytes{ size_t(a_w) * a_h * sizeof(Pixel) };
+
+    void* mappedMemory{};
+    VK_CHECK_RESULT(vkMapMemory(device, m_bufferMemoryImage, 0, bytes, 0, &mappedMemory));
+    pixel_format::Copy(a_image, mappedMemory, bytes);
+    vkUnmapMemory(device, m_bufferMemoryImage);
+
+    if (a_reference != nullptr)
+    {
+        VK_CHECK_RESULT(vkMapMemory(device, m_bufferMemoryReference, 0, bytes, 0, &mappedMemory));
+        pixel_format::Copy(a_reference, mappedMemory, bytes);
+        vkUnmapMemory(device, m_bufferMemoryReference);
+    }
+
+    MetricsParams params{};
+    params.width  = a_w;
+    params.height = a_h;
+    params.flags  = ((a_reference != nullptr) ? FLAG_REFERENCE : 0) | ((a_isHDR) ? FLAG_HDR : 0);
+
+    const VkCommandBuffer cmdBuff{ m_commandBuffer };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(cmdBuff, m_queryPool, 0, 3);
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 0);
+#endif
+
+    vkCmdBindPipeline      (cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipeline);
+    vkCmdBindDescriptorSets(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, m_pipelineLayout, 0, 1, &m_descriptorSet, 0, NULL);
+    vkCmdPushConstants     (cmdBuff, m_pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(MetricsParams), &params);
+    vkCmdDispatch          (cmdBuff, m_groupsX, m_groupsY, 1);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, m_queryPool, 1);
+#endif
+
+    // partials are read by the host straight from the buffer
+    VkMemoryBarrier memBarr{};
+    memBarr.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+            1, &memBarr, 0, nullptr, 0, nullptr);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuff));
+
+    m_execTimeElapsed = m_transferTimeElapsed = 0;
+    {
+        QueueScheduler::Turn turn{ m_device->scheduler, QueueScheduler::PRIORITY_BATCH };
+        ComputeApplication::RunCommandBuffer(cmdBuff, m_device->queue, device, m_queryPool, m_execTimeElapsed, m_transferTimeElapsed);
+    }
+
+    const size_t groups{ size_t(m_groupsX) * m_groupsY };
+    float*       partials{};
+    VK_CHECK_RESULT(vkMapMemory(device, m_bufferMemoryPartials, 0, groups * 4 * sizeof(float), 0, (void**)&partials));
+
+    double squaredError{}, ssim{}, noise{}, peak{};
+    for (size_t i{}; i < groups; ++i)
+    {
+        squaredError += partials[4 * i + 0];
+        ssim         += partials[4 * i + 1];
+        noise        += partials[4 * i + 2];
+        peak          = std::max(peak, double(partials[4 * i + 3]));
+    }
+
+    vkUnmapMemory(device, m_bufferMemoryPartials);
+
+    return MakeReport(squaredError, ssim, noise, peak, a_w, a_h, a_reference != nullptr);
+}
+
+QualityMetrics::Report QualityMetrics::ComputeCPU(const Pixel* a_image, const Pixel* a_reference, int a_w, int a_h, bool a_isHDR,
+        int a_numThreads)
+{
+    const size_t pixels{ size_t(a_w) * a_h };
+    const int    threads{ (a_numThreads > 0) ? a_numThreads : int(std::max(1u, std::thread::hardware_concurrency())) };
+    const bool   withRef{ a_reference != nullptr };
+
+    std::vector<float> lumaX(pixels), lumaY((withRef) ? pixels : 0);
+
+#pragma omp parallel for num_threads(threads)
+    for (int y = 0; y < a_h; ++y)
+    {
+        for (int x{}; x < a_w; ++x)
+        {
+            const size_t i{ size_t(y) * a_w + x };
+            lumaX[i] = MetricsLuminance(a_image[i], a_isHDR);
+            if (withRef) lumaY[i] = MetricsLuminance(a_reference[i], a_isHDR);
+        }
+    }
+
+    // window sums of x, y, xx, yy, xy: clamped box filters are separable, rows first
+    constexpr int MOMENTS{5};
+    std::vector<float> rowSums((withRef) ? MOMENTS * pixels : 0);
+
+    if (withRef)
+    {
+#pragma omp parallel for num_threads(threads)
+        for (int y = 0; y < a_h; ++y)
+        {
+            for (int x{}; x < a_w; ++x)
+            {
+                float sums[MOMENTS]{};
+                for (int i{ -SSIM_RADIUS }; i <= SSIM_RADIUS; ++i)
+                {
+                    const size_t j{ size_t(y) * a_w + std::clamp(x + i, 0, a_w - 1) };
+                    sums[0] += lumaX[j];
+                    sums[1] += lumaY[j];
+                    sums[2] += lumaX[j] * lumaX[j];
+                    sums[3] += lumaY[j] * lumaY[j];
+                    sums[4] += lumaX[j] * lumaY[j];
+                }
+
+                for (int m{}; m < MOMENTS; ++m) rowSums[m * pixels + size_t(y) * a_w + x] = sums[m];
+            }
+        }
+    }
+
+    double squaredError{}, ssim{}, noise{}, peak{};
+
+#pragma omp parallel for num_threads(threads) reduction(+ : squaredError, ssim, noise) reduction(max : peak)
+    for (int y = 0; y < a_h; ++y)
+    {
+        for (int x{}; x < a_w; ++x)
+        {
+            const size_t i{ size_t(y) * a_w + x };
+
+            if (withRef)
+            {
+                const float dr{ a_image[i].r - a_reference[i].r }, dg{ a_image[i].g - a_reference[i].g }, db{ a_image[i].b - a_reference[i].b };
+                squaredError += dr * dr + dg * dg + db * db;
+                peak          = std::max(peak, double(std::max({ a_reference[i].r, a_reference[i].g, a_reference[i].b })));
+
+                float sums[MOMENTS]{};
+                for (int j{ -SSIM_RADIUS }; j <= SSIM_RADIUS; ++j)
+                {
+                    const size_t row{ size_t(std::clamp(y + j, 0, a_h - 1)) * a_w + x };
+                    for (int m{}; m < MOMENTS; ++m) sums[m] += rowSums[m * pixels + row];
+                }
+
+                const float n{ float((2 * SSIM_RADIUS + 1) * (2 * SSIM_RADIUS + 1)) };
+                const float meanX{ sums[0] / n }, meanY{ sums[1] / n };
+                const float varX{ sums[2] / n - meanX * meanX };
+                const float varY{ sums[3] / n - meanY * meanY };
+                const float cov { sums[4] / n - meanX * meanY };
+
+                ssim += ((2.0f * meanX * meanY + SSIM_C1) * (2.0f * cov + SSIM_C2))
+                    / ((meanX * meanX + meanY * meanY + SSIM_C1) * (varX + varY + SSIM_C2));
+            }
+
+            if (x > 0 && y > 0 && x < a_w - 1 && y < a_h - 1)
+            {
+                const float* up  { &lumaX[i - a_w] };
+                const float* mid { &lumaX[i] };
+                const float* down{ &lumaX[i + a_w] };
+
+                const float corners{ up[-1] + up[1] + down[-1] + down[1] };
+                const float sides  { mid[-1] + mid[1] + up[0] + down[0] };
+                noise += std::abs(4.0f * mid[0] - 2.0f * sides + corners);
+            }
+        }
+    }
+
+    return MakeReport(squaredError, ssim, noise, peak, a_w, a_h, withRef);
+}
+
+void QualityMetrics::Print(std::ostream& a_out, const Report& a_report)
+{
+    if (a_report.hasReference)
+    {
+        a_out << "PSNR " << std::fixed << std::setprecision(2) << a_report.psnr << " dB, SSIM " << std::setprecision(4) << a_report.ssim << ", ";
+    }
+
+    a_out << "noise " << std::fixed << std::setprecision(4) << a_report.noise << std::defaultfloat;
+}
+
+void QualityMetrics::CreateResources(int a_w, int a_h)
+{
+    const VkDevice         device{ m_device->device };
+    const VkPhysicalDevice physDevice{ m_device->physicalDevice };
+    const size_t           bytes{ size_t(a_w) * a_h * sizeof(Pixel) };
+    const ComputeApplication::WorkgroupSize workgroupSize{};
+
+    m_w       = a_w;
+    m_h       = a_h;
+    m_groupsX = uint32_t((a_w + workgroupSize.x - 1) / workgroupSize.x);
+    m_groupsY = uint32_t((a_h + workgroupSize.y - 1) / workgroupSize.y);
+
+    const size_t partialsBytes{ size_t(m_groupsX) * m_groupsY * 4 * sizeof(float) };
+
+    // every pixel is read about once (the apron is shared by the workgroup), no device copy is made
+    ComputeApplication::CreateStagingBuffer(device, physDevice, bytes, &m_bufferImage, &m_bufferMemoryImage);
+    ComputeApplication::CreateStagingBuffer(device, physDevice, bytes, &m_bufferReference, &m_bufferMemoryReference);
+    ComputeApplication::CreateStagingBuffer(device, physDevice, partialsBytes, &m_bufferPartials, &m_bufferMemoryPartials);
+
+    // binding 0 - image, 1 - reference, 2 - partials
+    VkDescriptorSetLayoutBinding descriptorSetLayoutBindings[3]{};
+    for (uint32_t i{}; i < 3; ++i)
+    {
+        descriptorSetLayoutBindings[i].binding         = i;
+        descriptorSetLayoutBindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorSetLayoutBindings[i].descriptorCount = 1;
+        descriptorSetLayoutBindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+    descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.bindingCount = 3;
+    descriptorSetLayoutCreateInfo.pBindings    = descriptorSetLayoutBindings;
+
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo, NULL, &m_descriptorSetLayout));
+
+    VkDescriptorPoolSize descriptorPoolSize{};
+    descriptorPoolSize.type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize.descriptorCount = 3;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets       = 1;
+    descriptorPoolCreateInfo.poolSizeCount = 1;
+    descriptorPoolCreateInfo.pPoolSizes    = &descriptorPoolSize;
+
+    VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, NULL, &m_descriptorPool));
+
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+    descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    descriptorSetAllocateInfo.descriptorPool     = m_descriptorPool;
+    descriptorSetAllocateInfo.descriptorSetCount = 1;
+    descriptorSetAllocateInfo.pSetLayouts        = &m_descriptorSetLayout;
+
+    VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &m_descriptorSet));
+
+    const VkBuffer buffers[3]{ m_bufferImage, m_bufferReference, m_bufferPartials };
+    const size_t   sizes[3]  { bytes, bytes, partialsBytes };
+
+    VkDescriptorBufferInfo descriptorBufferInfos[3]{};
+    VkWriteDescriptorSet   writeDescriptorSets[3]{};
+
+    for (uint32_t i{}; i < 3; ++i)
+    {
+        descriptorBufferInfos[i].buffer = buffers[i];
+        descriptorBufferInfos[i].offset = 0;
+        descriptorBufferInfos[i].range  = sizes[i];
+
+        writeDescriptorSets[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writeDescriptorSets[i].dstSet          = m_descriptorSet;
+        writeDescriptorSets[i].dstBinding      = i;
+        writeDescriptorSets[i].descriptorCount = 1;
+        writeDescriptorSets[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writeDescriptorSets[i].pBufferInfo     = &descriptorBufferInfos[i];
+    }
+
+    vkUpdateDescriptorSets(device, 3, writeDescriptorSets, 0, NULL);
+
+    ComputeApplication::CreateComputePipelines(device, m_descriptorSetLayout, &m_shaderModule, &m_pipeline, &m_pipelineLayout,
+            (m_subgroups) ? "shaders/metrics_subgroup.spv" : "shaders/metrics.spv", sizeof(MetricsParams), workgroupSize);
+
+    ComputeApplication::CreateCommandBuffer(device, m_device->queueFamilyIndex, m_pipeline, m_pipelineLayout,
+            &m_commandPool, &m_commandBuffer);
+    ComputeApplication::CreateQueryPool(device, &m_queryPool);
+}
+
+void QualityMetrics::ReleaseResources()
+{
+    const VkDevice device{ (m_device) ? m_device->device : VK_NULL_HANDLE };
+
+    if (device == VK_NULL_HANDLE || m_bufferImage == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VkBuffer       buffers[3] { m_bufferImage, m_bufferReference, m_bufferPartials };
+    VkDeviceMemory memories[3]{ m_bufferMemoryImage, m_bufferMemoryReference, m_bufferMemoryPartials };
+
+    for (int i{}; i < 3; ++i)
+    {
+        vkFreeMemory   (device, memories[i], NULL);
+        vkDestroyBuffer(device, buffers[i], NULL);
+    }
+
+    vkDestroyQueryPool(device, m_queryPool, NULL);
+    vkFreeCommandBuffers(device, m_commandPool, 1, &m_commandBuffer);
+    vkDestroyCommandPool(device, m_commandPool, NULL);
+
+    vkDestroyPipeline      (device, m_pipeline, NULL);
+    vkDestroyPipelineLayout(device, m_pipelineLayout, NULL);
+    vkDestroyShaderModule  (device, m_shaderModule, NULL);
+
+    vkDestroyDescriptorPool     (device, m_descriptorPool, NULL);
+    vkDestroyDescriptorSetLayout(device, m_descriptorSetLayout, NULL);
+
+    m_bufferImage = m_bufferReference = m_bufferPartials = VK_NULL_HANDLE;
+    m_bufferMemoryImage = m_bufferMemoryReference = m_bufferMemoryPartials = VK_NULL_HANDLE;
+    m_w = m_h = 0;
+}
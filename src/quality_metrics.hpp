@@ -0,0 +1,81 @@
+#ifndef QUALITY_METRICS_HPP
+#define QUALITY_METRICS_HPP
+
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "compute_application.hpp"
+
+// Output quality of a run, so that fast modes can be checked against a quality floor (`--reference`, bench columns).
+// With a reference image: PSNR over r, g, b (peak 1, or the brightest reference channel of an HDR image) and mean SSIM
+// of 7x7 box windows on luminance. Always: a no-reference noise estimate, the standard deviation of Gaussian noise
+// in luminance by the mask of Immerkaer ("Fast noise variance estimation", 1996), which ignores smooth gradients.
+// HDR luminance goes through l / (1 + l) for SSIM and noise, so that both stay in [0, 1] like LDR.
+//
+// metrics.comp does it on the GPU, one partial sum per workgroup (subgroup reductions where the device has them,
+// shared memory otherwise), the host adds the partials in double. ComputeCPU gives the same numbers with OpenMP.
+class QualityMetrics
+{
+    public:
+
+        using Pixel = ComputeApplication::Pixel;
+
+        struct Report {
+            bool   hasReference{};
+            double mse{};    // per channel
+            double psnr{};   // dB, infinity for identical images
+            double ssim{};
+            double noise{};  // standard deviation, luminance units
+        };
+
+        explicit QualityMetrics(int a_deviceId = 0);
+        ~QualityMetrics();
+
+        QualityMetrics(const QualityMetrics&) = delete;
+        QualityMetrics& operator=(const QualityMetrics&) = delete;
+
+        // a_reference may be nullptr (noise only)
+        Report Compute(const Pixel* a_image, const Pixel* a_reference, int a_w, int a_h, bool a_isHDR);
+
+        // the same on the host, a_numThreads 0 - all
+        static Report ComputeCPU(const Pixel* a_image, const Pixel* a_reference, int a_w, int a_h, bool a_isHDR, int a_numThreads = 0);
+
+        // "PSNR 34.2 dB, SSIM 0.9412, noise 0.0031" (PSNR and SSIM only with a reference)
+        static void Print(std::ostream& a_out, const Report& a_report);
+
+        std::string GetDeviceName()      const { return m_device->deviceName; }
+        bool        GetSubgroups()       const { return m_subgroups; }
+        uint64_t    GetExecTimeElapsed() const { return uint64_t(double(m_execTimeElapsed) * m_device->timestampPeriod); }
+
+    private:
+
+        // sums of metrics.comp partials (or of the host loop) -> report
+        static Report MakeReport(double a_squaredError, double a_ssim, double a_noise, double a_peak, int a_w, int a_h, bool a_hasReference);
+
+        void CreateResources(int a_w, int a_h);
+        void ReleaseResources();
+
+        std::shared_ptr<ComputeApplication::SharedDevice> m_device{};
+        bool m_subgroups{}; // metrics_subgroup.spv
+
+        int      m_w{}, m_h{};
+        uint32_t m_groupsX{}, m_groupsY{};
+
+        VkBuffer              m_bufferImage{}, m_bufferReference{}, m_bufferPartials{}; // host visible, read by the shader in place
+        VkDeviceMemory        m_bufferMemoryImage{}, m_bufferMemoryReference{}, m_bufferMemoryPartials{};
+        VkDescriptorSetLayout m_descriptorSetLayout{};
+        VkDescriptorPool      m_descriptorPool{};
+        VkDescriptorSet       m_descriptorSet{};
+        VkShaderModule        m_shaderModule{};
+        VkPipeline            m_pipeline{};
+        VkPipelineLayout      m_pipelineLayout{};
+        VkCommandPool         m_commandPool{};
+        VkCommandBuffer       m_commandBuffer{};
+        VkQueryPool           m_queryPool{};
+
+        uint64_t m_execTimeElapsed{};
+        uint64_t m_transferTimeElapsed{};
+};
+
+#endif // QUALITY_METRICS_HPP
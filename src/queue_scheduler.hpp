@@ -0,0 +1,85 @@
+#ifndef QUEUE_SCHEDULER_HPP
+#define QUEUE_SCHEDULER_HPP
+
+#include <mutex>
+#include <cstdint>
+#include <condition_variable>
+
+// Order in which the jobs sharing one VkQueue submit their command buffers.
+// Jobs submit and wait one command buffer at a time, so a waiting interactive job gets the queue as soon as
+// the current command buffer (one dispatch or copy) is done instead of after the whole batch job.
+// Inside a class the order is FIFO; a batch submission still goes after BATCH_STARVATION interactive ones in a row.
+class QueueScheduler
+{
+    public:
+
+        enum Priority : uint32_t
+        {
+            PRIORITY_INTERACTIVE = 0, // previews, latency matters
+            PRIORITY_BATCH       = 1, // farm frames, throughput matters
+            PRIORITY_COUNT
+        };
+
+        static constexpr int BATCH_STARVATION = 16;
+
+        // Holds the queue for the lifetime of the object
+        class Turn
+        {
+            public:
+
+                Turn(QueueScheduler& a_scheduler, Priority a_priority) : m_scheduler(a_scheduler) { m_scheduler.Acquire(a_priority); }
+                ~Turn() { m_scheduler.Release(); }
+
+                Turn(const Turn&) = delete;
+                Turn& operator=(const Turn&) = delete;
+
+            private:
+
+                QueueScheduler& m_scheduler;
+        };
+
+        void Acquire(Priority a_priority)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            const uint64_t ticket{ m_nextTicket[a_priority]++ };
+            m_changed.wait(lock, [&]{ return !m_busy && m_serving[a_priority] == ticket && !Preempted(a_priority); });
+
+            m_busy = true;
+            ++m_serving[a_priority];
+            m_interactiveStreak = (a_priority == PRIORITY_INTERACTIVE) ? m_interactiveStreak + 1 : 0;
+        }
+
+        void Release()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_busy = false;
+            }
+            m_changed.notify_all();
+        }
+
+    private:
+
+        bool Waiting(Priority a_priority) const { return m_nextTicket[a_priority] != m_serving[a_priority]; }
+
+        // a more urgent submission waits (and the batch class has not been starving for too long)
+        bool Preempted(Priority a_priority) const
+        {
+            if (a_priority == PRIORITY_BATCH)
+            {
+                return Waiting(PRIORITY_INTERACTIVE) && m_interactiveStreak < BATCH_STARVATION;
+            }
+
+            return Waiting(PRIORITY_BATCH) && m_interactiveStreak >= BATCH_STARVATION;
+        }
+
+        std::mutex              m_mutex{};
+        std::condition_variable m_changed{};
+        bool                    m_busy{};
+        uint64_t                m_nextTicket[PRIORITY_COUNT]{};
+        uint64_t                m_serving[PRIORITY_COUNT]{};
+        int                     m_interactiveStreak{};
+};
+
+#endif // QUEUE_SCHEDULER_HPP
@@ -0,0 +1,158 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+
+#include "shm_ring.hpp"
+#include "synthetic.hpp"
+
+// Stand-in for a renderer: writes noisy synthetic frames into a shared-memory ring, `vulkan_denoice --shm <name>`
+// denoises them in place, the producer checks the results against the clean image.
+
+struct ProducerOptions
+{
+    std::string name{"/vulkan_denoice"};
+    int         w{512}, h{512};
+    int         frames{8};
+    int         slots{2};
+    float       noise{0.05f};
+    int         timeoutMs{60000};
+    bool        ldr{};
+};
+
+static void PrintUsage(const char* a_exeName)
+{
+    std::cout << "usage: " << a_exeName << " [options]\n"
+        << "\t--name /name      shared-memory object (default /vulkan_denoice)\n"
+        << "\t--size WxH        frame resolution (default 512x512)\n"
+        << "\t--frames N        frames to send (default 8)\n"
+        << "\t--slots N         frames in flight (default 2)\n"
+        << "\t--noise sigma     gaussian noise of the frames (default 0.05)\n"
+        << "\t--timeout ms      give up waiting for the denoiser (default 60000)\n"
+        << "\t--ldr             RGBA8 frames instead of RGBA32F\n"
+        << "start `vulkan_denoice --shm <name>` after the producer\n";
+}
+
+static bool ParseOptions(int argc, char** argv, ProducerOptions& a_opts)
+{
+    for (int i{1}; i < argc; ++i)
+    {
+        const std::string arg{argv[i]};
+        const bool hasValue{ i + 1 < argc };
+
+        if (arg == "--name" && hasValue)         a_opts.name      = argv[++i];
+        else if (arg == "--size" && hasValue)
+        {
+            if (sscanf(argv[++i], "%dx%d", &a_opts.w, &a_opts.h) != 2 || a_opts.w <= 0 || a_opts.h <= 0) return false;
+        }
+        else if (arg == "--frames" && hasValue)  a_opts.frames    = std::max(1, atoi(argv[++i]));
+        else if (arg == "--slots" && hasValue)   a_opts.slots     = std::clamp(atoi(argv[++i]), 1, int(ShmRing::MAX_SLOTS));
+        else if (arg == "--noise" && hasValue)   a_opts.noise     = float(atof(argv[++i]));
+        else if (arg == "--timeout" && hasValue) a_opts.timeoutMs = std::max(1, atoi(argv[++i]));
+        else if (arg == "--ldr")                 a_opts.ldr       = true;
+        else return false;
+    }
+
+    return true;
+}
+
+static double Rmse(const ComputeApplication::Pixel* a_image, const std::vector<ComputeApplication::Pixel>& a_reference)
+{
+    double sum{};
+    for (size_t i{}; i < a_reference.size(); ++i)
+    {
+        sum += (a_image[i].r - a_reference[i].r) * (a_image[i].r - a_reference[i].r)
+             + (a_image[i].g - a_reference[i].g) * (a_image[i].g - a_reference[i].g)
+             + (a_image[i].b - a_reference[i].b) * (a_image[i].b - a_reference[i].b);
+    }
+
+    return std::sqrt(sum / (3.0 * double(a_reference.size())));
+}
+
+int main(int argc, char** argv)
+{
+    ProducerOptions opts{};
+    if (!ParseOptions(argc, argv, opts))
+    {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    using Clock = std::chrono::steady_clock;
+
+    try
+    {
+        ShmRing ring{ ShmRing::Create(opts.name, uint32_t(opts.w), uint32_t(opts.h),
+                (opts.ldr) ? ShmRing::FORMAT_RGBA8 : ShmRing::FORMAT_RGBA32F, uint32_t(opts.slots)) };
+        ShmRing::Header* header{ ring.GetHeader() };
+
+        const std::vector<ComputeApplication::Pixel> clean{ synthetic::MakeCleanImage(opts.w, opts.h) };
+        std::vector<Clock::time_point> submitted(ShmRing::MAX_SLOTS);
+
+        std::cout << "ring " << opts.name << " is ready, waiting for `vulkan_denoice --shm " << opts.name << "`\n";
+
+        int sent{}, received{};
+
+        // takes one result back, false on timeout
+        auto receive = [&](int a_timeoutMs)
+        {
+            const int slot{ ring.Acquire(ShmRing::SLOT_DONE, ShmRing::SLOT_BUSY, a_timeoutMs) };
+            if (slot < 0) return false;
+
+            const double latencyMs{ std::chrono::duration<double, std::milli>(Clock::now() - submitted[slot]).count() };
+            std::cout << "frame " << header->frameId[slot] << ": " << latencyMs << " ms, rmse "
+                << Rmse((const ComputeApplication::Pixel*)ring.GetOutput(slot), clean) << "\n";
+
+            ring.Release(uint32_t(slot), ShmRing::SLOT_FREE);
+            ++received;
+            return true;
+        };
+
+        while (sent < opts.frames)
+        {
+            int slot{ ring.Acquire(ShmRing::SLOT_FREE, ShmRing::SLOT_BUSY, 0) };
+            if (slot < 0)
+            {
+                if (!receive(opts.timeoutMs)) RUN_TIME_ERROR("timeout waiting for the denoiser");
+                continue;
+            }
+
+            const ComputeApplication::SourceFrames frame{ synthetic::MakeSourceFrames(opts.w, opts.h, 1, opts.noise, unsigned(sent + 1), opts.ldr) };
+            if (opts.ldr)
+            {
+                memcpy(ring.GetInput(slot), frame.imageData[0].data(), ring.InputSize());
+            }
+            else
+            {
+                memcpy(ring.GetInput(slot), frame.imageDataHDR[0].data(), ring.InputSize());
+            }
+
+            header->frameId[slot] = uint64_t(sent);
+            submitted[slot]       = Clock::now();
+            ring.Release(uint32_t(slot), ShmRing::SLOT_READY);
+
+            if (sent == 0 && !opts.ldr)
+            {
+                std::cout << "input rmse " << Rmse(frame.imageDataHDR[0].data(), clean) << "\n";
+            }
+            ++sent;
+        }
+
+        while (received < sent)
+        {
+            if (!receive(opts.timeoutMs)) RUN_TIME_ERROR("timeout waiting for the denoiser");
+        }
+
+        header->closed.store(1);
+    }
+    catch (const std::runtime_error& e)
+    {
+        printf("%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,189 @@
+#include "shm_ring.hpp"
+#include "vk_utils.h"
+
+#include <new>
+#include <thread>
+#include <chrono>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// mmap only guarantees page alignment, slots have to start at SLOT_ALIGNMENT to be importable
+static uint8_t* MapAligned(int a_fd, size_t a_size)
+{
+    const size_t reserved{ a_size + ShmRing::SLOT_ALIGNMENT };
+
+    void* area = mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (area == MAP_FAILED) RUN_TIME_ERROR("ShmRing: can't reserve address space");
+
+    uint8_t* begin{ (uint8_t*)area };
+    uint8_t* aligned{ (uint8_t*)ShmRing::AlignUp(size_t(begin)) };
+
+    if (mmap(aligned, a_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, a_fd, 0) == MAP_FAILED)
+    {
+        munmap(area, reserved);
+        RUN_TIME_ERROR("ShmRing: can't map shared memory");
+    }
+
+    // give back the unused ends of the reservation
+    if (aligned > begin) munmap(begin, aligned - begin);
+    if (begin + reserved > aligned + a_size) munmap(aligned + a_size, begin + reserved - (aligned + a_size));
+
+    return aligned;
+}
+
+static size_t SlotSize(uint32_t a_w, uint32_t a_h, uint32_t a_bytesPerPixel)
+{
+    return ShmRing::AlignUp(size_t(a_w) * a_h * a_bytesPerPixel);
+}
+
+ShmRing::ShmRing(const std::string& a_name, uint8_t* a_base, size_t a_size, bool a_owner)
+    : m_name(a_name), m_base(a_base), m_header((Header*)a_base), m_size(a_size), m_owner(a_owner)
+{
+}
+
+ShmRing::ShmRing(ShmRing&& a_other) noexcept
+    : m_name(std::move(a_other.m_name)), m_base(a_other.m_base), m_header(a_other.m_header), m_size(a_other.m_size), m_owner(a_other.m_owner)
+{
+    a_other.m_base   = nullptr;
+    a_other.m_header = nullptr;
+    a_other.m_owner  = false;
+}
+
+ShmRing::~ShmRing()
+{
+    if (m_base != nullptr)
+    {
+        munmap(m_base, m_size);
+    }
+
+    if (m_owner)
+    {
+        shm_unlink(m_name.c_str());
+    }
+}
+
+ShmRing ShmRing::Create(const std::string& a_name, uint32_t a_w, uint32_t a_h, Format a_format, uint32_t a_slots)
+{
+    if (a_slots == 0 || a_slots > MAX_SLOTS) RUN_TIME_ERROR("ShmRing::Create, wrong number of slots");
+
+    const size_t inputStride{ SlotSize(a_w, a_h, (a_format == FORMAT_RGBA8) ? 4 : 16) };
+    const size_t outputStride{ SlotSize(a_w, a_h, 16) };
+    const size_t size{ HeaderSize() + a_slots * (inputStride + outputStride) };
+
+    shm_unlink(a_name.c_str());
+    const int fd{ shm_open(a_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) };
+    if (fd < 0) RUN_TIME_ERROR(("ShmRing::Create, can't create " + a_name).c_str());
+
+    if (ftruncate(fd, off_t(size)) != 0)
+    {
+        close(fd);
+        shm_unlink(a_name.c_str());
+        RUN_TIME_ERROR("ShmRing::Create, can't resize shared memory");
+    }
+
+    uint8_t* base{ MapAligned(fd, size) };
+    close(fd);
+
+    Header* header{ new (base) Header{} };
+    header->slots        = a_slots;
+    header->width        = a_w;
+    header->height       = a_h;
+    header->format       = a_format;
+    header->inputStride  = inputStride;
+    header->outputStride = outputStride;
+    header->closed.store(0);
+
+    for (uint32_t i{}; i < MAX_SLOTS; ++i)
+    {
+        header->state[i].store(SLOT_FREE);
+        header->frameId[i] = 0;
+    }
+
+    // magic goes last, the denoiser may already poll for it
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = MAGIC;
+
+    return ShmRing(a_name, base, size, true);
+}
+
+ShmRing ShmRing::Open(const std::string& a_name)
+{
+    const int fd{ shm_open(a_name.c_str(), O_RDWR, 0) };
+    if (fd < 0) RUN_TIME_ERROR(("ShmRing::Open, can't open " + a_name).c_str());
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size < off_t(HeaderSize()))
+    {
+        close(fd);
+        RUN_TIME_ERROR(("ShmRing::Open, " + a_name + " is not a frame ring").c_str());
+    }
+
+    uint8_t* base{ MapAligned(fd, size_t(st.st_size)) };
+    close(fd);
+
+    ShmRing ring(a_name, base, size_t(st.st_size), false);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    // the header comes from another process (a client of the daemon names the ring): the magic is checked before
+    // any other field, then everything GetInput/GetOutput/Acquire index with has to fit the mapping
+    const Header& header{ *ring.m_header };
+    const size_t  size{ ring.m_size };
+
+    if (header.magic != MAGIC) RUN_TIME_ERROR(("ShmRing::Open, " + a_name + " is not a frame ring").c_str());
+
+    const bool valid{ header.slots >= 1 && header.slots <= MAX_SLOTS
+        && (header.format == FORMAT_RGBA8 || header.format == FORMAT_RGBA32F)
+        && header.width > 0 && header.height > 0 && size_t(header.width) * header.height <= size
+        && header.inputStride <= size && header.outputStride <= size
+        && header.inputStride >= ring.InputSize() && header.outputStride >= ring.OutputSize()
+        && HeaderSize() + header.slots * (header.inputStride + header.outputStride) <= size };
+
+    if (!valid) RUN_TIME_ERROR(("ShmRing::Open, " + a_name + " has a broken header").c_str());
+
+    return ring;
+}
+
+size_t ShmRing::InputSize() const
+{
+    return size_t(m_header->width) * m_header->height * ((m_header->format == FORMAT_RGBA8) ? 4 : 16);
+}
+
+size_t ShmRing::OutputSize() const
+{
+    return size_t(m_header->width) * m_header->height * 16;
+}
+
+int ShmRing::Acquire(SlotState a_from, SlotState a_to, int a_timeoutMs)
+{
+    const auto deadline{ std::chrono::steady_clock::now() + std::chrono::milliseconds(a_timeoutMs) };
+
+    while (true)
+    {
+        // read before the scan: frames marked READY before closing are then seen by this scan
+        const bool closed{ m_header->closed.load(std::memory_order_acquire) != 0 };
+
+        for (uint32_t i{}; i < m_header->slots; ++i)
+        {
+            uint32_t expected{ a_from };
+            if (m_header->state[i].compare_exchange_strong(expected, a_to, std::memory_order_acq_rel))
+            {
+                return int(i);
+            }
+        }
+
+        if ((a_from == SLOT_READY && closed) || std::chrono::steady_clock::now() > deadline)
+        {
+            return -1;
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void ShmRing::Release(uint32_t a_slot, SlotState a_state)
+{
+    m_header->state[a_slot].store(a_state, std::memory_order_release);
+}
@@ -0,0 +1,84 @@
+#ifndef SHM_RING_HPP
+#define SHM_RING_HPP
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Ring of frames in POSIX shared memory between a renderer (producer) and the denoiser.
+// The producer writes raw frames into input slots, the denoiser imports the slot pages into Vulkan
+// (VK_EXT_external_memory_host) and writes the result straight into the output slot of the same index.
+//
+// layout: [Header][input slot 0 .. n-1][output slot 0 .. n-1], every slot starts at a multiple of SLOT_ALIGNMENT
+class ShmRing
+{
+    public:
+
+        enum Format : uint32_t
+        {
+            FORMAT_RGBA8   = 0,
+            FORMAT_RGBA32F = 1,
+        };
+
+        // FREE -(producer)-> READY -(denoiser)-> BUSY -> DONE -(producer took the result)-> FREE
+        enum SlotState : uint32_t
+        {
+            SLOT_FREE  = 0,
+            SLOT_READY = 1,
+            SLOT_BUSY  = 2,
+            SLOT_DONE  = 3,
+        };
+
+        static constexpr uint32_t MAGIC          = 0x4e534456; // "VDSN"
+        static constexpr uint32_t MAX_SLOTS      = 16;
+        static constexpr size_t   SLOT_ALIGNMENT = 64 * 1024;  // covers minImportedHostPointerAlignment of known drivers
+
+        struct Header
+        {
+            uint32_t              magic;
+            uint32_t              slots;
+            uint32_t              width, height;
+            uint32_t              format;       // of input slots, output slots are always RGBA32F
+            std::atomic<uint32_t> closed;       // producer will not write new frames
+            uint64_t              inputStride;  // bytes between input slots (padded to SLOT_ALIGNMENT)
+            uint64_t              outputStride;
+            std::atomic<uint32_t> state[MAX_SLOTS];
+            uint64_t              frameId[MAX_SLOTS];
+        };
+
+        // producer side: creates (or replaces) /dev/shm/<a_name> and unlinks it when destroyed
+        static ShmRing Create(const std::string& a_name, uint32_t a_w, uint32_t a_h, Format a_format, uint32_t a_slots);
+        // denoiser side
+        static ShmRing Open(const std::string& a_name);
+
+        ShmRing(ShmRing&& a_other) noexcept;
+        ShmRing(const ShmRing&) = delete;
+        ShmRing& operator=(const ShmRing&) = delete;
+        ~ShmRing();
+
+        Header* GetHeader()                { return m_header; }
+        void*   GetInput(uint32_t a_slot)  { return m_base + HeaderSize() + a_slot * m_header->inputStride; }
+        void*   GetOutput(uint32_t a_slot) { return m_base + HeaderSize() + m_header->slots * m_header->inputStride + a_slot * m_header->outputStride; }
+        size_t  InputSize() const;
+        size_t  OutputSize() const;
+
+        // index of a slot that moved from a_from to a_to, -1 on timeout (or when the ring is closed and a_from is READY)
+        int Acquire(SlotState a_from, SlotState a_to, int a_timeoutMs);
+        void Release(uint32_t a_slot, SlotState a_state);
+
+        static size_t HeaderSize() { return AlignUp(sizeof(Header)); }
+        static size_t AlignUp(size_t a_size) { return (a_size + SLOT_ALIGNMENT - 1) / SLOT_ALIGNMENT * SLOT_ALIGNMENT; }
+
+    private:
+
+        ShmRing(const std::string& a_name, uint8_t* a_base, size_t a_size, bool a_owner);
+
+        std::string m_name{};
+        uint8_t*    m_base{};
+        Header*     m_header{};
+        size_t      m_size{};
+        bool        m_owner{};
+};
+
+#endif // SHM_RING_HPP
@@ -0,0 +1,137 @@
+#ifndef SYNTHETIC_HPP
+#define SYNTHETIC_HPP
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+#include "compute_application.hpp"
+#include "pixel_format.hpp"
+
+// Noisy test images for the benchmark and the auto-tuner
+namespace synthetic
+{
+    inline bool InBox(float a_u, float a_v)  { return a_u > 0.25f && a_u < 0.6f && a_v > 0.3f && a_v < 0.7f; }
+    inline bool InDisk(float a_u, float a_v) { return (a_u - 0.75f) * (a_u - 0.75f) + (a_v - 0.5f) * (a_v - 0.5f) < 0.02f; }
+
+    // Smooth gradients with a few hard edges, so that edge-preserving filters have something to preserve
+    inline std::vector<ComputeApplication::Pixel> MakeCleanImage(int a_w, int a_h)
+    {
+        std::vector<ComputeApplication::Pixel> image(a_w * a_h);
+
+        for (int y{}; y < a_h; ++y)
+        {
+            for (int x{}; x < a_w; ++x)
+            {
+                const float u{ float(x) / float(a_w) };
+                const float v{ float(y) / float(a_h) };
+                const bool  box{ InBox(u, v) };
+                const bool  disk{ InDisk(u, v) };
+
+                ComputeApplication::Pixel& p{ image[y * a_w + x] };
+                p.r = (box) ? 0.9f : (disk) ? 0.1f : 0.2f + 0.6f * u;
+                p.g = (box) ? 0.3f : (disk) ? 0.8f : 0.2f + 0.6f * v;
+                p.b = (box) ? 0.2f : (disk) ? 0.7f : 0.5f;
+                p.a = 1.0f;
+            }
+        }
+
+        return image;
+    }
+
+    // the left a_converged part of the image stays noise-free, like converged regions of a render
+    inline std::vector<ComputeApplication::Pixel> AddNoise(const std::vector<ComputeApplication::Pixel>& a_image, int a_w, float a_sigma,
+            float a_converged, std::mt19937& a_gen)
+    {
+        std::normal_distribution<float> noise{0.0f, a_sigma};
+        std::vector<ComputeApplication::Pixel> noisy(a_image);
+
+        for (size_t i{}; i < noisy.size(); ++i)
+        {
+            if (float(i % a_w) < a_converged * float(a_w)) continue;
+
+            ComputeApplication::Pixel& p{ noisy[i] };
+            p.r = std::clamp(p.r + noise(a_gen), 0.0f, 1.0f);
+            p.g = std::clamp(p.g + noise(a_gen), 0.0f, 1.0f);
+            p.b = std::clamp(p.b + noise(a_gen), 0.0f, 1.0f);
+        }
+
+        return noisy;
+    }
+
+    inline std::vector<unsigned int> PackRGBA8(const std::vector<ComputeApplication::Pixel>& a_image)
+    {
+        std::vector<unsigned int> packed(a_image.size());
+        pixel_format::Rgba32FToRgba8((const float*)a_image.data(), (uint8_t*)packed.data(), a_image.size());
+
+        return packed;
+    }
+
+    // Depth in the red channel and normals encoded to [0, 1] for the same scene: a tilted floor, a box facing the camera
+    // and a hemisphere, in the layout atrous.comp expects
+    inline void MakeGeometry(int a_w, int a_h, std::vector<ComputeApplication::Pixel>& a_depth, std::vector<ComputeApplication::Pixel>& a_normal)
+    {
+        a_depth.assign(a_w * a_h, ComputeApplication::Pixel{});
+        a_normal.assign(a_w * a_h, ComputeApplication::Pixel{});
+
+        for (int y{}; y < a_h; ++y)
+        {
+            for (int x{}; x < a_w; ++x)
+            {
+                const float u{ float(x) / float(a_w) };
+                const float v{ float(y) / float(a_h) };
+
+                float depth{ 0.9f - 0.4f * v };
+                float nx{ 0.0f }, ny{ 0.7071f }, nz{ 0.7071f };
+
+                if (InBox(u, v))
+                {
+                    depth = 0.3f;
+                    ny    = 0.0f;
+                    nz    = 1.0f;
+                }
+                else if (InDisk(u, v))
+                {
+                    nx    = (u - 0.75f) / 0.1415f;
+                    ny    = (v - 0.5f) / 0.1415f;
+                    nz    = std::sqrt(std::max(0.0f, 1.0f - nx * nx - ny * ny));
+                    depth = 0.5f - 0.1f * nz;
+                }
+
+                a_depth[y * a_w + x]  = { depth, depth, depth, 1.0f };
+                a_normal[y * a_w + x] = { nx * 0.5f + 0.5f, ny * 0.5f + 0.5f, nz * 0.5f + 0.5f, 1.0f };
+            }
+        }
+    }
+
+    // a_frames noisy copies of one clean image with albedo, depth and normal guide layers named the way LoadScene names
+    // them, so that the layered and the a-trous kernels run the same way as on a rendered scene
+    inline ComputeApplication::SourceFrames MakeSourceFrames(int a_w, int a_h, int a_frames, float a_noise, unsigned a_seed, bool a_ldr,
+            float a_converged = 0.0f)
+    {
+        std::mt19937 gen{a_seed};
+        const std::vector<ComputeApplication::Pixel> clean{ MakeCleanImage(a_w, a_h) };
+
+        ComputeApplication::SourceFrames frames{};
+        frames.w     = a_w;
+        frames.h     = a_h;
+        frames.isHDR = !a_ldr;
+
+        for (int i{}; i < a_frames; ++i)
+        {
+            if (a_ldr) frames.imageData.push_back(PackRGBA8(AddNoise(clean, a_w, a_noise, a_converged, gen)));
+            else       frames.imageDataHDR.push_back(AddNoise(clean, a_w, a_noise, a_converged, gen));
+        }
+
+        std::vector<ComputeApplication::Pixel> depth{}, normal{};
+        MakeGeometry(a_w, a_h, depth, normal);
+
+        frames.layerData  = { PackRGBA8(clean), PackRGBA8(depth), PackRGBA8(normal) };
+        frames.layerNames = { "albedo.png", "depth.png", "normal.png" };
+
+        return frames;
+    }
+}
+
+#endif // SYNTHETIC_HPP
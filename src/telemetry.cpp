@@ -0,0 +1,125 @@
+#include "telemetry.hpp"
+
+#include <mutex>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+#include <unistd.h>
+
+namespace telemetry
+{
+    static std::atomic<int> g_mode{ MODE_AUTO };
+    static std::atomic<int> g_active{};   // 1 while the outermost Progress lives
+    static std::mutex       g_outputMutex{};
+
+    void SetMode(Mode a_mode)
+    {
+        g_mode.store(a_mode, std::memory_order_relaxed);
+    }
+
+    Mode GetMode()
+    {
+        const Mode mode{ Mode(g_mode.load(std::memory_order_relaxed)) };
+        if (mode != MODE_AUTO)
+        {
+            return mode;
+        }
+
+        return (isatty(fileno(stdout))) ? MODE_BAR : MODE_JSON;
+    }
+
+    bool ParseMode(const std::string& a_name, Mode& a_mode)
+    {
+        if      (a_name == "auto") a_mode = MODE_AUTO;
+        else if (a_name == "bar")  a_mode = MODE_BAR;
+        else if (a_name == "json") a_mode = MODE_JSON;
+        else if (a_name == "off")  a_mode = MODE_OFF;
+        else return false;
+
+        return true;
+    }
+
+    Progress::Progress(const char* a_task, size_t a_total, const char* a_unit, bool a_report)
+        : m_task(a_task), m_unit(a_unit), m_total(a_total), m_mode(GetMode()), m_out(std::cout.rdbuf()), m_start(Clock::now())
+    {
+        if (!a_report || m_mode == MODE_OFF || m_out == nullptr || m_total == 0)
+        {
+            return;
+        }
+
+        int free{};
+        m_enabled = g_active.compare_exchange_strong(free, 1);
+
+        m_stride = std::max<size_t>(1, m_total / 256);
+        m_nextCheck.store(m_stride, std::memory_order_relaxed);
+        m_nextReport.store((m_start + REPORT_INTERVAL).time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    Progress::~Progress()
+    {
+        Finish();
+    }
+
+    void Progress::Finish()
+    {
+        if (!m_enabled || m_finished)
+        {
+            return;
+        }
+
+        m_finished = true;
+        m_enabled  = false;
+
+        Write(true, m_done.load(std::memory_order_relaxed), std::chrono::duration<double>(Clock::now() - m_start).count());
+        g_active.store(0);
+    }
+
+    void Progress::Report(size_t a_done)
+    {
+        // one thread reports, the others go on counting
+        if (m_reporting.test_and_set(std::memory_order_acquire))
+        {
+            return;
+        }
+
+        const Clock::time_point now{ Clock::now() };
+        m_nextCheck.store(a_done + m_stride, std::memory_order_relaxed);
+
+        if (now.time_since_epoch().count() >= m_nextReport.load(std::memory_order_relaxed))
+        {
+            m_nextReport.store((now + REPORT_INTERVAL).time_since_epoch().count(), std::memory_order_relaxed);
+            Write(false, a_done, std::chrono::duration<double>(now - m_start).count());
+        }
+
+        m_reporting.clear(std::memory_order_release);
+    }
+
+    void Progress::Write(bool a_finish, size_t a_done, double a_elapsed)
+    {
+        a_done = std::min(a_done, m_total);
+
+        char line[256]{};
+        int  length{};
+
+        if (m_mode == MODE_JSON)
+        {
+            length = snprintf(line, sizeof(line), "{\"event\":\"%s\",\"task\":\"%s\",\"done\":%zu,\"total\":%zu,\"elapsed\":%.3f}\n",
+                    (a_finish) ? "finish" : "progress", m_task, a_done, m_total, a_elapsed);
+        }
+        else
+        {
+            constexpr int width{30};
+            const int     filled{ int(width * a_done / m_total) };
+            char          bar[width + 1]{};
+
+            for (int i{}; i < width; ++i) bar[i] = (i < filled) ? '#' : ' ';
+
+            length = snprintf(line, sizeof(line), "\r\t%s [%s] %3d%% %zu/%zu %s %.1f s%s", m_task, bar, int(100 * a_done / m_total),
+                    a_done, m_total, m_unit, a_elapsed, (a_finish) ? "\n" : "");
+        }
+
+        std::lock_guard<std::mutex> lock(g_outputMutex);
+        m_out->sputn(line, std::min<int>(length, int(sizeof(line)) - 1));
+        m_out->pubsync();
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+#include <string>
+
+// Progress of long loops (rows, tiles, bands, frames) instead of a progress bar per pixel. A loop makes one Progress
+// and calls Advance once per unit of work, from any thread. Reports are rate limited: the clock is only read when the
+// count crosses a stride (about 1/256 of the total) and a report goes out at most every REPORT_INTERVAL.
+//
+// On a terminal the report is a bar redrawn in place, otherwise one JSON object per line:
+//     {"event":"progress","task":"tiles","done":12,"total":48,"elapsed":0.812}
+//     {"event":"finish","task":"tiles","done":48,"total":48,"elapsed":3.104}
+// Reports go to std::cout as it was when the Progress was made; a quiet engine (ComputeApplication::SetVerbose) makes
+// its Progress with a_report false. Only the outermost Progress of the process reports, nested ones are silent.
+// A silent Progress costs one branch per Advance.
+namespace telemetry
+{
+    enum Mode
+    {
+        MODE_AUTO, // bar on a terminal, JSON lines otherwise
+        MODE_BAR,
+        MODE_JSON,
+        MODE_OFF,
+    };
+
+    void SetMode(Mode a_mode);
+    Mode GetMode(); // never MODE_AUTO, resolved by stdout
+
+    // "auto", "bar", "json" or "off"; false if a_name is none of them
+    bool ParseMode(const std::string& a_name, Mode& a_mode);
+
+    class Progress
+    {
+        public:
+
+            static constexpr std::chrono::milliseconds REPORT_INTERVAL{200};
+
+            // a_task and a_unit are kept as pointers, pass literals; a_report false - silent
+            Progress(const char* a_task, size_t a_total, const char* a_unit = "", bool a_report = true);
+            ~Progress(); // finishes if Finish was not called
+
+            Progress(const Progress&) = delete;
+            Progress& operator=(const Progress&) = delete;
+
+            void Advance(size_t a_count = 1)
+            {
+                if (!m_enabled)
+                {
+                    return;
+                }
+
+                const size_t done{ m_done.fetch_add(a_count, std::memory_order_relaxed) + a_count };
+                if (done >= m_nextCheck.load(std::memory_order_relaxed))
+                {
+                    Report(done);
+                }
+            }
+
+            void Finish();
+
+        private:
+
+            using Clock = std::chrono::steady_clock;
+
+            void Report(size_t a_done);
+            void Write(bool a_finish, size_t a_done, double a_elapsed);
+
+            const char*       m_task{};
+            const char*       m_unit{};
+            size_t            m_total{};
+            size_t            m_stride{};
+            bool              m_enabled{};
+            Mode              m_mode{};
+            std::streambuf*   m_out{};
+            Clock::time_point m_start{};
+
+            std::atomic<size_t>  m_done{};
+            std::atomic<size_t>  m_nextCheck{};
+            std::atomic<int64_t> m_nextReport{}; // Clock ticks
+            std::atomic_flag     m_reporting = ATOMIC_FLAG_INIT;
+            bool                 m_finished{};
+    };
+}
+
+#endif // TELEMETRY_HPP
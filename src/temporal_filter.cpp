@@ -0,0 +1,439 @@
+#include "temporal_filter.hpp"
+#include "telemetry.hpp"
+#include "pixel_format.hpp"
+
+#include <cmath>
+#include <cctype>
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+// Push constants of temporal.comp, both passes
+struct TemporalParams {
+    int   width{}, height{};
+    int   flags{};
+    float alpha{};
+    float depthTolerance{};
+    float normalTolerance{};
+    float spatialSigma{};
+    float colorSigma{};
+};
+
+// PNG or EXR as floats, false if the file can't be read
+static bool LoadPixels(const std::string& a_fileName, int& a_w, int& a_h, bool& a_isHDR, std::vector<TemporalFilter::Pixel>& a_pixels)
+{
+    std::vector<std::vector<unsigned int>>          imageData{};
+    std::vector<std::vector<TemporalFilter::Pixel>> imageDataHDR{};
+
+    a_isHDR = fs::path(a_fileName).extension() == ".exr";
+
+    try
+    {
+        ComputeApplication::LoadImages(a_w, a_h, { a_fileName }, imageData, imageDataHDR, a_isHDR);
+    }
+    catch (const std::runtime_error&)
+    {
+        return false;
+    }
+
+    if (a_isHDR)
+    {
+        if (imageDataHDR.empty()) return false;
+        a_pixels = std::move(imageDataHDR[0]);
+        return true;
+    }
+
+    if (imageData.empty()) return false;
+
+    a_pixels.resize(imageData[0].size());
+    pixel_format::Rgba8ToRgba32F((const uint8_t*)imageData[0].data(), (float*)a_pixels.data(), a_pixels.size());
+    return true;
+}
+
+TemporalFilter::TemporalFilter(const Options& a_options) : m_options(a_options)
+{
+    m_device = ComputeApplication::CreateSharedDevice(m_options.deviceId, false);
+}
+
+TemporalFilter::~TemporalFilter()
+{
+    ReleaseResources();
+}
+
+TemporalFilter::Frame TemporalFilter::LoadFrame(const std::string& a_imageSource) const
+{
+    Frame frame{};
+
+    if (!LoadPixels(a_imageSource, frame.w, frame.h, frame.isHDR, frame.color))
+    {
+        RUN_TIME_ERROR(("can't load " + a_imageSource).c_str());
+    }
+
+    // render elements of the frame: files with its number in the subdirectories, as LoadSourceFrames finds layers
+    const fs::path    source{ a_imageSource };
+    const std::string stem{ source.stem().string() };
+    const std::string imageID{ stem.substr(stem.size() - std::min<size_t>(stem.size(), 4)) };
+    const fs::path    parentDir{ (source.has_parent_path()) ? source.parent_path() : fs::path(".") };
+    const size_t      pixels{ size_t(frame.w) * frame.h };
+
+    for (const auto& dir : fs::directory_iterator(parentDir))
+    {
+        if (!dir.is_directory()) continue;
+
+        for (const auto& file : fs::directory_iterator(dir.path()))
+        {
+            std::string name{ file.path().filename().string() };
+            if (name.find(imageID) == std::string::npos) continue;
+
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+
+            const bool motion{ name.find("velocity") != std::string::npos || name.find("motion") != std::string::npos };
+            const bool depth { name.find("depth") != std::string::npos };
+            const bool normal{ name.find("normal") != std::string::npos };
+
+            if (!motion && !depth && !normal) continue;
+
+            int  w{}, h{};
+            bool isHDR{};
+            std::vector<Pixel> element{};
+
+            if (!LoadPixels(file.path().string(), w, h, isHDR, element) || w != frame.w || h != frame.h)
+            {
+                std::cout << "skipping render element " << file.path().string() << "\n";
+                continue;
+            }
+
+            if (motion)
+            {
+                // LDR velocity is stored as 0.5 + v / (2 * max velocity)
+                const float scale{ (isHDR) ? 1.0f : 2.0f * m_options.velocityScale };
+                const float bias { (isHDR) ? 0.0f : 0.5f };
+
+                frame.motion.resize(2 * pixels);
+                for (size_t i{}; i < pixels; ++i)
+                {
+                    frame.motion[2 * i + 0] = (element[i].r - bias) * scale;
+                    frame.motion[2 * i + 1] = (element[i].g - bias) * scale;
+                }
+            }
+            else if (depth)
+            {
+                frame.depth.resize(pixels);
+                for (size_t i{}; i < pixels; ++i)
+                {
+                    frame.depth[i] = element[i].r;
+                }
+            }
+            else
+            {
+                frame.normal.resize(3 * pixels);
+                for (size_t i{}; i < pixels; ++i)
+                {
+                    float n[3]{ element[i].r, element[i].g, element[i].b };
+
+                    if (!isHDR)
+                    {
+                        for (float& c : n) c = c * 2.0f - 1.0f;
+                    }
+
+                    // 8 bits per channel leave the normals a bit off the unit sphere, the shader compares cosines
+                    const float length{ std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) };
+                    const float invLength{ (length > 0.0f) ? 1.0f / length : 0.0f };
+
+                    for (int c{}; c < 3; ++c)
+                    {
+                        frame.normal[3 * i + c] = n[c] * invLength;
+                    }
+                }
+            }
+        }
+    }
+
+    return frame;
+}
+
+void TemporalFilter::Filter(const Frame& a_frame, std::vector<Pixel>& a_result)
+{
+    if (a_frame.w != m_w || a_frame.h != m_h)
+    {
+        ReleaseResources();
+        CreateResources(a_frame.w, a_frame.h);
+        m_historyValid = false;
+    }
+
+    const VkDevice device{ m_device->device };
+    const size_t   pixels{ size_t(m_w) * m_h };
+
+    int flags{ (m_historyValid) ? FLAG_HISTORY : 0 };
+    flags |= (a_frame.motion.size() == 2 * pixels) ? FLAG_MOTION : 0;
+    flags |= (a_frame.depth.size()  == pixels)     ? FLAG_DEPTH  : 0;
+    flags |= (a_frame.normal.size() == 3 * pixels) ? FLAG_NORMAL : 0;
+
+    FramePixel* mappedMemory{};
+    VK_CHECK_RESULT(vkMapMemory(device, m_bufferMemoryFrame, 0, pixels * sizeof(FramePixel), 0, (void**)&mappedMemory));
+
+    for (size_t i{}; i < pixels; ++i)
+    {
+        FramePixel& pixel{ mappedMemory[i] };
+        const Pixel& color{ a_frame.color[i] };
+
+        pixel.color[0] = color.r;
+        pixel.color[1] = color.g;
+        pixel.color[2] = color.b;
+        pixel.color[3] = color.a;
+
+        pixel.motionDepth[0] = (flags & FLAG_MOTION) ? a_frame.motion[2 * i + 0] : 0.0f;
+        pixel.motionDepth[1] = (flags & FLAG_MOTION) ? a_frame.motion[2 * i + 1] : 0.0f;
+        pixel.motionDepth[2] = (flags & FLAG_DEPTH)  ? a_frame.depth[i] : 0.0f;
+        pixel.motionDepth[3] = 0.0f;
+
+        for (int c{}; c < 3; ++c)
+        {
+            pixel.normal[c] = (flags & FLAG_NORMAL) ? a_frame.normal[3 * i + c] : 0.0f;
+        }
+        pixel.normal[3] = 0.0f;
+    }
+
+    vkUnmapMemory(device, m_bufferMemoryFrame);
+
+    RecordCommands(flags);
+
+    {
+        QueueScheduler::Turn turn{ m_device->scheduler, QueueScheduler::PRIORITY_BATCH };
+        ComputeApplication::RunCommandBuffer(m_commandBuffer, m_device->queue, device, m_queryPool,
+                m_execTimeElapsed, m_transferTimeElapsed);
+    }
+
+    a_result.resize(pixels);
+    ComputeApplication::GetImageFromGPU(device, m_bufferMemoryStaging, m_w, m_h, a_result.data());
+
+    // the result is the history of the next frame
+    m_current      = 1 - m_current;
+    m_historyValid = true;
+}
+
+void TemporalFilter::RunSequence(const std::vector<std::string>& a_frames)
+{
+    std::vector<Pixel> result{};
+    telemetry::Progress progress{ "frames", a_frames.size(), "frames" };
+
+    for (const std::string& frameName : a_frames)
+    {
+        const Frame frame{ LoadFrame(frameName) };
+
+        std::cout << frameName << ":"
+            << ((frame.motion.empty()) ? "" : " velocity")
+            << ((frame.depth.empty())  ? "" : " depth")
+            << ((frame.normal.empty()) ? "" : " normal") << "\n";
+
+        Filter(frame, result);
+
+        const fs::path source{ frameName };
+        ComputeApplication::SaveImage("output-" + source.stem().string() + ((frame.isHDR) ? ".exr" : ".png"),
+                result, frame.w, frame.h, frame.isHDR);
+        progress.Advance();
+    }
+}
+
+void TemporalFilter::CreateResources(int a_w, int a_h)
+{
+    const VkDevice         device{ m_device->device };
+    const VkPhysicalDevice physDevice{ m_device->physicalDevice };
+    const size_t           pixels{ size_t(a_w) * a_h };
+
+    m_w       = a_w;
+    m_h       = a_h;
+    m_current = 0;
+
+    // the frame is read once per pixel, the shader takes it straight from host visible memory
+    ComputeApplication::CreateStagingBuffer(device, physDevice, pixels * sizeof(FramePixel), &m_bufferFrame, &m_bufferMemoryFrame);
+
+    for (int i{}; i < 2; ++i)
+    {
+        ComputeApplication::CreateWriteOnlyBuffer(device, physDevice, pixels * HISTORY_PIXEL_SIZE, &m_bufferHistory[i], &m_bufferMemoryHistory[i]);
+    }
+
+    ComputeApplication::CreateWriteOnlyBuffer(device, physDevice, pixels * sizeof(Pixel), &m_bufferOutput, &m_bufferMemoryOutput);
+    ComputeApplication::CreateStagingBuffer(device, physDevice, pixels * sizeof(Pixel), &m_bufferStaging, &m_bufferMemoryStaging);
+
+    // binding 0 - frame, 1 - read (history or blended frame), 2 - written (blended frame or result)
+    VkDescriptorSetLayoutBinding descriptorSetLayoutBindings[3]{};
+    for (uint32_t i{}; i < 3; ++i)
+    {
+        descriptorSetLayoutBindings[i].binding         = i;
+        descriptorSetLayoutBindings[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        descriptorSetLayoutBindings[i].descriptorCount = 1;
+        descriptorSetLayoutBindings[i].stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo{};
+    descriptorSetLayoutCreateInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    descriptorSetLayoutCreateInfo.bindingCount = 3;
+    descriptorSetLayoutCreateInfo.pBindings    = descriptorSetLayoutBindings;
+
+    VK_CHECK_RESULT(vkCreateDescriptorSetLayout(device, &descriptorSetLayoutCreateInfo, NULL, &m_descriptorSetLayout));
+
+    VkDescriptorPoolSize descriptorPoolSize{};
+    descriptorPoolSize.type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSize.descriptorCount = 4 * 3;
+
+    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+    descriptorPoolCreateInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    descriptorPoolCreateInfo.maxSets       = 4;
+    descriptorPoolCreateInfo.poolSizeCount = 1;
+    descriptorPoolCreateInfo.pPoolSizes    = &descriptorPoolSize;
+
+    VK_CHECK_RESULT(vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, NULL, &m_descriptorPool));
+
+    for (int current{}; current < 2; ++current)
+    {
+        const VkBuffer temporalBuffers[3]{ m_bufferFrame, m_bufferHistory[current], m_bufferHistory[1 - current] };
+        const VkBuffer spatialBuffers[3] { m_bufferFrame, m_bufferHistory[1 - current], m_bufferOutput };
+        const size_t   temporalSizes[3]  { pixels * sizeof(FramePixel), pixels * HISTORY_PIXEL_SIZE, pixels * HISTORY_PIXEL_SIZE };
+        const size_t   spatialSizes[3]   { pixels * sizeof(FramePixel), pixels * HISTORY_PIXEL_SIZE, pixels * sizeof(Pixel) };
+
+        VkDescriptorSet* sets[2]{ &m_descriptorSetTemporal[current], &m_descriptorSetSpatial[current] };
+
+        for (int pass{}; pass < 2; ++pass)
+        {
+            VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+            descriptorSetAllocateInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+            descriptorSetAllocateInfo.descriptorPool     = m_descriptorPool;
+            descriptorSetAllocateInfo.descriptorSetCount = 1;
+            descriptorSetAllocateInfo.pSetLayouts        = &m_descriptorSetLayout;
+
+            VK_CHECK_RESULT(vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, sets[pass]));
+
+            VkDescriptorBufferInfo descriptorBufferInfos[3]{};
+            VkWriteDescriptorSet   writeDescriptorSets[3]{};
+
+            for (uint32_t i{}; i < 3; ++i)
+            {
+                descriptorBufferInfos[i].buffer = (pass == 0) ? temporalBuffers[i] : spatialBuffers[i];
+                descriptorBufferInfos[i].offset = 0;
+                descriptorBufferInfos[i].range  = (pass == 0) ? temporalSizes[i] : spatialSizes[i];
+
+                writeDescriptorSets[i].sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDescriptorSets[i].dstSet          = *sets[pass];
+                writeDescriptorSets[i].dstBinding      = i;
+                writeDescriptorSets[i].descriptorCount = 1;
+                writeDescriptorSets[i].descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writeDescriptorSets[i].pBufferInfo     = &descriptorBufferInfos[i];
+            }
+
+            vkUpdateDescriptorSets(device, 3, writeDescriptorSets, 0, NULL);
+        }
+    }
+
+    ComputeApplication::CreateComputePipelines(device, m_descriptorSetLayout, &m_temporalShaderModule, &m_temporalPipeline,
+            &m_temporalPipelineLayout, "shaders/temporal.spv", sizeof(TemporalParams), m_options.workgroupSize);
+    ComputeApplication::CreateComputePipelines(device, m_descriptorSetLayout, &m_spatialShaderModule, &m_spatialPipeline,
+            &m_spatialPipelineLayout, "shaders/temporal_spatial.spv", sizeof(TemporalParams), m_options.workgroupSize);
+
+    ComputeApplication::CreateCommandBuffer(device, m_device->queueFamilyIndex, m_temporalPipeline, m_temporalPipelineLayout,
+            &m_commandPool, &m_commandBuffer);
+    ComputeApplication::CreateQueryPool(device, &m_queryPool);
+}
+
+void TemporalFilter::ReleaseResources()
+{
+    const VkDevice device{ (m_device) ? m_device->device : VK_NULL_HANDLE };
+
+    if (device == VK_NULL_HANDLE || m_bufferFrame == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    VkBuffer       buffers[5] { m_bufferFrame, m_bufferHistory[0], m_bufferHistory[1], m_bufferOutput, m_bufferStaging };
+    VkDeviceMemory memories[5]{ m_bufferMemoryFrame, m_bufferMemoryHistory[0], m_bufferMemoryHistory[1], m_bufferMemoryOutput, m_bufferMemoryStaging };
+
+    for (int i{}; i < 5; ++i)
+    {
+        vkFreeMemory   (device, memories[i], NULL);
+        vkDestroyBuffer(device, buffers[i], NULL);
+    }
+
+    vkDestroyQueryPool(device, m_queryPool, NULL);
+    vkFreeCommandBuffers(device, m_commandPool, 1, &m_commandBuffer);
+    vkDestroyCommandPool(device, m_commandPool, NULL);
+
+    vkDestroyPipeline      (device, m_temporalPipeline, NULL);
+    vkDestroyPipelineLayout(device, m_temporalPipelineLayout, NULL);
+    vkDestroyShaderModule  (device, m_temporalShaderModule, NULL);
+    vkDestroyPipeline      (device, m_spatialPipeline, NULL);
+    vkDestroyPipelineLayout(device, m_spatialPipelineLayout, NULL);
+    vkDestroyShaderModule  (device, m_spatialShaderModule, NULL);
+
+    vkDestroyDescriptorPool     (device, m_descriptorPool, NULL);
+    vkDestroyDescriptorSetLayout(device, m_descriptorSetLayout, NULL);
+
+    m_bufferFrame = m_bufferHistory[0] = m_bufferHistory[1] = m_bufferOutput = m_bufferStaging = VK_NULL_HANDLE;
+    m_bufferMemoryFrame = m_bufferMemoryHistory[0] = m_bufferMemoryHistory[1] = m_bufferMemoryOutput = m_bufferMemoryStaging = VK_NULL_HANDLE;
+    m_w = m_h = 0;
+}
+
+void TemporalFilter::RecordCommands(int a_flags)
+{
+    const VkCommandBuffer cmdBuff{ m_commandBuffer };
+
+    TemporalParams params{};
+    params.width           = m_w;
+    params.height          = m_h;
+    params.flags           = a_flags;
+    params.alpha           = m_options.alpha;
+    params.depthTolerance  = m_options.depthTolerance;
+    params.normalTolerance = m_options.normalTolerance;
+    params.spatialSigma    = m_options.filterParams.spatialSigma;
+    params.colorSigma      = m_options.filterParams.colorSigma;
+
+    const ComputeApplication::WorkgroupSize& wg{ m_options.workgroupSize };
+    const uint32_t groupsX{ uint32_t((m_w + wg.x - 1) / wg.x) };
+    const uint32_t groupsY{ uint32_t((m_h + wg.y - 1) / wg.y) };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHECK_RESULT(vkBeginCommandBuffer(cmdBuff, &beginInfo));
+
+#ifdef QUERY_TIME
+    vkCmdResetQueryPool(cmdBuff, m_queryPool, 0, 3);
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, 0);
+#endif
+
+    // history written by the previous frame
+    VkMemoryBarrier memBarr{};
+    memBarr.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memBarr.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    memBarr.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            1, &memBarr, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline      (cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, m_temporalPipeline);
+    vkCmdBindDescriptorSets(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, m_temporalPipelineLayout, 0, 1, &m_descriptorSetTemporal[m_current], 0, NULL);
+    vkCmdPushConstants     (cmdBuff, m_temporalPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(TemporalParams), &params);
+    vkCmdDispatch          (cmdBuff, groupsX, groupsY, 1);
+
+    // blended frame -> spatial pass
+    vkCmdPipelineBarrier(cmdBuff, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            1, &memBarr, 0, nullptr, 0, nullptr);
+
+    vkCmdBindPipeline      (cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, m_spatialPipeline);
+    vkCmdBindDescriptorSets(cmdBuff, VK_PIPELINE_BIND_POINT_COMPUTE, m_spatialPipelineLayout, 0, 1, &m_descriptorSetSpatial[m_current], 0, NULL);
+    vkCmdPushConstants     (cmdBuff, m_spatialPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(TemporalParams), &params);
+    vkCmdDispatch          (cmdBuff, groupsX, groupsY, 1);
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_TRANSFER_BIT, m_queryPool, 1);
+#endif
+
+    ComputeApplication::RecordTransferToHost(cmdBuff, m_bufferOutput, m_bufferStaging, size_t(m_w) * m_h * sizeof(Pixel));
+
+#ifdef QUERY_TIME
+    vkCmdWriteTimestamp(cmdBuff, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 2);
+#endif
+
+    VK_CHECK_RESULT(vkEndCommandBuffer(cmdBuff));
+}
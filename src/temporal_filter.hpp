@@ -0,0 +1,119 @@
+#ifndef TEMPORAL_FILTER_HPP
+#define TEMPORAL_FILTER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "compute_application.hpp"
+
+// Recursive temporal denoising of a sequence (`--temporal`). The multiframe NLM mode compares every pixel with the
+// neighbour frames, O(frames * window^2 * patch^2); here a history buffer stays on the GPU from frame to frame instead.
+// temporal.comp reprojects it with the motion vectors of the frame (bilinear), drops history samples whose depth or
+// normal differ from the current pixel (disocclusions) and blends the rest with the frame as an exponential moving
+// average; a 5x5 bilateral pass (temporal_spatial.spv) then cleans what the history could not, stronger where the
+// history is short. The work per frame does not depend on how many frames the history holds.
+//
+// Render elements are found like the layers of `--layers` (files in the subdirectories of the frame directory whose
+// name contains the frame number) and told apart by name: "velocity"/"motion", "depth", "normal". Without motion vectors
+// the camera is taken as static, without depth and normals only the history that left the frame is dropped.
+class TemporalFilter
+{
+    public:
+
+        using Pixel = ComputeApplication::Pixel;
+
+        struct Options {
+            int   deviceId{};
+            float alpha{0.2f};            // smallest weight of the new frame (0.2 ~ the last 10 frames)
+            float depthTolerance{0.05f};  // largest relative depth difference of a reused history sample
+            float normalTolerance{0.9f};  // smallest cosine between the normals of a reused history sample
+            float velocityScale{1.0f};    // pixels of an LDR velocity element at full intensity ("max velocity")
+            ComputeApplication::FilterParams  filterParams{}; // spatial pass
+            ComputeApplication::WorkgroupSize workgroupSize{};
+        };
+
+        // A frame with the render elements the filter uses, an empty vector - the element is missing
+        struct Frame {
+            int  w{}, h{};
+            bool isHDR{};
+            std::vector<Pixel> color{};
+            std::vector<float> motion{}; // 2 per pixel, pixels the point moved since the previous frame (x right, y down)
+            std::vector<float> depth{};
+            std::vector<float> normal{}; // 3 per pixel
+        };
+
+        explicit TemporalFilter(const Options& a_options);
+        ~TemporalFilter();
+
+        TemporalFilter(const TemporalFilter&) = delete;
+        TemporalFilter& operator=(const TemporalFilter&) = delete;
+
+        // Color and render elements of a_imageSource; LDR velocity and normals are decoded from [0, 1] to [-1, 1]
+        Frame LoadFrame(const std::string& a_imageSource) const;
+
+        // Next frame of the sequence, a_result gets w * h pixels. The history restarts when the size changes.
+        void Filter(const Frame& a_frame, std::vector<Pixel>& a_result);
+
+        // Frames in this order, results are saved to output-<frame name>.png/exr
+        void RunSequence(const std::vector<std::string>& a_frames);
+
+        // The next frame starts a new history (scene cut)
+        void Reset() { m_historyValid = false; }
+
+        std::string GetDeviceName()         const { return m_device->deviceName; }
+        uint64_t    GetExecTimeElapsed()    const { return uint64_t(double(m_execTimeElapsed) * m_device->timestampPeriod); }
+        uint64_t    GetTranferTimeElapsed() const { return uint64_t(double(m_transferTimeElapsed) * m_device->timestampPeriod); }
+
+    private:
+
+        // Interleaved input of temporal.comp (FramePixel)
+        struct FramePixel {
+            float color[4];
+            float motionDepth[4];
+            float normal[4];
+        };
+
+        // HistoryPixel of temporal.comp: color, normal + depth, frames blended
+        static constexpr size_t HISTORY_PIXEL_SIZE = 12 * sizeof(float);
+
+        enum Flags
+        {
+            FLAG_HISTORY = 1,
+            FLAG_MOTION  = 2,
+            FLAG_DEPTH   = 4,
+            FLAG_NORMAL  = 8,
+        };
+
+        void CreateResources(int a_w, int a_h);
+        void ReleaseResources();
+        void RecordCommands(int a_flags);
+
+        Options m_options{};
+        std::shared_ptr<ComputeApplication::SharedDevice> m_device{};
+
+        int  m_w{}, m_h{};
+        int  m_current{};        // history buffer the next frame reads, the other one gets the result
+        bool m_historyValid{};
+
+        VkBuffer              m_bufferFrame{};      // FramePixel, written by the host
+        VkBuffer              m_bufferHistory[2]{}; // HistoryPixel, device local
+        VkBuffer              m_bufferOutput{};
+        VkBuffer              m_bufferStaging{};
+        VkDeviceMemory        m_bufferMemoryFrame{}, m_bufferMemoryHistory[2]{}, m_bufferMemoryOutput{}, m_bufferMemoryStaging{};
+        VkDescriptorSetLayout m_descriptorSetLayout{};
+        VkDescriptorPool      m_descriptorPool{};
+        VkDescriptorSet       m_descriptorSetTemporal[2]{}; // by m_current
+        VkDescriptorSet       m_descriptorSetSpatial[2]{};
+        VkShaderModule        m_temporalShaderModule{}, m_spatialShaderModule{};
+        VkPipeline            m_temporalPipeline{}, m_spatialPipeline{};
+        VkPipelineLayout      m_temporalPipelineLayout{}, m_spatialPipelineLayout{};
+        VkCommandPool         m_commandPool{};
+        VkCommandBuffer       m_commandBuffer{};
+        VkQueryPool           m_queryPool{};
+
+        uint64_t m_execTimeElapsed{};
+        uint64_t m_transferTimeElapsed{};
+};
+
+#endif // TEMPORAL_FILTER_HPP
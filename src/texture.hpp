@@ -27,7 +27,8 @@ class CustomVulkanTexture
         {
         }
 
-        void create(VkDevice a_device, VkPhysicalDevice a_physDevice, const int a_width, const int a_height, bool a_isHDR = false);
+        void create(VkDevice a_device, VkPhysicalDevice a_physDevice, const int a_width, const int a_height, bool a_isHDR = false,
+                    bool a_half = false); // a_half - RGBA16F texels instead of RGBA32F (HDR only)
         void release();
 };
 
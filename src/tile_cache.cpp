@@ -0,0 +1,214 @@
+#include "tile_cache.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+static constexpr uint32_t TILE_FILE_MAGIC = 0x43544456; // "VDTC"
+
+TileCache::TileCache(size_t a_maxBytes, const std::string& a_directory)
+    : m_maxBytes(a_maxBytes), m_directory(a_directory)
+{
+    if (m_directory.empty())
+    {
+        return;
+    }
+
+    std::error_code error{};
+    fs::create_directories(m_directory, error);
+
+    // files of the previous runs count against the bound, the oldest are evicted first
+    struct File {
+        fs::file_time_type time{};
+        DiskEntry          entry{};
+    };
+    std::vector<File> files{};
+
+    for (const auto& item : fs::directory_iterator(m_directory, error))
+    {
+        if (!item.is_regular_file() || item.path().extension() != ".tile") continue;
+
+        File file{};
+        file.entry.key   = std::strtoull(item.path().stem().string().c_str(), nullptr, 16);
+        file.entry.bytes = size_t(item.file_size(error));
+        file.time        = item.last_write_time(error);
+        files.push_back(file);
+    }
+
+    std::sort(files.begin(), files.end(), [](const File& a, const File& b) { return a.time < b.time; });
+
+    for (const File& file : files)
+    {
+        m_diskOrder.push_back(file.entry);
+        m_diskBytes += file.entry.bytes;
+    }
+}
+
+std::string TileCache::DefaultDirectory()
+{
+    if (const char* xdgCache = std::getenv("XDG_CACHE_HOME"))
+    {
+        return (fs::path(xdgCache) / "vulkan_denoice" / "tiles").string();
+    }
+
+    if (const char* home = std::getenv("HOME"))
+    {
+        return (fs::path(home) / ".cache" / "vulkan_denoice" / "tiles").string();
+    }
+
+    return "tiles";
+}
+
+uint64_t TileCache::Hash(const void* a_data, size_t a_size, uint64_t a_seed)
+{
+    const uint8_t* bytes{ (const uint8_t*)a_data };
+    uint64_t hash{ a_seed ^ (a_size * 0x9e3779b97f4a7c15ull) };
+    size_t   i{};
+
+    for (; i + sizeof(uint64_t) <= a_size; i += sizeof(uint64_t))
+    {
+        uint64_t word{};
+        memcpy(&word, bytes + i, sizeof(uint64_t));
+
+        hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+        hash ^= hash >> 32;
+    }
+
+    uint64_t tail{};
+    memcpy(&tail, bytes + i, a_size - i);
+
+    hash = (hash ^ tail) * 0xc4ceb9fe1a85ec53ull;
+    return hash ^ (hash >> 29);
+}
+
+std::string TileCache::FilePath(uint64_t a_key) const
+{
+    std::ostringstream name{};
+    name << std::hex << std::setw(16) << std::setfill('0') << a_key << ".tile";
+    return (fs::path(m_directory) / name.str()).string();
+}
+
+bool TileCache::LoadFile(uint64_t a_key, std::vector<uint8_t>& a_data, size_t a_bytes) const
+{
+    std::ifstream in{ FilePath(a_key), std::ios::binary };
+
+    uint32_t magic{};
+    uint64_t bytes{};
+    in.read((char*)&magic, sizeof(magic));
+    in.read((char*)&bytes, sizeof(bytes));
+
+    if (!in || magic != TILE_FILE_MAGIC || bytes != a_bytes)
+    {
+        return false;
+    }
+
+    a_data.resize(a_bytes);
+    in.read((char*)a_data.data(), std::streamsize(a_bytes));
+    return bool(in);
+}
+
+void TileCache::WriteFile(uint64_t a_key, const std::vector<uint8_t>& a_data)
+{
+    const std::string path{ FilePath(a_key) };
+    const std::string temporary{ path + ".tmp" };
+
+    {
+        std::ofstream out{ temporary, std::ios::binary };
+
+        const uint64_t bytes{ a_data.size() };
+        out.write((const char*)&TILE_FILE_MAGIC, sizeof(TILE_FILE_MAGIC));
+        out.write((const char*)&bytes, sizeof(bytes));
+        out.write((const char*)a_data.data(), std::streamsize(a_data.size()));
+
+        if (!out) return; // the cache is best effort, a full disk only costs hits
+    }
+
+    // other processes never see a half written tile
+    std::error_code error{};
+    fs::rename(temporary, path, error);
+    if (error) return;
+
+    DiskEntry entry{};
+    entry.key   = a_key;
+    entry.bytes = sizeof(TILE_FILE_MAGIC) + sizeof(uint64_t) + a_data.size();
+    m_diskOrder.push_back(entry);
+    m_diskBytes += entry.bytes;
+
+    while (m_diskBytes > m_maxBytes && !m_diskOrder.empty())
+    {
+        fs::remove(FilePath(m_diskOrder.front().key), error);
+        m_diskBytes -= m_diskOrder.front().bytes;
+        m_diskOrder.pop_front();
+    }
+}
+
+void TileCache::Insert(uint64_t a_key, std::vector<uint8_t> a_data)
+{
+    if (a_data.size() > m_maxBytes || m_entries.count(a_key) != 0)
+    {
+        return;
+    }
+
+    m_bytes += a_data.size();
+    m_order.push_front(a_key);
+
+    Entry& entry{ m_entries[a_key] };
+    entry.data     = std::move(a_data);
+    entry.position = m_order.begin();
+
+    while (m_bytes > m_maxBytes)
+    {
+        const auto oldest{ m_entries.find(m_order.back()) };
+        m_bytes -= oldest->second.data.size();
+        m_entries.erase(oldest);
+        m_order.pop_back();
+    }
+}
+
+bool TileCache::Lookup(uint64_t a_key, void* a_data, size_t a_bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto found{ m_entries.find(a_key) };
+
+    if (found == m_entries.end() && !m_directory.empty())
+    {
+        std::vector<uint8_t> data{};
+        if (LoadFile(a_key, data, a_bytes))
+        {
+            Insert(a_key, std::move(data));
+            found = m_entries.find(a_key);
+        }
+    }
+
+    if (found == m_entries.end() || found->second.data.size() != a_bytes)
+    {
+        ++m_misses;
+        return false;
+    }
+
+    m_order.splice(m_order.begin(), m_order, found->second.position);
+    memcpy(a_data, found->second.data.data(), a_bytes);
+    ++m_hits;
+    return true;
+}
+
+void TileCache::Store(uint64_t a_key, const void* a_data, size_t a_bytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<uint8_t> data((const uint8_t*)a_data, (const uint8_t*)a_data + a_bytes);
+
+    if (!m_directory.empty())
+    {
+        WriteFile(a_key, data);
+    }
+
+    Insert(a_key, std::move(data));
+}
@@ -0,0 +1,66 @@
+#ifndef TILE_CACHE_HPP
+#define TILE_CACHE_HPP
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <unordered_map>
+
+// Filtered tiles of the incremental mode (ComputeApplication::SetTileCache) keyed by a hash of everything the result
+// depends on: the padded input tile (apron included) of every frame and layer plus the filter configuration.
+// A tile that did not change since the previous run (or render) is copied from here instead of being dispatched.
+//
+// Tiles live in memory with an LRU bound in bytes. With a directory they are also written to <key>.tile files there,
+// so a re-render in another process hits too; the directory is held to the same bound, oldest files go first.
+class TileCache
+{
+    public:
+
+        explicit TileCache(size_t a_maxBytes, const std::string& a_directory = "");
+
+        // $XDG_CACHE_HOME/vulkan_denoice/tiles or ~/.cache/vulkan_denoice/tiles
+        static std::string DefaultDirectory();
+
+        // 64-bit hash of a_size bytes (not cryptographic), a_seed chains several buffers into one key
+        static uint64_t Hash(const void* a_data, size_t a_size, uint64_t a_seed);
+
+        // true - a_bytes of the tile were copied to a_data
+        bool Lookup(uint64_t a_key, void* a_data, size_t a_bytes);
+        void Store(uint64_t a_key, const void* a_data, size_t a_bytes);
+
+        uint64_t GetHits()   const { return m_hits; }
+        uint64_t GetMisses() const { return m_misses; }
+
+    private:
+
+        struct Entry {
+            std::vector<uint8_t>           data{};
+            std::list<uint64_t>::iterator  position{}; // in m_order
+        };
+
+        struct DiskEntry {
+            uint64_t key{};
+            size_t   bytes{};
+        };
+
+        std::string FilePath(uint64_t a_key) const;
+        bool LoadFile(uint64_t a_key, std::vector<uint8_t>& a_data, size_t a_bytes) const;
+        void WriteFile(uint64_t a_key, const std::vector<uint8_t>& a_data);
+        void Insert(uint64_t a_key, std::vector<uint8_t> a_data);
+
+        size_t      m_maxBytes{};
+        std::string m_directory{};  // empty - memory only
+
+        std::mutex                          m_mutex{};
+        std::unordered_map<uint64_t, Entry> m_entries{};
+        std::list<uint64_t>                 m_order{};     // most recently used first
+        size_t                              m_bytes{};
+        std::list<DiskEntry>                m_diskOrder{}; // oldest first
+        size_t                              m_diskBytes{};
+        uint64_t                            m_hits{}, m_misses{};
+};
+
+#endif // TILE_CACHE_HPP
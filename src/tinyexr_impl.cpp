@@ -0,0 +1,3 @@
+// tinyexr is a single header library, its implementation is compiled once here
+#define TINYEXR_IMPLEMENTATION
+#include "tinyexr/tinyexr.h"
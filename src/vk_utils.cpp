@@ -90,7 +90,7 @@ VkInstance vk_utils::CreateInstance(bool a_enableValidationLayers, std::vector<c
     applicationInfo.applicationVersion = 0;
     applicationInfo.pEngineName        = "awesomeengine";
     applicationInfo.engineVersion      = 0;
-    applicationInfo.apiVersion         = VK_API_VERSION_1_0;;
+    applicationInfo.apiVersion         = VK_API_VERSION_1_1; // external memory structures are core since 1.1
 
     VkInstanceCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -248,7 +248,40 @@ uint32_t vk_utils::GetComputeQueueFamilyIndex(VkPhysicalDevice physicalDevice)
 }
 
 
-VkDevice vk_utils::CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevice physicalDevice, const std::vector<const char *>& a_enabledLayers)
+std::vector<int> vk_utils::FindComputeDevices(VkInstance a_instance)
+{
+    uint32_t deviceCount{};
+    vkEnumeratePhysicalDevices(a_instance, &deviceCount, NULL);
+
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(a_instance, &deviceCount, devices.data());
+
+    std::vector<int> result;
+
+    for (uint32_t i = 0; i < deviceCount; ++i)
+    {
+        uint32_t queueFamilyCount;
+        vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &queueFamilyCount, NULL);
+
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(devices[i], &queueFamilyCount, queueFamilies.data());
+
+        for (const VkQueueFamilyProperties& props : queueFamilies)
+        {
+            if (props.queueCount > 0 && (props.queueFlags & VK_QUEUE_COMPUTE_BIT))
+            {
+                result.push_back(int(i));
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+
+VkDevice vk_utils::CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevice physicalDevice, const std::vector<const char *>& a_enabledLayers,
+        const std::vector<const char *>& a_enabledExtensions, const void* a_pNext)
 {
 
     /*
@@ -271,8 +304,11 @@ VkDevice vk_utils::CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevi
     VkPhysicalDeviceFeatures deviceFeatures = {};
 
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceCreateInfo.pNext = a_pNext; // feature structures of extensions (e.g. 16-bit storage), may be NULL
     deviceCreateInfo.enabledLayerCount    = a_enabledLayers.size();  // need to specify validation layers here as well.
     deviceCreateInfo.ppEnabledLayerNames  = a_enabledLayers.data();
+    deviceCreateInfo.enabledExtensionCount   = a_enabledExtensions.size();
+    deviceCreateInfo.ppEnabledExtensionNames = a_enabledExtensions.data();
     deviceCreateInfo.pQueueCreateInfos    = &queueCreateInfo; // when creating the logical device, we also specify what queues it has.
     deviceCreateInfo.queueCreateInfoCount = 1;
     deviceCreateInfo.pEnabledFeatures     = &deviceFeatures;
@@ -284,6 +320,24 @@ VkDevice vk_utils::CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevi
 }
 
 
+bool vk_utils::IsDeviceExtensionSupported(VkPhysicalDevice physicalDevice, const char* a_extensionName)
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, &extensionCount, NULL);
+
+    std::vector<VkExtensionProperties> extensionProperties(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, NULL, &extensionCount, extensionProperties.data());
+
+    for (const VkExtensionProperties& prop : extensionProperties)
+    {
+        if (strcmp(a_extensionName, prop.extensionName) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+
 uint32_t vk_utils::FindMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags properties, VkPhysicalDevice physicalDevice)
 {
     VkPhysicalDeviceMemoryProperties memoryProperties;
@@ -7,6 +7,7 @@
 
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <cassert>
 
 #include <stdexcept>
 #include <sstream>
@@ -37,9 +38,12 @@ namespace vk_utils
     void       InitDebugReportCallback(VkInstance a_instance, DebugReportCallbackFuncType a_callback, VkDebugReportCallbackEXT* a_debugReportCallback);
 
     VkPhysicalDevice FindPhysicalDevice(VkInstance a_instance, bool a_printInfo, int a_preferredDeviceId);
+    std::vector<int> FindComputeDevices(VkInstance a_instance); // ids (as in FindPhysicalDevice) of devices with a compute queue
 
     uint32_t GetComputeQueueFamilyIndex(VkPhysicalDevice physicalDevice);
-    VkDevice CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevice physicalDevice, const std::vector<const char *>& a_enabledLayers);
+    VkDevice CreateLogicalDevice(uint32_t queueFamilyIndex, VkPhysicalDevice physicalDevice, const std::vector<const char *>& a_enabledLayers,
+                                 const std::vector<const char *>& a_enabledExtensions = {}, const void* a_pNext = nullptr);
+    bool     IsDeviceExtensionSupported(VkPhysicalDevice physicalDevice, const char* a_extensionName);
     uint32_t FindMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags properties, VkPhysicalDevice physicalDevice);
 
     std::vector<uint32_t> ReadFile(const char* filename);